@@ -1,17 +1,23 @@
 #include "builder.hh"
 
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <unordered_set>
 
 #include "../codegen/cxx.hh"
+#include "../codegen/lanes.hh"
 #include "../codegen/ninja.hh"
+#include "../codegen/util.hh"
 #include "../ir/except.hh"
 #include "../platform/dvpi.hh"
+#include "cache.hh"
+#include "fingerprint.hh"
 #include "fmt/format.h"
 #include "marl/defer.h"
 #include "marl/scheduler.h"
 #include "marl/waitgroup.h"
+#include "slang/binding/SystemSubroutine.h"
 #include "slang/compilation/Compilation.h"
 #include "slang/symbols/ASTVisitor.h"
 #include "slang/syntax/AllSyntax.h"
@@ -177,6 +183,23 @@ void verify_dpi_functions(platform::DPILocator *dpi, const Module *module,
     }
 }
 
+class DumpVarsVisitor : public slang::ASTVisitor<DumpVarsVisitor, true, true> {
+public:
+    [[maybe_unused]] void handle(const slang::CallExpression &expr) {
+        if (expr.isSystemCall() && expr.getSubroutineName() == "$dumpvars") {
+            has_dumpvars = true;
+        }
+    }
+
+    bool has_dumpvars = false;
+};
+
+bool has_dumpvars(const Module *module) {
+    DumpVarsVisitor v;
+    module->def()->visit(v);
+    return v.has_dumpvars;
+}
+
 void verify_vpi_functions(platform::VPILocator *vpi, BuildOptions &options) {
     for (auto const &path : options.vpi_libs) {
         if (!vpi->add_vpi_lib(path)) {
@@ -187,47 +210,112 @@ void verify_vpi_functions(platform::VPILocator *vpi, BuildOptions &options) {
     options.vpi_libs = std::vector(libs.begin(), libs.end());
 }
 
+CXXCodeGenOptions get_cxx_options(const BuildOptions &options) {
+    CXXCodeGenOptions c_options;
+    c_options.vpi_libs = options.vpi_libs;
+    c_options.use_4state = options.use_4state;
+    c_options.levelize_comb = options.levelize_comb;
+    c_options.parallel_comb = options.parallel_comb;
+    c_options.batch_ff = options.batch_ff;
+    c_options.inline_threshold = options.inline_threshold;
+    c_options.dirty_propagation = options.dirty_propagation;
+    c_options.dump_vars = options.dump_vars;
+    c_options.tu_complexity = options.tu_complexity;
+    return c_options;
+}
+
+std::string get_options_id(const CXXCodeGenOptions &options) {
+    return fmt::format("{0} {1} {2} {3} {4} {5} {6} {7} {8}", options.use_4state,
+                       options.levelize_comb, options.parallel_comb, options.batch_ff,
+                       options.inline_threshold, options.dirty_propagation, options.dump_vars,
+                       options.tu_complexity, fmt::join(options.vpi_libs, " "));
+}
+
+// -march=native makes objects specific to the host CPU, so the toolchain is identified by the
+// macros the compiler predefines, which include the compiler version and the instruction sets
+std::optional<std::string> get_toolchain(const NinjaCodeGenOptions &options,
+                                         const std::string &working_dir) {
+    auto probe_filename = (std::filesystem::path(working_dir) / "fsim_probe.cc").string();
+    std::ofstream(probe_filename, std::ios::trunc).close();
+    std::vector<std::string> commands = {options.cxx_path};
+    auto cflags = get_cflags(options.optimization_level);
+    commands.insert(commands.end(), cflags.begin(), cflags.end());
+    commands.insert(commands.end(), {"-dM", "-E", probe_filename});
+    std::string macros;
+    auto p = platform::run(commands, working_dir, macros);
+    std::filesystem::remove(probe_filename);
+    if (p != 0) return std::nullopt;
+    return fmt::format("{0}\n{1}\n{2}", options.cxx_path, fmt::join(cflags, " "), macros);
+}
+
 Builder::Builder(BuildOptions options) : options_(std::move(options)) {
     // filling up empty information
     if (options_.working_dir.empty()) {
         options_.working_dir = default_working_dir;
     }
+    if (options_.cache_dir.empty()) {
+        auto const *cache_dir = std::getenv("FSIM_CACHE_DIR");
+        if (cache_dir) {
+            options_.cache_dir = cache_dir;
+        }
+    }
 }
 
-void Builder::build(const Module *module) {
+void Builder::build(const Module *module) { build(module, nullptr, {}); }
+
+void Builder::build(const Module *module, const Fingerprints *fingerprints,
+                    const std::unordered_set<std::string> &unchanged) {
     if (!std::filesystem::exists(options_.working_dir)) {
         std::filesystem::create_directories(options_.working_dir);
     }
+    if (options_.lanes) {
+        // the generated class is included by the testbench, so there is nothing to build
+        LanesCodeGen lanes(module);
+        lanes.output(options_.working_dir);
+        symlink_folders(options_.working_dir, options_.working_directory);
+        return;
+    }
     // generate ninja first
     NinjaCodeGenOptions n_options;
     n_options.optimization_level = options_.optimization_level;
     n_options.cxx_path = options_.cxx_path;
     n_options.binary_name = options_.binary_name;
     n_options.sv_libs = options_.sv_libs;
+    n_options.tu_complexity = options_.tu_complexity;
     // check all the DPI functions to see if they are valid
     platform::DPILocator dpi_locator;
     verify_dpi_functions(&dpi_locator, module, options_);
     // check the vpi
     platform::VPILocator vpi_locator;
     verify_vpi_functions(&vpi_locator, options_);
+    // variables are only tracked for dumping when needed, since it slows down every write
+    if (has_dumpvars(module)) {
+        options_.dump_vars = true;
+    }
 
     NinjaCodeGen ninja(module, n_options, &dpi_locator);
-    ninja.output(options_.working_dir);
+
+    // the saved fingerprints no longer match the generated code once it changes
+    Fingerprints::remove(options_.working_dir);
 
     // then generate the C++ code
     // use marl for parallelism
     auto modules = module->get_defs();
+    std::vector<const Module *> changed_modules;
+    for (auto const *mod : modules) {
+        if (!unchanged.contains(std::string(mod->name))) {
+            changed_modules.emplace_back(mod);
+        }
+    }
     marl::Scheduler scheduler(marl::Scheduler::Config::allCores());
     scheduler.bind();
     defer(scheduler.unbind());  // Automatically unbind before returning.
 
-    marl::WaitGroup wg_modules(modules.size());
+    marl::WaitGroup wg_modules(changed_modules.size());
 
-    for (auto const *mod : modules) {
+    for (auto const *mod : changed_modules) {
         marl::schedule([wg_modules, mod, this] {
-            CXXCodeGenOptions c_options;
-            c_options.vpi_libs = options_.vpi_libs;
-            c_options.use_4state = options_.use_4state;
+            auto c_options = get_cxx_options(options_);
             CXXCodeGen cxx(mod, c_options);
             cxx.output(options_.working_dir);
             wg_modules.done();
@@ -237,23 +325,53 @@ void Builder::build(const Module *module) {
     wg_modules.wait();
 
     // output main as well
-    {
-        CXXCodeGenOptions c_options;
-        c_options.vpi_libs = options_.vpi_libs;
-        c_options.use_4state = options_.use_4state;
+    if (!unchanged.contains(main_name)) {
+        auto c_options = get_cxx_options(options_);
         CXXCodeGen cxx(module, c_options);
         cxx.output_main(options_.working_dir);
     }
+    if (fingerprints) {
+        fingerprints->save(options_.working_dir);
+    }
 
     // need to symlink stuff over
     symlink_folders(options_.working_dir, options_.working_directory);
 
+    // objects of unchanged modules are linked from the cache instead of being compiled
+    std::optional<ObjectCache> cache;
+    std::vector<std::pair<std::string, std::string>> uncached_objects;
+    if (!options_.cache_dir.empty()) {
+        auto toolchain = get_toolchain(n_options, options_.working_dir);
+        if (toolchain) {
+            cache.emplace(options_.cache_dir, *toolchain);
+        } else {
+            std::cerr << "warning: unable to identify " << n_options.cxx_path
+                      << ". object cache is disabled" << std::endl;
+        }
+    }
+    if (cache) {
+        std::filesystem::path dir = options_.working_dir;
+        auto include_dir = (dir / "include").string();
+        for (auto const &name : ninja.translation_units(options_.working_dir)) {
+            auto key = cache->key((dir / get_cc_filename(name)).string(), include_dir);
+            if (auto obj = cache->find(key)) {
+                n_options.cached_objects.emplace(name, *obj);
+            } else {
+                uncached_objects.emplace_back(key, (dir / fmt::format("{0}.o", name)).string());
+            }
+        }
+    }
+    ninja.output(options_.working_dir);
+
     // call ninja to build the stuff
     {
         auto p = platform::run({"ninja"}, options_.working_dir);
         if (p != 0) {
             throw fsim::InternalError("Unable to build simulation using ninja");
         }
+        for (auto const &[key, obj] : uncached_objects) {
+            cache->store(key, obj);
+        }
         // symlink the output to the current directory
         if (std::filesystem::exists(n_options.binary_name)) {
             std::filesystem::remove(n_options.binary_name);
@@ -271,7 +389,39 @@ void Builder::build(const Module *module) {
     }
 }
 
+// $save(filename) saves a checkpoint that can be restored with +fsim_restart=filename
+class SaveTask : public slang::SystemSubroutine {
+public:
+    SaveTask() : slang::SystemSubroutine("$save", slang::SubroutineKind::Task) {}
+
+    const slang::Type &checkArguments(const slang::BindContext &context, const Args &args,
+                                      slang::SourceRange range,
+                                      const slang::Expression *) const final {
+        auto &compilation = context.getCompilation();
+        if (!checkArgCount(context, false, args, range, 1, 1)) return compilation.getErrorType();
+        if (!args[0]->type->canBeStringLike()) return badArg(context, *args[0]);
+        return compilation.getVoidType();
+    }
+
+    slang::ConstantValue eval(slang::EvalContext &, const Args &,
+                              const slang::CallExpression::SystemCallInfo &) const final {
+        return nullptr;
+    }
+
+    bool verifyConstant(slang::EvalContext &context, const Args &,
+                        slang::SourceRange range) const final {
+        return notConst(context, range);
+    }
+};
+
+void add_system_tasks(slang::Compilation &compilation) {
+    if (!compilation.getSystemSubroutine("$save")) {
+        compilation.addSystemSubroutine(std::make_unique<SaveTask>());
+    }
+}
+
 void Builder::build(slang::Compilation *unit) {
+    add_system_tasks(*unit);
     // figure the top module
     auto const &tops = unit->getRoot().topInstances;
     const slang::InstanceSymbol *inst = nullptr;
@@ -294,8 +444,21 @@ void Builder::build(slang::Compilation *unit) {
         std::cerr << "warning: using " << inst->name << " as top" << std::endl;
     }
     Module m(inst);
-    m.analyze();
-    build(&m);
+    if (options_.lanes) {
+        m.analyze();
+        build(&m);
+        return;
+    }
+    // the codegen options are part of the fingerprints
+    if (has_dumpvars(&m)) {
+        options_.dump_vars = true;
+    }
+    // definitions that are unchanged since the last build are not analyzed and generated again
+    Fingerprints fingerprints(inst, get_options_id(get_cxx_options(options_)),
+                              options_.inline_threshold > 0);
+    auto unchanged = fingerprints.unchanged(options_.working_dir);
+    m.analyze(unchanged);
+    build(&m, &fingerprints, unchanged);
 }
 
 void Builder::cleanup() const {
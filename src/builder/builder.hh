@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace slang {
@@ -12,6 +13,7 @@ class Compilation;
 namespace fsim {
 
 class Module;
+class Fingerprints;
 
 struct BuildOptions {
     std::string working_dir;
@@ -20,8 +22,21 @@ struct BuildOptions {
     // this is the same as GCC, which uses -O0
     uint8_t optimization_level = 0;
     bool use_4state = true;
+    bool levelize_comb = false;
+    bool parallel_comb = false;
+    bool batch_ff = false;
+    uint64_t inline_threshold = 0;
+    // split large modules and group small ones into translation units of about this complexity
+    uint64_t tu_complexity = 0;
+    bool dirty_propagation = false;
+    // set automatically when the design calls $dumpvars
+    bool dump_vars = false;
+    // only generate a bit-sliced class of the design for C++ testbenches. see codegen/lanes.hh
+    bool lanes = false;
     std::string cxx_path;
     std::string binary_name;
+    // compiled objects are shared through the cache when set. defaults to $FSIM_CACHE_DIR
+    std::string cache_dir;
     std::string top_name;
 
     std::vector<std::string> sv_libs;
@@ -30,6 +45,10 @@ struct BuildOptions {
     [[nodiscard]] bool add_vpi() const { return !vpi_libs.empty(); }
 };
 
+// registers the fsim specific system tasks, e.g. $save. has to be called before the design is
+// elaborated
+void add_system_tasks(slang::Compilation &compilation);
+
 class Builder {
 public:
     explicit Builder(BuildOptions options);
@@ -42,6 +61,10 @@ public:
 
 private:
     BuildOptions options_;
+
+    // definitions in unchanged are not generated again
+    void build(const Module *module, const Fingerprints *fingerprints,
+               const std::unordered_set<std::string> &unchanged);
 };
 
 }  // namespace fsim
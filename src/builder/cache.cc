@@ -0,0 +1,108 @@
+#include "cache.hh"
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "fmt/format.h"
+#include "hash.hh"
+
+namespace fsim {
+
+std::optional<std::string> read_file(const std::filesystem::path &filename) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) return std::nullopt;
+    std::stringstream content;
+    content << stream.rdbuf();
+    return content.str();
+}
+
+// both "" and <> includes in the order they appear. conditional includes are scanned as well,
+// which only makes the key more conservative
+std::vector<std::string_view> get_includes(std::string_view content) {
+    std::vector<std::string_view> result;
+    while (!content.empty()) {
+        auto end = content.find('\n');
+        auto line = content.substr(0, end);
+        content = end == std::string_view::npos ? std::string_view{} : content.substr(end + 1);
+
+        auto pos = line.find_first_not_of(" \t");
+        if (pos == std::string_view::npos || line[pos] != '#') continue;
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string_view::npos || line.substr(pos, 7) != "include") continue;
+        pos = line.find_first_not_of(" \t", pos + 7);
+        if (pos == std::string_view::npos || (line[pos] != '"' && line[pos] != '<')) continue;
+        auto close = line.find(line[pos] == '"' ? '"' : '>', pos + 1);
+        if (close == std::string_view::npos) continue;
+        result.emplace_back(line.substr(pos + 1, close - pos - 1));
+    }
+    return result;
+}
+
+ObjectCache::ObjectCache(const std::string &dir, std::string_view toolchain)
+    : dir_(std::filesystem::absolute(dir)), toolchain_(Hash().add(toolchain).str()) {}
+
+std::string ObjectCache::key(const std::string &filename, const std::string &include_dir) {
+    Hash hash;
+    hash.add(toolchain_).add(hash_file(filename, include_dir));
+    return hash.str();
+}
+
+std::optional<std::string> ObjectCache::find(const std::string &key) const {
+    auto path = object_path(key);
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(path, ec)) return path.string();
+    return std::nullopt;
+}
+
+void ObjectCache::store(const std::string &key, const std::string &obj_filename) const {
+    auto path = object_path(key);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) return;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec) return;
+    // copy to a unique name first so that other builds never see a partial object
+    auto tmp = path;
+    tmp += fmt::format(".{0:x}.tmp", std::random_device()());
+    if (!std::filesystem::copy_file(obj_filename, tmp, ec)) return;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+}
+
+std::string ObjectCache::hash_file(const std::filesystem::path &filename,
+                                   const std::string &include_dir) {
+    auto name = filename.lexically_normal().string();
+    if (auto it = header_hashes_.find(name); it != header_hashes_.end()) {
+        // an empty hash means the header is being hashed, i.e. it is included recursively. its
+        // content is already part of the key
+        return it->second;
+    }
+    header_hashes_.emplace(name, "");
+
+    Hash hash;
+    auto content = read_file(filename);
+    if (content) {
+        hash.add(*content);
+        for (auto const &include : get_includes(*content)) {
+            for (auto const &path : {filename.parent_path() / include,
+                                     std::filesystem::path(include_dir) / include}) {
+                std::error_code ec;
+                if (!std::filesystem::is_regular_file(path, ec)) continue;
+                // the include name rather than the path, so that keys are the same in every
+                // working directory
+                hash.add(include).add(hash_file(path, include_dir));
+                break;
+            }
+        }
+    }
+    auto result = hash.str();
+    header_hashes_[name] = result;
+    return result;
+}
+
+std::filesystem::path ObjectCache::object_path(const std::string &key) const {
+    return dir_ / key.substr(0, 2) / (key + ".o");
+}
+
+}  // namespace fsim
@@ -0,0 +1,41 @@
+#ifndef FSIM_BUILDER_CACHE_HH
+#define FSIM_BUILDER_CACHE_HH
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace fsim {
+
+// content-addressed cache of compiled objects, shared by every working directory. an object is
+// keyed on its generated source, every header it includes and the toolchain, i.e. the compiler
+// and its flags, so a module that has been compiled before is linked straight from the cache.
+// objects are stored as <dir>/<first 2 digits of the key>/<key>.o
+class ObjectCache {
+public:
+    ObjectCache(const std::string &dir, std::string_view toolchain);
+
+    // includes are searched next to the including file first, then in include_dir. headers that
+    // can't be found, e.g. the standard library, are covered by the toolchain
+    [[nodiscard]] std::string key(const std::string &filename, const std::string &include_dir);
+    // absolute path of the cached object
+    [[nodiscard]] std::optional<std::string> find(const std::string &key) const;
+    // the object is moved into place atomically, so concurrent builds can share the cache. failing
+    // to store an object is not an error
+    void store(const std::string &key, const std::string &obj_filename) const;
+
+private:
+    std::filesystem::path dir_;
+    std::string toolchain_;
+    // headers are shared by most objects, so they are only hashed once
+    std::unordered_map<std::string, std::string> header_hashes_;
+
+    std::string hash_file(const std::filesystem::path &filename, const std::string &include_dir);
+    [[nodiscard]] std::filesystem::path object_path(const std::string &key) const;
+};
+
+}  // namespace fsim
+
+#endif  // FSIM_BUILDER_CACHE_HH
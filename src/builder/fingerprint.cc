@@ -0,0 +1,183 @@
+#include "fingerprint.hh"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "../codegen/util.hh"
+#include "hash.hh"
+#include "slang/compilation/Compilation.h"
+#include "slang/symbols/ASTVisitor.h"
+#include "slang/syntax/AllSyntax.h"
+#include "slang/syntax/SyntaxTree.h"
+#include "version.hh"
+
+namespace fsim {
+
+auto constexpr fingerprint_filename = "fingerprints";
+
+// same traversal as ModuleAnalyzeVisitor
+class ChildInstanceVisitor : public slang::ASTVisitor<ChildInstanceVisitor, false, false> {
+public:
+    explicit ChildInstanceVisitor(const slang::InstanceSymbol *target) : target_(target) {}
+
+    [[maybe_unused]] void handle(const slang::InstanceSymbol &inst) {
+        if (&inst == target_) {
+            visitDefault(inst);
+        } else if (inst.getDefinition().definitionKind == slang::DefinitionKind::Module) {
+            children.emplace_back(&inst);
+        }
+    }
+
+    std::vector<const slang::InstanceSymbol *> children;
+
+private:
+    const slang::InstanceSymbol *target_;
+};
+
+// packages, classes, $unit declarations etc. can be used by any module
+std::string hash_global_declarations(const slang::Compilation &compilation) {
+    Hash hash;
+    for (auto const &tree : compilation.getSyntaxTrees()) {
+        auto const &root = tree->root();
+        if (root.kind != slang::SyntaxKind::CompilationUnit) {
+            hash.add(root.toString());
+            continue;
+        }
+        for (auto const *member : root.as<slang::CompilationUnitSyntax>().members) {
+            if (member->kind == slang::SyntaxKind::ModuleDeclaration) continue;
+            hash.add(member->toString());
+        }
+    }
+    return hash.str();
+}
+
+void add_parameters(Hash &hash, const slang::InstanceSymbol *inst) {
+    for (auto const &member : inst->body.members()) {
+        if (member.kind == slang::SymbolKind::Parameter) {
+            hash.add(member.name).add(member.as<slang::ParameterSymbol>().getValue().toString());
+        } else if (member.kind == slang::SymbolKind::TypeParameter) {
+            auto const &param = member.as<slang::TypeParameterSymbol>();
+            hash.add(member.name).add(param.targetType.getType().toString());
+        }
+    }
+}
+
+void add_ports(Hash &hash, const slang::InstanceSymbol *inst, bool connections) {
+    for (auto const *sym : inst->body.getPortList()) {
+        if (!slang::PortSymbol::isKind(sym->kind)) continue;
+        auto const &port = sym->as<slang::PortSymbol>();
+        hash.add(port.name).add(slang::toString(port.direction)).add(port.getType().toString());
+        if (!connections) continue;
+        // connections decide which ports are aliased to the parent variables
+        auto const *expr = inst->getPortConnection(port)->getExpression();
+        if (expr) {
+            hash.add(expr->syntax ? expr->syntax->toString() : "").add(expr->type->toString());
+        } else {
+            hash.add("");
+        }
+    }
+}
+
+Fingerprints::Fingerprints(const slang::InstanceSymbol *top, std::string_view options,
+                           bool inline_children)
+    : inline_children_(inline_children) {
+    auto const &compilation = top->getParentScope()->getCompilation();
+    prefix_ = Hash()
+                  .add(runtime::VERSION)
+                  .add(options)
+                  .add(hash_global_declarations(compilation))
+                  .str();
+    compute(top);
+
+    Hash main_hash;
+    main_hash.add(prefix_).add(top->getDefinition().name);
+    for (auto const &[name, fingerprints] : instance_fingerprints_) {
+        Hash hash;
+        for (auto const &fingerprint : fingerprints) {
+            hash.add(fingerprint);
+        }
+        auto const &result = fingerprints_.emplace(name, hash.str()).first->second;
+        main_hash.add(name).add(result);
+    }
+    fingerprints_.emplace(main_name, main_hash.str());
+}
+
+std::unordered_set<std::string> Fingerprints::unchanged(const std::string &dir) const {
+    std::unordered_set<std::string> result;
+    std::filesystem::path dir_path = dir;
+    std::ifstream stream(dir_path / fingerprint_filename);
+    std::string name, fingerprint;
+    while (stream >> name >> fingerprint) {
+        auto it = fingerprints_.find(name);
+        if (it == fingerprints_.end() || it->second != fingerprint) continue;
+        if (!std::filesystem::exists(dir_path / get_cc_filename(name))) continue;
+        if (name != main_name && !std::filesystem::exists(dir_path / get_hh_filename(name))) {
+            continue;
+        }
+        result.emplace(name);
+    }
+
+    if (inline_children_) {
+        // a child inlined into a generated parent needs to be analyzed, and then generated as
+        // well, which in turn needs its children analyzed
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto const &[name, parents] : parents_) {
+                if (!result.contains(name)) continue;
+                if (std::all_of(parents.begin(), parents.end(),
+                                [&result](auto const &p) { return result.contains(p); })) {
+                    continue;
+                }
+                result.erase(name);
+                changed = true;
+            }
+        }
+    }
+    return result;
+}
+
+void Fingerprints::remove(const std::string &dir) {
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::path(dir) / fingerprint_filename, ec);
+}
+
+void Fingerprints::save(const std::string &dir) const {
+    std::ofstream stream(std::filesystem::path(dir) / fingerprint_filename, std::ios::trunc);
+    for (auto const &[name, fingerprint] : fingerprints_) {
+        stream << name << " " << fingerprint << std::endl;
+    }
+}
+
+// NOLINTNEXTLINE
+std::string Fingerprints::compute(const slang::InstanceSymbol *inst) {
+    auto const &def = inst->getDefinition();
+    if (!text_hashes_.contains(&def)) {
+        text_hashes_.emplace(&def, Hash().add(def.syntax.toString()).str());
+    }
+
+    Hash hash;
+    hash.add(prefix_).add(text_hashes_.at(&def));
+    add_parameters(hash, inst);
+    add_ports(hash, inst, true);
+
+    ChildInstanceVisitor visitor(inst);
+    inst->visit(visitor);
+    for (auto const *child : visitor.children) {
+        auto child_name = std::string(child->getDefinition().name);
+        parents_[child_name].emplace(def.name);
+        auto child_fingerprint = compute(child);
+        hash.add(child->name).add(child_name);
+        add_ports(hash, child, false);
+        if (inline_children_) {
+            hash.add(child_fingerprint);
+        }
+    }
+
+    auto result = hash.str();
+    instance_fingerprints_[std::string(def.name)].emplace(result);
+    return result;
+}
+
+}  // namespace fsim
@@ -0,0 +1,50 @@
+#ifndef FSIM_BUILDER_FINGERPRINT_HH
+#define FSIM_BUILDER_FINGERPRINT_HH
+
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace slang {
+class DefinitionSymbol;
+class InstanceSymbol;
+}  // namespace slang
+
+namespace fsim {
+
+// fingerprints of the module definitions, saved in the working directory. a definition with the
+// same fingerprint as the last build generates the same code, so it is neither analyzed nor
+// generated again. the fingerprint of a definition covers
+//   - its source text after preprocessing, and everything declared outside of modules
+//   - parameter values and port connections of each of its instances
+//   - port signatures of its child instances, or their fingerprints if children can be inlined
+//   - the fsim version and the codegen options
+class Fingerprints {
+public:
+    Fingerprints(const slang::InstanceSymbol *top, std::string_view options, bool inline_children);
+
+    // definitions whose generated code in dir is up to date. the main file is named main_name
+    [[nodiscard]] std::unordered_set<std::string> unchanged(const std::string &dir) const;
+    // has to be called before the generated code is changed, in case the build is interrupted
+    static void remove(const std::string &dir);
+    void save(const std::string &dir) const;
+
+private:
+    bool inline_children_;
+    std::string prefix_;
+    std::map<std::string, std::string> fingerprints_;
+    // definitions that instantiate each definition
+    std::unordered_map<std::string, std::set<std::string>> parents_;
+    // fingerprints of every instance of each definition
+    std::map<std::string, std::set<std::string>> instance_fingerprints_;
+    std::unordered_map<const slang::DefinitionSymbol *, std::string> text_hashes_;
+
+    std::string compute(const slang::InstanceSymbol *inst);
+};
+
+}  // namespace fsim
+
+#endif  // FSIM_BUILDER_FINGERPRINT_HH
@@ -0,0 +1,41 @@
+#ifndef FSIM_BUILDER_HASH_HH
+#define FSIM_BUILDER_HASH_HH
+
+#include <string>
+#include <string_view>
+
+#include "fmt/format.h"
+
+namespace fsim {
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+// 128-bit FNV-1a. it is stable across builds and platforms, and wide enough for caches that are
+// shared by many users
+class Hash {
+public:
+    Hash &add(std::string_view data) {
+        for (auto c : data) {
+            value_ ^= static_cast<uint8_t>(c);
+            value_ *= prime;
+        }
+        // separates the inputs, so that ("ab", "c") and ("a", "bc") don't collide
+        value_ ^= data.size();
+        value_ *= prime;
+        return *this;
+    }
+
+    [[nodiscard]] std::string str() const {
+        return fmt::format("{0:016x}{1:016x}", static_cast<uint64_t>(value_ >> 64),
+                           static_cast<uint64_t>(value_));
+    }
+
+private:
+    static constexpr uint128_t prime = (static_cast<uint128_t>(1) << 88) + 0x13b;
+    uint128_t value_ =
+        (static_cast<uint128_t>(0x6c62272e07bb0142ull) << 64) | 0x62b821756295c58dull;
+};
+
+}  // namespace fsim
+
+#endif  // FSIM_BUILDER_HASH_HH
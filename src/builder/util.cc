@@ -3,21 +3,41 @@
 #include "reproc++/run.hpp"
 
 namespace fsim::platform {
-int run(const std::vector<std::string> &commands, const std::string &working_directory) {
-    reproc::options options;
-    options.working_directory = working_directory.c_str();
-    int status = -1;
-    std::error_code ec;
+std::vector<const char *> get_args(const std::vector<std::string> &commands) {
     std::vector<const char *> args;
     args.reserve(commands.size() + 1);
     for (auto const &cmd : commands) {
         args.emplace_back(cmd.c_str());
     }
     args.emplace_back(nullptr);
+    return args;
+}
+
+int run(const std::vector<std::string> &commands, const std::string &working_directory) {
+    reproc::options options;
+    options.working_directory = working_directory.c_str();
+    int status = -1;
+    std::error_code ec;
+    auto args = get_args(commands);
     std::tie(status, ec) = reproc::run(args.data(), options);
     if (ec)
         return -1;
     else
         return status;
 }
+
+int run(const std::vector<std::string> &commands, const std::string &working_directory,
+        std::string &output) {
+    reproc::options options;
+    options.working_directory = working_directory.c_str();
+    int status = -1;
+    std::error_code ec;
+    auto args = get_args(commands);
+    reproc::sink::string sink(output);
+    std::tie(status, ec) = reproc::run(args.data(), options, sink, reproc::sink::null);
+    if (ec)
+        return -1;
+    else
+        return status;
+}
 }  // namespace fsim::platform
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <vector>
 namespace fsim::platform {
 int run(const std::vector<std::string> &commands, const std::string &working_directory);
+// stdout of the process is stored in output
+int run(const std::vector<std::string> &commands, const std::string &working_directory,
+        std::string &output);
 }  // namespace fsim::platform
 
 #endif  // FSIM_BUILDER_UTIL_HH
@@ -14,14 +14,7 @@ namespace fsim {
 // need to generate header information about module declaration
 // this includes variable, port, and parameter definition
 
-auto constexpr raw_header_include = R"(#include "logic/array.hh"
-#include "logic/logic.hh"
-#include "logic/struct.hh"
-#include "logic/union.hh"
-#include "runtime/module.hh"
-#include "runtime/system_task.hh"
-#include "runtime/variable.hh"
-
+auto constexpr raw_header_include = R"(
 // forward declaration
 namespace fsim::runtime {
 class Scheduler;
@@ -48,15 +41,68 @@ void codegen_edge_control(std::ostream &s, const Process *process, CodeGenModule
             name.visit(v);
             s << ".track_edge = true;" << std::endl;
 
-            s << info.scheduler_name() << "->add_tracked_var(&";
+            s << fmt::format("{0}->add_process_edge_control({1}, &", info.scheduler_name(),
+                             info.current_process_name());
             name.visit(v);
             s << ");" << std::endl;
         }
-        s << fmt::format("scheduler->add_process_edge_control({0});", info.current_process_name())
-          << std::endl;
     }
 }
 
+// delays at the top level of a process body. a process restored from a checkpoint jumps straight
+// to the delay it was suspended at, which is only legal if no variable is declared in between
+std::vector<const slang::Statement *> get_resume_points(const Process *process) {
+    std::vector<const slang::Statement *> result;
+    if (process->stmts.size() != 1 ||
+        process->stmts[0]->kind != slang::SymbolKind::ProceduralBlock) {
+        return result;
+    }
+    auto const *body = &process->stmts[0]->as<slang::ProceduralBlockSymbol>().getBody();
+    if (body->kind == slang::StatementKind::Block) {
+        auto const &block = body->as<slang::BlockStatement>();
+        if (block.blockKind != slang::StatementBlockKind::Sequential) return result;
+        body = &block.body;
+    }
+    std::vector<const slang::Statement *> stmts = {body};
+    if (body->kind == slang::StatementKind::List) {
+        auto const &list = body->as<slang::StatementList>().list;
+        stmts = std::vector(list.begin(), list.end());
+    }
+
+    for (auto const *stmt : stmts) {
+        auto const *inner = stmt;
+        bool delay = false;
+        if (stmt->kind == slang::StatementKind::Timed) {
+            auto const &timed = stmt->as<slang::TimedStatement>();
+            inner = &timed.stmt;
+            delay = timed.timing.kind == slang::TimingControlKind::Delay;
+        }
+        // fork declares its join variables in the current scope
+        if (inner->kind == slang::StatementKind::VariableDeclaration ||
+            (inner->kind == slang::StatementKind::Block &&
+             inner->as<slang::BlockStatement>().blockKind !=
+                 slang::StatementBlockKind::Sequential)) {
+            return {};
+        }
+        if (delay) result.emplace_back(stmt);
+    }
+    return result;
+}
+
+void codegen_resume_points(std::ostream &s, const Process *process,
+                           CodeGenModuleInformation &info) {
+    info.resume_points.clear();
+    auto points = get_resume_points(process);
+    if (points.empty()) return;
+    // resume points start from 1 since 0 means the process starts from the beginning
+    s << fmt::format("switch ({0}->resume_point) {{", info.current_process_name()) << std::endl;
+    for (auto i = 0u; i < points.size(); i++) {
+        info.resume_points.emplace(points[i], i + 1);
+        s << fmt::format("case {0}: goto fsim_resume_{0};", i + 1) << std::endl;
+    }
+    s << "default: break;" << std::endl << "}" << std::endl;
+}
+
 void codegen_init(std::ostream &s, const Process *process, const CXXCodeGenOptions &options,
                   CodeGenModuleInformation &info) {
     s << "{" << std::endl;
@@ -66,11 +112,13 @@ void codegen_init(std::ostream &s, const Process *process, const CXXCodeGenOptio
       << std::endl
       << fmt::format("{0}->func = [this, {0}, {1}]() {{", ptr_name, info.scheduler_name())
       << std::endl;
+    codegen_resume_points(s, process, info);
 
     auto const &stmts = process->stmts;
     for (auto const *stmt : stmts) {
         codegen_sym(s, stmt, options, info);
     }
+    info.resume_points.clear();
 
     s << FSIM_END_PROCESS << "(" << ptr_name << ");" << std::endl;
     s << "};" << std::endl;
@@ -112,27 +160,45 @@ void codegen_always(std::ostream &s, const CombProcess *process, const CXXCodeGe
 
     // depends on the comb process type, we may generate different style
     bool infinite_loop = process->kind == CombProcess::CombKind::GeneralPurpose;
+    // levelized process is called directly by the runtime, so there is no need to end the process
+    bool levelized = options.levelize_comb && process->levelized;
     // declare the always block
 
     s << fmt::format("auto {0} = {1}->create_comb_process();", ptr_name, info.scheduler_name())
-      << std::endl
-      << fmt::format("{0}->func = [this, {0}, {1}]() {{", ptr_name, info.scheduler_name())
       << std::endl;
-
-    if (infinite_loop) {
-        s << "while (true) {" << std::endl;
+    if (levelized) {
+        s << fmt::format("{0}->levelized = true;", ptr_name) << std::endl;
     }
-
-    auto const &stmts = process->stmts;
-    for (auto const *stmt : stmts) {
-        codegen_sym(s, stmt, options, info);
+    if (options.parallel_comb && process->level >= 0) {
+        s << fmt::format("{0}->level = {1};", ptr_name, process->level) << std::endl;
     }
+    s << fmt::format("{0}->func = [this, {0}, {1}]() {{", ptr_name, info.scheduler_name())
+      << std::endl;
 
-    // general purpose always doesn't have end process since it never ends
-    if (!infinite_loop) s << FSIM_END_PROCESS << "(" << ptr_name << ");" << std::endl;
+    if (levelized && info.has_process_function(process)) {
+        // body is generated as a member function
+        s << fmt::format("{0}({1}, {2});", info.get_process_function_name(process), ptr_name,
+                         info.scheduler_name())
+          << std::endl;
+    } else {
+        if (infinite_loop) {
+            codegen_resume_points(s, process, info);
+            s << "while (true) {" << std::endl;
+        }
 
-    if (infinite_loop) {
-        s << "}" << std::endl;
+        auto const &stmts = process->stmts;
+        for (auto const *stmt : stmts) {
+            codegen_sym(s, stmt, options, info);
+        }
+        info.resume_points.clear();
+
+        // general purpose always doesn't have end process since it never ends
+        if (!infinite_loop && !levelized)
+            s << FSIM_END_PROCESS << "(" << ptr_name << ");" << std::endl;
+
+        if (infinite_loop) {
+            s << "}" << std::endl;
+        }
     }
 
     s << "};" << std::endl;
@@ -141,7 +207,7 @@ void codegen_always(std::ostream &s, const CombProcess *process, const CXXCodeGe
     for (auto *var : process->sensitive_list) {
         ExprCodeGenVisitor v(s, info);
         var->visit(v);
-        s << ".comb_processes.emplace_back(" << ptr_name << ");" << std::endl;
+        s << ".add_comb_process(" << ptr_name << ");" << std::endl;
     }
 
     s << fmt::format("comb_processes_.emplace_back({0});", ptr_name) << std::endl;
@@ -152,48 +218,88 @@ void codegen_always(std::ostream &s, const CombProcess *process, const CXXCodeGe
     s << "}" << std::endl;
 }
 
-void codegen_ff(std::ostream &s, const FFProcess *process, const CXXCodeGenOptions &options,
-                CodeGenModuleInformation &info) {
-    s << "{" << std::endl;
+void codegen_levelized_always(std::ostream &s, const CombProcess *process,
+                              const CXXCodeGenOptions &options, CodeGenModuleInformation &info,
+                              std::string_view name_prefix) {
     auto const &ptr_name = info.enter_process();
-
-    s << fmt::format("auto {0} = {1}->create_ff_process();", ptr_name, info.scheduler_name())
-      << std::endl
-      << fmt::format("{0}->func = [this, {0}, {1}]() {{", ptr_name, info.scheduler_name())
+    s << fmt::format("void {0}{1}(fsim::runtime::Process *{2}, fsim::runtime::Scheduler *{3}) {{",
+                     name_prefix, info.get_process_function_name(process), ptr_name,
+                     info.scheduler_name())
       << std::endl;
 
-    auto const &stmts = process->stmts;
-    for (auto const *stmt : stmts) {
+    for (auto const *stmt : process->stmts) {
         codegen_sym(s, stmt, options, info);
     }
 
-    // output end process
-    s << FSIM_END_PROCESS << "(" << ptr_name << ");" << std::endl;
+    info.exit_process();
+    s << "}" << std::endl;
+}
 
-    s << "};" << std::endl;
+using FFEdges = std::vector<std::pair<slang::EdgeKind, const slang::ValueSymbol *>>;
 
-    s << fmt::format("ff_process_.emplace_back({0});", ptr_name) << std::endl;
+std::string get_var_name(const slang::ValueSymbol *var, CodeGenModuleInformation &info) {
+    if (auto const *alias = info.get_port_alias(var)) {
+        return std::string(info.get_identifier_name(alias->name));
+    }
+    if (auto const *name = info.get_inline_var_name(var)) return *name;
+    return std::string(info.get_identifier_name(var->name));
+}
 
+void codegen_ff_edges(std::ostream &s, const FFEdges &edges, CodeGenModuleInformation &info) {
+    auto const &ptr_name = info.current_process_name();
     // generate edge trigger functions
-    for (auto const &[edge, v] : process->edges) {
+    for (auto const &[edge, v] : edges) {
         if (edge == slang::EdgeKind::PosEdge || edge == slang::EdgeKind::BothEdges) {
-            s << info.get_identifier_name(v->name) << ".ff_posedge_processes.emplace_back("
-              << ptr_name << ");" << std::endl;
+            s << get_var_name(v, info) << ".add_posedge_process(" << ptr_name << ");" << std::endl;
         }
         if (edge == slang::EdgeKind::NegEdge || edge == slang::EdgeKind::BothEdges) {
-            s << info.get_identifier_name(v->name) << ".ff_negedge_processes.emplace_back("
-              << ptr_name << ");" << std::endl;
+            s << get_var_name(v, info) << ".add_negedge_process(" << ptr_name << ");" << std::endl;
         }
     }
 
     // set edge tracking as well
-    std::set<std::string_view> vars;
-    for (auto const &iter : process->edges) {
-        vars.emplace(info.get_identifier_name(iter.second->name));
+    std::set<std::string> vars;
+    for (auto const &iter : edges) {
+        vars.emplace(get_var_name(iter.second, info));
     }
     for (auto const &name : vars) {
         s << name << ".track_edge = true;" << std::endl;
     }
+}
+
+void codegen_ff(std::ostream &s, const FFProcess *process, const CXXCodeGenOptions &options,
+                CodeGenModuleInformation &info) {
+    s << "{" << std::endl;
+    auto const &ptr_name = info.enter_process();
+    // if there is no timing control after the edge list, the process is triggered by the edges
+    // directly and called by the scheduler without a fiber
+    bool stackless = process->body != nullptr;
+
+    s << fmt::format("auto {0} = {1}->create_ff_process();", ptr_name, info.scheduler_name())
+      << std::endl;
+    if (stackless) {
+        s << fmt::format("{0}->stackless = true;", ptr_name) << std::endl;
+    }
+    s << fmt::format("{0}->func = [this, {0}, {1}]() {{", ptr_name, info.scheduler_name())
+      << std::endl;
+
+    if (stackless) {
+        codegen_sym(s, process->body, options, info);
+    } else {
+        auto const &stmts = process->stmts;
+        for (auto const *stmt : stmts) {
+            codegen_sym(s, stmt, options, info);
+        }
+
+        // output end process
+        s << FSIM_END_PROCESS << "(" << ptr_name << ");" << std::endl;
+    }
+
+    s << "};" << std::endl;
+
+    s << fmt::format("ff_process_.emplace_back({0});", ptr_name) << std::endl;
+
+    codegen_ff_edges(s, process->edges, info);
 
     codegen_edge_control(s, process, info);
 
@@ -201,11 +307,133 @@ void codegen_ff(std::ostream &s, const FFProcess *process, const CXXCodeGenOptio
     s << "}" << std::endl;
 }
 
+void codegen_ff_batch(std::ostream &s, const std::vector<const FFProcess *> &processes,
+                      const CXXCodeGenOptions &options, CodeGenModuleInformation &info) {
+    // all processes share the same edges and have no timing control inside. they are evaluated
+    // in a single function on every edge
+    s << "{" << std::endl;
+    auto const &ptr_name = info.enter_process();
+
+    s << fmt::format("auto {0} = {1}->create_ff_process();", ptr_name, info.scheduler_name())
+      << std::endl
+      << fmt::format("{0}->stackless = true;", ptr_name) << std::endl
+      << fmt::format("{0}->func = [this, {0}, {1}]() {{", ptr_name, info.scheduler_name())
+      << std::endl;
+
+    for (auto const *process : processes) {
+        s << "{" << std::endl;
+        codegen_sym(s, process->body, options, info);
+        s << "}" << std::endl;
+    }
+
+    s << "};" << std::endl;
+
+    s << fmt::format("ff_process_.emplace_back({0});", ptr_name) << std::endl;
+
+    codegen_ff_edges(s, processes[0]->edges, info);
+
+    info.exit_process();
+    s << "}" << std::endl;
+}
+
+std::vector<std::vector<const FFProcess *>> get_ff_batches(
+    const std::vector<std::unique_ptr<FFProcess>> &processes) {
+    // group by edges in the order of appearance to keep the code deterministic
+    std::vector<std::pair<FFEdges, std::vector<const FFProcess *>>> groups;
+    for (auto const &process : processes) {
+        if (!process->body) continue;
+        auto edges = process->edges;
+        std::sort(edges.begin(), edges.end());
+        auto it = std::find_if(groups.begin(), groups.end(),
+                               [&edges](auto const &group) { return group.first == edges; });
+        if (it == groups.end()) {
+            std::vector<const FFProcess *> group = {process.get()};
+            groups.emplace_back(std::make_pair(edges, group));
+        } else {
+            it->second.emplace_back(process.get());
+        }
+    }
+
+    std::vector<std::vector<const FFProcess *>> result;
+    result.reserve(groups.size());
+    for (auto &[_, group] : groups) {
+        result.emplace_back(std::move(group));
+    }
+    return result;
+}
+
+void codegen_ff_processes(std::ostream &s, const Module *mod, const CXXCodeGenOptions &options,
+                          CodeGenModuleInformation &info) {
+    if (options.batch_ff) {
+        for (auto const &ff : mod->ff_processes) {
+            if (!ff->body) codegen_ff(s, ff.get(), options, info);
+        }
+        for (auto const &batch : get_ff_batches(mod->ff_processes)) {
+            codegen_ff_batch(s, batch, options, info);
+        }
+    } else {
+        for (auto const &ff : mod->ff_processes) {
+            codegen_ff(s, ff.get(), options, info);
+        }
+    }
+}
+
+bool is_inlined(const Module *mod, const CXXCodeGenOptions &options) {
+    return options.inline_threshold > 0 && mod->inlinable(options.inline_threshold);
+}
+
+bool has_inlined_ff(const Module *mod, const CXXCodeGenOptions &options) {
+    return std::any_of(mod->child_instances.begin(), mod->child_instances.end(),
+                       [&options](auto const &iter) {
+                           return is_inlined(iter.second.get(), options) &&
+                                  !iter.second->ff_processes.empty();
+                       });
+}
+
+uint64_t num_child_instances(const Module *mod, const CXXCodeGenOptions &options) {
+    return std::count_if(
+        mod->child_instances.begin(), mod->child_instances.end(),
+        [&options](auto const &iter) { return !is_inlined(iter.second.get(), options); });
+}
+
+class InlineInstanceScope {
+public:
+    // switch the codegen context to a child instance whose processes are generated inside the
+    // parent module
+    InlineInstanceScope(CodeGenModuleInformation &info, const Module *mod, std::string_view name)
+        : info_(info), parent_(info.current_module) {
+        set_module(mod);
+        info_.inline_instance = name;
+        info_.port_aliases = mod->get_port_aliases();
+    }
+
+    ~InlineInstanceScope() {
+        set_module(parent_);
+        info_.inline_instance = {};
+        info_.port_aliases.clear();
+    }
+
+private:
+    CodeGenModuleInformation &info_;
+    const Module *parent_;
+
+    void set_module(const Module *mod) {
+        info_.current_module = mod;
+        info_.clear_tracked_names();
+        auto const &tracked_vars = mod->get_tracked_vars();
+        for (auto const n : tracked_vars) {
+            info_.add_tracked_name(n);
+        }
+    }
+};
+
 void codegen_port_connections(std::ostream &s, const Module *module,
                               const CXXCodeGenOptions &options, CodeGenModuleInformation &info) {
     // we generate it as an "always" process
     // to allow code re-use, we create fake assignment
     auto comb_process = CombProcess(CombProcess::CombKind::AlwaysComb);
+    // port connections are pure assignments
+    comb_process.levelized = true;
     std::vector<std::unique_ptr<slang::AssignmentExpression>> exprs;
     std::vector<std::unique_ptr<slang::ContinuousAssignSymbol>> stmts;
     std::vector<std::unique_ptr<slang::NamedValueExpression>> names;
@@ -214,10 +442,15 @@ void codegen_port_connections(std::ostream &s, const Module *module,
 
     std::set<const slang::Symbol *> sensitivities;
 
+    // ports of inlined instance that are aliased to the parent variables don't need any copy
+    auto const aliases =
+        is_inlined(module, options) ? module->get_port_aliases() : Module::PortAliases();
+
     for (auto const &[port, var] : module->inputs) {
         // inputs is var assigned to port, so it's port = var
         // get the variable symbol given the port name
         auto port_var = module->port_vars.at(port->name);
+        if (aliases.contains(port_var)) continue;
         auto name = std::make_unique<slang::NamedValueExpression>(*port_var, sr);
         auto expr = std::make_unique<slang::AssignmentExpression>(
             std::nullopt, false, port->getType(), *name, *const_cast<slang::Expression *>(var),
@@ -240,6 +473,7 @@ void codegen_port_connections(std::ostream &s, const Module *module,
     for (auto const &[port, var] : module->outputs) {
         // inputs is var assigned to port, so it's var = port
         auto port_var = module->port_vars.at(port->name);
+        if (aliases.contains(port_var)) continue;
         auto name = std::make_unique<slang::NamedValueExpression>(*port_var, sr);
         auto expr = std::make_unique<slang::AssignmentExpression>(
             std::nullopt, false, *var->type, *const_cast<slang::Expression *>(var), *name, nullptr,
@@ -253,6 +487,8 @@ void codegen_port_connections(std::ostream &s, const Module *module,
         sensitivities.emplace(port_var);
     }
 
+    if (comb_process.stmts.empty()) return;
+
     for (auto const *n : sensitivities) {
         comb_process.sensitive_list.emplace_back(n);
     }
@@ -260,27 +496,24 @@ void codegen_port_connections(std::ostream &s, const Module *module,
     codegen_always(s, &comb_process, options, info);
 }
 
-void output_ctor(std::ostream &s, const Module *module, CodeGenModuleInformation &info) {
-    std::set<std::string_view> headers;
-    for (auto const &iter : module->child_instances) {
-        s << "#include \"" << iter.second->name << ".hh\"" << std::endl;
-    }
-
-    // output name space
-    s << "namespace fsim {" << std::endl;
-
-    // then output the class ctor
+void output_ctor(std::ostream &s, const Module *module, const CXXCodeGenOptions &options,
+                 CodeGenModuleInformation &info) {
+    // output the class ctor
     s << info.get_identifier_name(module->name) << "::" << info.get_identifier_name(module->name)
       << "(): fsim::runtime::Module(\"" << module->name << "\") {" << std::endl;
 
+    // inlined instances don't have an object of their own
     for (auto const &[name, m] : module->child_instances) {
+        if (is_inlined(m.get(), options)) continue;
         s << name << " = std::make_shared<" << info.get_identifier_name(m->name) << ">();"
           << std::endl;
     }
 
     // add it to the child instances
-    s << fmt::format("child_instances_.reserve({0});", module->child_instances.size()) << std::endl;
-    for (auto const &[name, _] : module->child_instances) {
+    s << fmt::format("child_instances_.reserve({0});", num_child_instances(module, options))
+      << std::endl;
+    for (auto const &[name, m] : module->child_instances) {
+        if (is_inlined(m.get(), options)) continue;
         s << fmt::format("child_instances_.emplace_back({0}.get());", name) << std::endl;
     }
 
@@ -351,21 +584,170 @@ void output_function_impl(std::ostream &s, const CXXCodeGenOptions &options,
     s << std::endl << "}" << std::endl;
 }
 
+// variables in the module scope that can be dumped into a waveform
+std::vector<const slang::ValueSymbol *> get_dump_vars(const Module *mod) {
+    std::vector<const slang::ValueSymbol *> result;
+    for (auto const &member : mod->def()->body.members()) {
+        if (member.kind == slang::SymbolKind::Variable) {
+            auto const &var = member.as<slang::VariableSymbol>();
+            if (var.flags.has(slang::VariableFlags::CompilerGenerated)) continue;
+        } else if (member.kind != slang::SymbolKind::Net) {
+            continue;
+        }
+        auto const &var = member.as<slang::ValueSymbol>();
+        switch (var.getType().getCanonicalType().kind) {
+            case slang::SymbolKind::ScalarType:
+            case slang::SymbolKind::PredefinedIntegerType:
+            case slang::SymbolKind::PackedArrayType:
+                result.emplace_back(&var);
+                break;
+            default:
+                break;
+        }
+    }
+    return result;
+}
+
+void output_dump_vars(std::ostream &s, const Module *mod, const CXXCodeGenOptions &options,
+                      CodeGenModuleInformation &info) {
+    auto const &children = mod->child_instances;
+    s << "void " << info.get_identifier_name(mod->name)
+      << "::dump_vars(fsim::runtime::Dumper *dumper, uint64_t"
+      << (children.empty() ? "" : " levels") << ") {" << std::endl;
+    for (auto const *var : get_dump_vars(mod)) {
+        s << "dumper->add_var(" << info.get_identifier_name(var->name) << ", \"" << var->name
+          << "\");" << std::endl;
+    }
+    for (auto const &[name, inst] : children) {
+        if (!is_inlined(inst.get(), options)) {
+            s << "dumper->add_instance(" << name << ".get(), \"" << name << "\", levels);"
+              << std::endl;
+            continue;
+        }
+        // same as add_instance, but the variables are members of this class. aliased ports are
+        // dumped by the parent
+        auto const aliases = inst->get_port_aliases();
+        s << "if (levels != 1) {" << std::endl
+          << "dumper->push_scope(\"" << name << "\");" << std::endl;
+        for (auto const *var : get_dump_vars(inst.get())) {
+            if (aliases.contains(var)) continue;
+            s << "dumper->add_var(" << *info.get_inline_var_name(var) << ", \"" << var->name
+              << "\");" << std::endl;
+        }
+        s << "dumper->pop_scope();" << std::endl << "}" << std::endl;
+    }
+    s << "}" << std::endl;
+}
+
+// variables in the module scope that are saved into a checkpoint
+std::vector<const slang::ValueSymbol *> get_checkpoint_vars(const Module *mod) {
+    std::vector<const slang::ValueSymbol *> result;
+    for (auto const &member : mod->def()->body.members()) {
+        if (member.kind == slang::SymbolKind::Variable) {
+            auto const &var = member.as<slang::VariableSymbol>();
+            if (var.flags.has(slang::VariableFlags::CompilerGenerated)) continue;
+        } else if (member.kind != slang::SymbolKind::Net) {
+            continue;
+        }
+        result.emplace_back(&member.as<slang::ValueSymbol>());
+    }
+    return result;
+}
+
+void output_checkpoint_vars(std::ostream &s, const Module *mod, const CXXCodeGenOptions &options,
+                            CodeGenModuleInformation &info) {
+    s << "void " << info.get_identifier_name(mod->name)
+      << "::checkpoint_vars(fsim::runtime::Checkpoint *checkpoint) {" << std::endl;
+    for (auto const *var : get_checkpoint_vars(mod)) {
+        s << "checkpoint->add_var(" << info.get_identifier_name(var->name) << ", \"" << var->name
+          << "\");" << std::endl;
+    }
+    for (auto const &[name, inst] : mod->child_instances) {
+        if (!is_inlined(inst.get(), options)) {
+            s << name << "->checkpoint_vars(checkpoint);" << std::endl;
+            continue;
+        }
+        // variables of inlined instances are members of this class. aliased ports are saved by
+        // the parent
+        auto const aliases = inst->get_port_aliases();
+        for (auto const *var : get_checkpoint_vars(inst.get())) {
+            if (aliases.contains(var)) continue;
+            s << "checkpoint->add_var(" << *info.get_inline_var_name(var) << ", \"" << var->name
+              << "\");" << std::endl;
+        }
+    }
+    s << "}" << std::endl;
+}
+
+uint64_t get_process_complexity(const Process *process) {
+    ModuleComplexityVisitor v;
+    for (auto const *stmt : process->stmts) {
+        stmt->visit(v);
+    }
+    // processes without any statements still cost something to compile
+    return v.complexity + 1;
+}
+
+std::vector<CodeGenModuleInformation::ProcessChunk> get_process_chunks(
+    const std::vector<const Process *> &processes, const std::string &prefix,
+    uint64_t tu_complexity, CodeGenModuleInformation &info) {
+    std::vector<CodeGenModuleInformation::ProcessChunk> result;
+    uint64_t complexity = 0;
+    for (auto const *process : processes) {
+        auto process_complexity = get_process_complexity(process);
+        if (result.empty() || complexity + process_complexity > tu_complexity) {
+            result.emplace_back(
+                CodeGenModuleInformation::ProcessChunk{info.get_new_name(prefix), {}});
+            complexity = 0;
+        }
+        result.back().processes.emplace_back(process);
+        complexity += process_complexity;
+    }
+    return result;
+}
+
+template <typename T>
+std::vector<const Process *> get_processes(const std::vector<std::unique_ptr<T>> &processes) {
+    std::vector<const Process *> result;
+    result.reserve(processes.size());
+    for (auto const &process : processes) {
+        result.emplace_back(process.get());
+    }
+    return result;
+}
+
+void split_processes(const Module *mod, const CXXCodeGenOptions &options,
+                     CodeGenModuleInformation &info) {
+    // same cost as the module grouping in NinjaCodeGen
+    if (options.tu_complexity == 0 || mod->complexity() + 1 <= options.tu_complexity) return;
+    info.init_chunks = get_process_chunks(get_processes(mod->init_processes), "init_part",
+                                          options.tu_complexity, info);
+    info.comb_chunks = get_process_chunks(get_processes(mod->comb_processes), "comb_part",
+                                          options.tu_complexity, info);
+    std::vector<const Process *> ff_processes;
+    for (auto const &ff : mod->ff_processes) {
+        // batches are generated in ff() directly
+        if (!options.batch_ff || !ff->body) ff_processes.emplace_back(ff.get());
+    }
+    info.ff_chunks = get_process_chunks(ff_processes, "ff_part", options.tu_complexity, info);
+}
+
 void output_header_file(const std::filesystem::path &filename, const Module *mod,
                         const CXXCodeGenOptions &options, CodeGenModuleInformation &info) {
     // analyze the dependencies to include which headers
     std::stringstream s;
     s << "#pragma once" << std::endl;
-    s << raw_header_include;
+    s << prelude_include << raw_header_include;
 
     // output namespace
     s << "namespace fsim {" << std::endl;
 
     // forward declaration
-    bool has_ctor = !mod->child_instances.empty();
+    bool has_ctor = num_child_instances(mod, options) > 0;
     {
         std::set<std::string_view> class_names;
         for (auto const &iter : mod->child_instances) {
+            if (is_inlined(iter.second.get(), options)) continue;
             class_names.emplace(info.get_identifier_name(iter.second->name));
         }
         for (auto const &inst : class_names) {
@@ -393,6 +775,12 @@ void output_header_file(const std::filesystem::path &filename, const Module *mod
         for (auto const n : tracked_vars) {
             info.add_tracked_name(n);
         }
+        // only tracked variables can capture their value changes
+        if (options.dump_vars) {
+            for (auto const *var : get_dump_vars(mod)) {
+                info.add_tracked_name(var->name);
+            }
+        }
     }
 
     // all variables are public. although we can generate private for local variables
@@ -403,6 +791,21 @@ void output_header_file(const std::filesystem::path &filename, const Module *mod
         mod->def()->visit(decl_v);
     }
 
+    // variables of inlined instances, prefixed with the instance name
+    for (auto const &[name, inst] : mod->child_instances) {
+        if (!is_inlined(inst.get(), options)) continue;
+        info.inlined_instances.emplace(name);
+        InlineInstanceScope scope(info, inst.get(), name);
+        if (options.dump_vars) {
+            for (auto const *var : get_dump_vars(inst.get())) {
+                info.add_tracked_name(var->name);
+            }
+        }
+        ExprCodeGenVisitor expr_v(s, info);
+        VarDeclarationVisitor decl_v(s, options, info, expr_v);
+        inst->def()->visit(decl_v);
+    }
+
     // init function
     if (!mod->init_processes.empty()) {
         s << "void init(fsim::runtime::Scheduler *) override;" << std::endl;
@@ -416,12 +819,19 @@ void output_header_file(const std::filesystem::path &filename, const Module *mod
         s << "void comb(fsim::runtime::Scheduler *) override;" << std::endl;
     }
 
-    if (!mod->ff_processes.empty()) {
+    if (!mod->ff_processes.empty() || has_inlined_ff(mod, options)) {
         s << "void ff(fsim::runtime::Scheduler *) override;" << std::endl;
     }
 
+    if (options.dump_vars) {
+        s << "void dump_vars(fsim::runtime::Dumper *, uint64_t) override;" << std::endl;
+    }
+
+    s << "void checkpoint_vars(fsim::runtime::Checkpoint *) override;" << std::endl;
+
     // child instances
     for (auto const &[name, inst] : mod->child_instances) {
+        if (is_inlined(inst.get(), options)) continue;
         // we use shared ptr instead of unique ptr to avoid import the class header
         s << "std::shared_ptr<fsim::" << info.get_identifier_name(inst->name) << "> " << name << ";"
           << std::endl;
@@ -429,6 +839,21 @@ void output_header_file(const std::filesystem::path &filename, const Module *mod
 
     // private information
     { s << "private:" << std::endl; }
+    // levelized combinational processes
+    if (options.levelize_comb) {
+        for (auto const &comb : mod->comb_processes) {
+            if (!comb->levelized) continue;
+            s << "void " << info.get_process_function_name(comb.get())
+              << "(fsim::runtime::Process *, fsim::runtime::Scheduler *);" << std::endl;
+        }
+    }
+    // process setup of large modules
+    split_processes(mod, options, info);
+    for (auto const *chunks : {&info.init_chunks, &info.comb_chunks, &info.ff_chunks}) {
+        for (auto const &chunk : *chunks) {
+            s << "void " << chunk.function_name << "(fsim::runtime::Scheduler *);" << std::endl;
+        }
+    }
     // functions
     for (auto const &func : mod->functions) {
         if (func->is_module_scope()) {
@@ -446,43 +871,78 @@ void output_header_file(const std::filesystem::path &filename, const Module *mod
 
 void output_cc_file(const std::filesystem::path &filename, const Module *mod,
                     const CXXCodeGenOptions &options, CodeGenModuleInformation &info) {
-    std::stringstream s;
+    // shared by the part files
+    std::stringstream prologue;
     auto hh_filename = get_hh_filename(mod->name);
-    s << "#include \"" << hh_filename << "\"" << std::endl;
+    prologue << "#include \"" << hh_filename << "\"" << std::endl;
     // include more stuff
-    s << "#include \"runtime/scheduler.hh\"" << std::endl;
-    s << "#include \"runtime/macro.hh\"" << std::endl;
+    prologue << "#include \"runtime/scheduler.hh\"" << std::endl;
+    prologue << "#include \"runtime/macro.hh\"" << std::endl;
+    prologue << "#include \"runtime/checkpoint.hh\"" << std::endl;
 
     // vpi
     if (options.add_vpi()) {
-        s << "#include \"runtime/vpi.hh\"" << std::endl;
+        prologue << "#include \"runtime/vpi.hh\"" << std::endl;
     }
 
     // dpi
-    codegen_dpi_header(mod, s);
+    codegen_dpi_header(mod, prologue);
 
-    bool has_ctor = !mod->child_instances.empty();
-    if (has_ctor) {
-        output_ctor(s, mod, info);
-    } else {
-        // output name space
-        s << "namespace fsim {" << std::endl;
+    for (auto const &iter : mod->child_instances) {
+        if (is_inlined(iter.second.get(), options)) continue;
+        prologue << "#include \"" << iter.second->name << ".hh\"" << std::endl;
     }
 
+    // output name space
+    prologue << "namespace fsim {" << std::endl;
+
     // global functions, which has to be declared first
     for (auto const &func : mod->functions) {
         if (!func->is_module_scope()) {
-            output_function_decl(s, options, info, &func->subroutine);
+            output_function_decl(prologue, options, info, &func->subroutine);
         }
     }
 
+    std::stringstream s;
+    s << prologue.str();
+
+    bool has_ctor = num_child_instances(mod, options) > 0;
+    if (has_ctor) {
+        output_ctor(s, mod, options, info);
+    }
+
+    // each chunk of processes is set up in a part file. the caller stays in the module file
+    auto mod_name = info.get_identifier_name(mod->name);
+    std::vector<std::stringstream> parts;
+    std::unordered_map<const Process *, uint64_t> process_parts;
+    auto output_chunks = [&](const std::vector<CodeGenModuleInformation::ProcessChunk> &chunks,
+                             auto &&codegen) {
+        for (auto const &chunk : chunks) {
+            s << chunk.function_name << "(" << info.scheduler_name() << ");" << std::endl;
+            auto &part = parts.emplace_back();
+            part << prologue.str() << "void " << mod_name << "::" << chunk.function_name
+                 << "(fsim::runtime::Scheduler *" << info.scheduler_name() << ") {" << std::endl;
+            for (auto const *process : chunk.processes) {
+                codegen(part, process);
+                process_parts.emplace(process, parts.size() - 1);
+            }
+            part << "}" << std::endl;
+        }
+    };
+
     // initial block
     if (!mod->init_processes.empty()) {
         s << "void " << info.get_identifier_name(mod->name) << "::init(fsim::runtime::Scheduler *"
           << info.scheduler_name() << ") {" << std::endl;
 
-        for (auto const &init : mod->init_processes) {
-            codegen_init(s, init.get(), options, info);
+        if (info.init_chunks.empty()) {
+            for (auto const &init : mod->init_processes) {
+                codegen_init(s, init.get(), options, info);
+            }
+        } else {
+            output_chunks(info.init_chunks, [&](std::ostream &stream, const Process *process) {
+                codegen_init(stream, process, options, info);
+            });
         }
 
         if (!mod->child_instances.empty()) {
@@ -508,19 +968,47 @@ void output_cc_file(const std::filesystem::path &filename, const Module *mod,
         s << "}" << std::endl;
     }
 
+    if (options.dump_vars) {
+        output_dump_vars(s, mod, options, info);
+    }
+
+    output_checkpoint_vars(s, mod, options, info);
+
     // always block
     if (!mod->comb_processes.empty() || !mod->child_instances.empty()) {
         s << "void " << info.get_identifier_name(mod->name) << "::comb(fsim::runtime::Scheduler *"
           << info.scheduler_name() << ") {" << std::endl;
 
-        for (auto const &comb : mod->comb_processes) {
-            codegen_always(s, comb.get(), options, info);
+        if (info.comb_chunks.empty()) {
+            for (auto const &comb : mod->comb_processes) {
+                codegen_always(s, comb.get(), options, info);
+            }
+        } else {
+            output_chunks(info.comb_chunks, [&](std::ostream &stream, const Process *process) {
+                codegen_always(stream, static_cast<const CombProcess *>(process), options, info);
+            });
+        }
+
+        for (auto const &[name, inst] : mod->child_instances) {
+            if (!is_inlined(inst.get(), options)) continue;
+            // levels are computed per module, so inlined processes are not evaluated in parallel
+            // with the parent ones
+            auto inline_options = options;
+            inline_options.parallel_comb = false;
+            InlineInstanceScope scope(info, inst.get(), name);
+            for (auto const &comb : inst->comb_processes) {
+                codegen_always(s, comb.get(), inline_options, info);
+            }
         }
 
         for (auto const &iter : mod->child_instances) {
             codegen_port_connections(s, iter.second.get(), options, info);
         }
 
+        if (options.parallel_comb && num_child_instances(mod, options) > 1) {
+            s << "parallel_instances_ = true;" << std::endl;
+        }
+
         if (!mod->child_instances.empty()) {
             s << "Module::comb(scheduler);" << std::endl;
         }
@@ -529,12 +1017,27 @@ void output_cc_file(const std::filesystem::path &filename, const Module *mod,
     }
 
     // ff block
-    if (!mod->ff_processes.empty()) {
+    if (!mod->ff_processes.empty() || has_inlined_ff(mod, options)) {
         s << "void " << info.get_identifier_name(mod->name) << "::ff(fsim::runtime::Scheduler *"
           << info.scheduler_name() << ") {" << std::endl;
 
-        for (auto const &comb : mod->ff_processes) {
-            codegen_ff(s, comb.get(), options, info);
+        if (info.ff_chunks.empty()) {
+            codegen_ff_processes(s, mod, options, info);
+        } else {
+            output_chunks(info.ff_chunks, [&](std::ostream &stream, const Process *process) {
+                codegen_ff(stream, static_cast<const FFProcess *>(process), options, info);
+            });
+            if (options.batch_ff) {
+                for (auto const &batch : get_ff_batches(mod->ff_processes)) {
+                    codegen_ff_batch(s, batch, options, info);
+                }
+            }
+        }
+
+        for (auto const &[name, inst] : mod->child_instances) {
+            if (!is_inlined(inst.get(), options)) continue;
+            InlineInstanceScope scope(info, inst.get(), name);
+            codegen_ff_processes(s, inst.get(), options, info);
         }
 
         if (!mod->child_instances.empty()) {
@@ -545,7 +1048,17 @@ void output_cc_file(const std::filesystem::path &filename, const Module *mod,
     }
 
     // private functions
-    auto mod_name_prefix = fmt::format("{0}::", info.get_identifier_name(mod->name));
+    auto mod_name_prefix = fmt::format("{0}::", mod_name);
+    if (options.levelize_comb) {
+        for (auto const &comb : mod->comb_processes) {
+            if (!comb->levelized) continue;
+            // next to the process that calls it
+            auto it = process_parts.find(comb.get());
+            auto &stream = it == process_parts.end() ? s : parts[it->second];
+            codegen_levelized_always(stream, comb.get(), options, info, mod_name_prefix);
+        }
+    }
+
     for (auto const &func : mod->functions) {
         if (func->is_module_scope()) {
             output_function_impl(s, options, info, &func->subroutine, mod_name_prefix);
@@ -556,13 +1069,26 @@ void output_cc_file(const std::filesystem::path &filename, const Module *mod,
     s << "} // namespace fsim" << std::endl;
 
     write_to_file(filename.string(), s);
+
+    auto dir = filename.parent_path();
+    for (auto i = 0u; i < parts.size(); i++) {
+        parts[i] << "} // namespace fsim" << std::endl;
+        auto part_filename = dir / get_cc_filename(get_part_name(mod->name, i + 1));
+        write_to_file(part_filename.string(), parts[i]);
+    }
+    // parts left over from the last build
+    for (auto i = parts.size() + 1;; i++) {
+        auto part_filename = dir / get_cc_filename(get_part_name(mod->name, i));
+        if (!std::filesystem::exists(part_filename)) break;
+        std::filesystem::remove(part_filename);
+    }
 }
 
 void output_main_file(const std::string &filename, const Module *top,
                       const CXXCodeGenOptions &options, CodeGenModuleInformation &info) {
     std::stringstream s;
 
-    s << raw_header_include;
+    s << prelude_include << raw_header_include;
 
     // include the scheduler
     s << "#include \"runtime/scheduler.hh\"" << std::endl;
@@ -572,6 +1098,9 @@ void output_main_file(const std::string &filename, const Module *top,
     // VPI
     if (options.add_vpi()) {
         s << "#include \"runtime/vpi.hh\"" << std::endl;
+    } else {
+        // VPI controller is a singleton, so batch mode is only available without VPI
+        s << "#include \"runtime/batch.hh\"" << std::endl;
     }
 
     // include the top module file
@@ -591,8 +1120,25 @@ void output_main_file(const std::string &filename, const Module *top,
 
     s << "int main(int argc, char *argv[]) {" << std::endl;
 
-    s << "    fsim::runtime::Scheduler scheduler;" << std::endl
-      << "    fsim::" << info.get_identifier_name(top->name) << " top;" << std::endl;
+    auto top_name = info.get_identifier_name(top->name);
+    if (!options.add_vpi()) {
+        // every instance gets its own copy of the top module and scheduler
+        s << "    fsim::runtime::Batch batch(argc, argv);" << std::endl
+          << "    if (batch.enabled()) {" << std::endl
+          << "        batch.run([]() { return std::make_unique<fsim::" << top_name << ">(); }";
+        if (options.dirty_propagation) {
+            s << ", [](fsim::runtime::Scheduler &scheduler) { "
+              << "scheduler.set_dirty_propagation(true); }";
+        }
+        s << ");" << std::endl << "        return 0;" << std::endl << "    }" << std::endl;
+    }
+
+    s << "    fsim::runtime::Scheduler scheduler(argc, argv);" << std::endl
+      << "    fsim::" << top_name << " top;" << std::endl;
+
+    if (options.dirty_propagation) {
+        s << "    scheduler.set_dirty_propagation(true);" << std::endl;
+    }
 
     // vpi
     if (options.add_vpi()) {
@@ -614,6 +1160,7 @@ void CXXCodeGen::output(const std::string &dir) {
     auto cc_filename = dir_path / get_cc_filename(top_->name);
     auto hh_filename = dir_path / get_hh_filename(top_->name);
     info_.current_module = top_;
+    info_.native_2state = !option_.use_4state;
     output_header_file(hh_filename, top_, option_, info_);
     output_cc_file(cc_filename, top_, option_, info_);
 }
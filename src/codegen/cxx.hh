@@ -7,6 +7,24 @@
 namespace fsim {
 struct CXXCodeGenOptions {
     bool use_4state = true;
+    // evaluate combinational processes without timing control directly instead of using fibers
+    bool levelize_comb = false;
+    // evaluate independent combinational processes and child instances in parallel
+    bool parallel_comb = false;
+    // merge always_ff blocks without timing control inside into one process per edge list
+    bool batch_ff = false;
+    // generate processes of leaf instances whose complexity is no more than the threshold inside
+    // their parent module. 0 turns off inlining
+    uint64_t inline_threshold = 0;
+    // trigger combinational processes from a per-signal dirty bitmap once per delta cycle instead
+    // of on every write
+    bool dirty_propagation = false;
+    // track every module variable and generate Module::dump_vars for waveform dumping
+    bool dump_vars = false;
+    // processes of modules whose complexity exceeds the threshold are set up in part files of
+    // about the same complexity, <name>.1.cc, <name>.2.cc etc., to keep translation units small.
+    // 0 turns off splitting
+    uint64_t tu_complexity = 0;
     std::vector<std::string> vpi_libs;
 
     [[nodiscard]] bool add_vpi() const { return !vpi_libs.empty(); }
@@ -7,8 +7,10 @@
 namespace fsim {
 
 auto constexpr fsim_schedule_nba = "SCHEDULE_NBA";
+auto constexpr fsim_schedule_nba_var = "SCHEDULE_NBA_VAR";
 auto constexpr fsim_next_time = "fsim_next_time";
 auto constexpr fsim_schedule_delay = "SCHEDULE_DELAY";
+auto constexpr fsim_schedule_resumable_delay = "SCHEDULE_RESUMABLE_DELAY";
 
 const slang::Symbol *get_parent_symbol(const slang::Symbol *symbol,
                                        std::vector<std::string_view> &paths) {
@@ -52,6 +54,16 @@ const slang::Symbol *get_parent_symbol(const slang::Symbol *symbol,
 }
 
 [[maybe_unused]] void ExprCodeGenVisitor::handle(const slang::ValueSymbol &sym) {
+    if (auto const *alias = module_info_.get_port_alias(&sym)) {
+        // port of an inlined instance directly uses the parent variable
+        s << module_info_.get_identifier_name(alias->name);
+        return;
+    }
+    if (auto const *name = module_info_.get_inline_var_name(&sym)) {
+        // variable of an inlined instance, which is a member of the parent class
+        s << *name;
+        return;
+    }
     // if the current symbol is not null, we need to resolve the hierarchy
     auto const *parent = &sym.getParentScope()->asSymbol();
     auto const *top_body =
@@ -123,6 +135,10 @@ const slang::Symbol *get_parent_symbol(const slang::Symbol *symbol,
 }
 
 [[maybe_unused]] void ExprCodeGenVisitor::handle(const slang::UnaryExpression &expr) {
+    if (is_native(expr)) {
+        output_native_root(expr);
+        return;
+    }
     auto const &op = expr.operand();
     s << "(";
     // simple ones that have C++ operator overloaded
@@ -200,6 +216,10 @@ const slang::Symbol *get_parent_symbol(const slang::Symbol *symbol,
 }
 
 [[maybe_unused]] void ExprCodeGenVisitor::handle(const slang::BinaryExpression &expr) {
+    if (is_native(expr)) {
+        output_native_root(expr);
+        return;
+    }
     auto const &left = expr.left();
     auto const &right = expr.right();
     s << "(";
@@ -287,6 +307,10 @@ const slang::Symbol *get_parent_symbol(const slang::Symbol *symbol,
 }
 
 void ExprCodeGenVisitor::handle(const slang::ConditionalExpression &expr) {
+    if (is_native(expr)) {
+        output_native_root(expr);
+        return;
+    }
     expr.pred().visit(*this);
     s << "? (";
     expr.left().visit(*this);
@@ -393,12 +417,19 @@ void ExprCodeGenVisitor::handle(const slang::RangeSelectExpression &expr) {
         // remove the leading $
         auto name = info.subroutine->name.substr(1);
         auto func_name = fmt::format("fsim::runtime::{0}", name);
+        // e.g. $test$plusargs
+        std::replace(func_name.begin(), func_name.end(), '$', '_');
+        if (name == "dumpvars") {
+            output_dumpvars(expr);
+            return;
+        }
         s << func_name << "(";
         // depends on the context, we may or may not insert additional arguments
-        if (name == "finish" || name == "time") {
+        if (name == "finish" || name == "time" || name == "test$plusargs" ||
+            name == "dumpfile" || name == "dumpon" || name == "dumpoff" || name == "save") {
             s << module_info_.scheduler_name();
         } else {
-            s << "this";
+            s << module_info_.module_pointer();
         }
 
         auto const &arguments = expr.arguments();
@@ -454,6 +485,83 @@ void ExprCodeGenVisitor::handle(const slang::RangeSelectExpression &expr) {
     }
 }
 
+void ExprCodeGenVisitor::output_dumpvars(const slang::CallExpression &expr) {
+    // LRM 21.7.1.2. each scope is dumped by its own call
+    auto const &arguments = expr.arguments();
+    auto const &scheduler = module_info_.scheduler_name();
+    if (arguments.size() <= 1) {
+        s << "fsim::runtime::dumpvars(" << scheduler;
+        if (!arguments.empty()) {
+            s << ", ";
+            arguments[0]->visit(*this);
+        }
+        s << ")";
+        return;
+    }
+
+    auto const *current = module_info_.current_module;
+    auto module = module_info_.module_pointer();
+    for (auto i = 1u; i < arguments.size(); i++) {
+        auto const &arg = *arguments[i];
+        const slang::Symbol *sym = nullptr;
+        if (arg.kind == slang::ExpressionKind::ArbitrarySymbol) {
+            sym = arg.as<slang::ArbitrarySymbolExpression>().symbol;
+        }
+        if (!sym || sym->kind != slang::SymbolKind::Instance) {
+            throw NotSupportedException("Only module instances can be used as $dumpvars scope",
+                                        arg.sourceRange.start());
+        }
+        // the runtime module doesn't know its instance name, so the scope name is computed here
+        std::string scope, scope_name;
+        if (sym == current->def()) {
+            scope = module;
+            scope_name = fmt::format("{0}->hierarchy_name()", module);
+        } else if (module_info_.inlined_instances.contains(sym->name)) {
+            throw NotSupportedException("$dumpvars scope can't be an inlined instance",
+                                        arg.sourceRange.start());
+        } else if (current->child_instances.contains(std::string(sym->name))) {
+            scope = fmt::format("{0}->{1}.get()", module, sym->name);
+            scope_name = fmt::format("{0}->hierarchy_name() + \".{1}\"", module, sym->name);
+        } else {
+            throw NotSupportedException(
+                "$dumpvars scope has to be the current instance or its child instance",
+                arg.sourceRange.start());
+        }
+
+        if (i != 1) s << ", ";
+        s << "fsim::runtime::dumpvars(" << scheduler << ", ";
+        arguments[0]->visit(*this);
+        s << ", " << scope << ", " << scope_name << ")";
+    }
+}
+
+// the variable a select NBA writes to. a non-constant index is only evaluated when the NBA is
+// committed and may read a variable committed by another shard, so such selects have no known
+// target and are committed serially
+const slang::NamedValueExpression *get_select_var(const slang::Expression &expr) {
+    auto const *e = &expr;
+    while (true) {
+        switch (e->kind) {
+            case slang::ExpressionKind::NamedValue:
+                return &e->as<slang::NamedValueExpression>();
+            case slang::ExpressionKind::ElementSelect: {
+                auto const &select = e->as<slang::ElementSelectExpression>();
+                if (!select.selector().constant) return nullptr;
+                e = &select.value();
+                break;
+            }
+            case slang::ExpressionKind::RangeSelect: {
+                auto const &select = e->as<slang::RangeSelectExpression>();
+                if (!select.left().constant || !select.right().constant) return nullptr;
+                e = &select.value();
+                break;
+            }
+            default:
+                return nullptr;
+        }
+    }
+}
+
 [[maybe_unused]] void ExprCodeGenVisitor::handle(const slang::AssignmentExpression &expr) {
     auto const *timing = expr.timingControl;
     if (expr.isNonBlocking()) {
@@ -486,8 +594,22 @@ void ExprCodeGenVisitor::handle(const slang::RangeSelectExpression &expr) {
                 s << ";";
                 output_timing(*timing);
             }
-            s << fsim_schedule_nba << "(";
-            left.visit(*this);
+            if (left.kind == slang::ExpressionKind::NamedValue) {
+                s << fsim_schedule_nba << "(";
+                left.visit(*this);
+            } else {
+                // selects are grouped by the variable they select from during NBA commit
+                s << fsim_schedule_nba_var << "((";
+                left.visit(*this);
+                s << "), ";
+                auto const *var = get_select_var(left);
+                if (var) {
+                    s << "&";
+                    var->visit(*this);
+                } else {
+                    s << "nullptr";
+                }
+            }
             // put extra paraphrases to escape , in macro.
             // typically, what happens is slice<a, b> is treated as two arguments
             // since we're no declaring types here, it should be fine
@@ -569,21 +691,531 @@ bool ExprCodeGenVisitor::is_return_symbol(const slang::Expression &expr) const {
     return named.symbol.name == module_info_.current_function->name;
 }
 
+// wider values are stored as 64-bit words and computed by SIMD kernels
+constexpr uint64_t max_native_width = 4096;
+
+bool is_native_type(const slang::Type &type) {
+    if (!type.isSimpleBitVector()) return false;
+    auto width = type.getBitWidth();
+    if (width == 0 || width > max_native_width) return false;
+    if (width <= 64) return true;
+    // words are sliced out from bit 0
+    auto range = type.getFixedRange();
+    return range.lower() == 0 && range.isLittleEndian();
+}
+
+bool is_wide_type(const slang::Type &type) { return type.getBitWidth() > 64; }
+
+bool is_native_wide_binary_op(const slang::BinaryExpression &binary) {
+    auto width = binary.type->getBitWidth();
+    auto left_width = binary.left().type->getBitWidth();
+    auto right_width = binary.right().type->getBitWidth();
+    switch (binary.op) {
+        case slang::BinaryOperator::Add:
+        case slang::BinaryOperator::Subtract:
+        case slang::BinaryOperator::BinaryAnd:
+        case slang::BinaryOperator::BinaryOr:
+        case slang::BinaryOperator::BinaryXor:
+            return left_width == width && right_width == width;
+        case slang::BinaryOperator::Equality:
+        case slang::BinaryOperator::Inequality:
+        case slang::BinaryOperator::CaseEquality:
+        case slang::BinaryOperator::CaseInequality:
+            return left_width == right_width;
+        case slang::BinaryOperator::LogicalAnd:
+        case slang::BinaryOperator::LogicalOr:
+            return true;
+        case slang::BinaryOperator::ArithmeticShiftRight:
+            if (binary.type->isSigned()) return false;
+            [[fallthrough]];
+        case slang::BinaryOperator::LogicalShiftLeft:
+        case slang::BinaryOperator::LogicalShiftRight:
+        case slang::BinaryOperator::ArithmeticShiftLeft:
+            return left_width == width && !is_wide_type(*binary.right().type);
+        default:
+            // multiplication and relational operators on wide values use the logic library
+            return false;
+    }
+}
+
+bool is_native_unary_op(slang::UnaryOperator op) {
+    switch (op) {
+        case slang::UnaryOperator::Plus:
+        case slang::UnaryOperator::Minus:
+        case slang::UnaryOperator::BitwiseNot:
+        case slang::UnaryOperator::LogicalNot:
+        case slang::UnaryOperator::BitwiseAnd:
+        case slang::UnaryOperator::BitwiseOr:
+        case slang::UnaryOperator::BitwiseXor:
+        case slang::UnaryOperator::BitwiseNand:
+        case slang::UnaryOperator::BitwiseNor:
+        case slang::UnaryOperator::BitwiseXnor:
+            return true;
+        default:
+            // increment and decrement have side effects
+            return false;
+    }
+}
+
+bool is_native_binary_op(slang::BinaryOperator op) {
+    switch (op) {
+        case slang::BinaryOperator::Add:
+        case slang::BinaryOperator::Subtract:
+        case slang::BinaryOperator::Multiply:
+        case slang::BinaryOperator::BinaryAnd:
+        case slang::BinaryOperator::BinaryOr:
+        case slang::BinaryOperator::BinaryXor:
+        case slang::BinaryOperator::Equality:
+        case slang::BinaryOperator::Inequality:
+        case slang::BinaryOperator::CaseEquality:
+        case slang::BinaryOperator::CaseInequality:
+        case slang::BinaryOperator::LogicalAnd:
+        case slang::BinaryOperator::LogicalOr:
+        case slang::BinaryOperator::LessThan:
+        case slang::BinaryOperator::LessThanEqual:
+        case slang::BinaryOperator::GreaterThan:
+        case slang::BinaryOperator::GreaterThanEqual:
+        case slang::BinaryOperator::LogicalShiftLeft:
+        case slang::BinaryOperator::LogicalShiftRight:
+        case slang::BinaryOperator::ArithmeticShiftLeft:
+        case slang::BinaryOperator::ArithmeticShiftRight:
+            return true;
+        default:
+            // division by zero needs the logic library
+            return false;
+    }
+}
+
+bool ExprCodeGenVisitor::is_native(const slang::Expression &expr) const {
+    if (!module_info_.native_2state || !is_native_type(*expr.type)) return false;
+    switch (expr.kind) {
+        case slang::ExpressionKind::UnaryOp: {
+            auto const &unary = expr.as<slang::UnaryExpression>();
+            return is_native_unary_op(unary.op) && is_native_type(*unary.operand().type);
+        }
+        case slang::ExpressionKind::BinaryOp: {
+            auto const &binary = expr.as<slang::BinaryExpression>();
+            if (!is_native_binary_op(binary.op) || !is_native_type(*binary.left().type) ||
+                !is_native_type(*binary.right().type)) {
+                return false;
+            }
+            auto wide = is_wide_type(*expr.type) || is_wide_type(*binary.left().type) ||
+                        is_wide_type(*binary.right().type);
+            return !wide || is_native_wide_binary_op(binary);
+        }
+        case slang::ExpressionKind::ConditionalOp: {
+            auto const &cond = expr.as<slang::ConditionalExpression>();
+            return is_native_type(*cond.pred().type) && is_native_type(*cond.left().type) &&
+                   is_native_type(*cond.right().type);
+        }
+        default:
+            return false;
+    }
+}
+
+void ExprCodeGenVisitor::output_native_root(const slang::Expression &expr) {
+    auto const &type = *expr.type;
+    if (is_wide_type(type)) {
+        s << "fsim::runtime::native::to_bit<" << type.getBitWidth() << ">(";
+        output_native(expr);
+        s << ")";
+        if (type.isSigned()) s << ".to_signed()";
+        return;
+    }
+    s << "logic::bit<" << type.getBitWidth() - 1 << ", 0, " << (type.isSigned() ? "true" : "false")
+      << ">(";
+    output_native(expr);
+    s << ")";
+}
+
+void ExprCodeGenVisitor::output_native(const slang::Expression &expr) {
+    auto width = expr.type->getBitWidth();
+    switch (expr.kind) {
+        case slang::ExpressionKind::IntegerLiteral: {
+            auto const &value = expr.as<slang::IntegerLiteral>().getValue();
+            if (is_wide_type(*expr.type)) {
+                // little-endian words, same as the runtime layout
+                auto value_width = value.getBitWidth();
+                s << "fsim::runtime::native::Wide<" << width << ">{{";
+                for (auto i = 0u; i < (width + 63) / 64; i++) {
+                    uint64_t word = 0;
+                    if (i * 64 < value_width) {
+                        auto bits = std::min<uint32_t>(64, value_width - i * 64);
+                        word = value.lshr(i * 64).trunc(bits).as<uint64_t>().value_or(0);
+                    }
+                    if (i) s << ", ";
+                    s << word << "ull";
+                }
+                s << "}}";
+                return;
+            }
+            auto word = value.as<uint64_t>();
+            s << (word ? *word : 0) << "ull";
+            return;
+        }
+        case slang::ExpressionKind::UnaryOp: {
+            if (!is_native(expr)) break;
+            auto const &unary = expr.as<slang::UnaryExpression>();
+            auto const &op = unary.operand();
+            auto op_width = op.type->getBitWidth();
+            if (is_wide_type(*op.type)) {
+                output_native_wide(unary);
+                return;
+            }
+            s << "(";
+            switch (unary.op) {
+                case slang::UnaryOperator::Plus:
+                    output_native(op);
+                    break;
+                case slang::UnaryOperator::Minus:
+                    s << "fsim::runtime::native::trunc(0 - ";
+                    output_native(op);
+                    s << ", " << width << ")";
+                    break;
+                case slang::UnaryOperator::BitwiseNot:
+                    s << "fsim::runtime::native::trunc(~";
+                    output_native(op);
+                    s << ", " << width << ")";
+                    break;
+                case slang::UnaryOperator::LogicalNot:
+                case slang::UnaryOperator::BitwiseNor:
+                    s << "static_cast<uint64_t>(";
+                    output_native(op);
+                    s << " == 0)";
+                    break;
+                case slang::UnaryOperator::BitwiseOr:
+                    s << "static_cast<uint64_t>(";
+                    output_native(op);
+                    s << " != 0)";
+                    break;
+                case slang::UnaryOperator::BitwiseAnd:
+                case slang::UnaryOperator::BitwiseNand:
+                    s << "static_cast<uint64_t>(";
+                    output_native(op);
+                    s << (unary.op == slang::UnaryOperator::BitwiseAnd ? " == " : " != ")
+                      << "fsim::runtime::native::mask(" << op_width << "))";
+                    break;
+                case slang::UnaryOperator::BitwiseXor:
+                case slang::UnaryOperator::BitwiseXnor:
+                    s << "fsim::runtime::native::r_xor(";
+                    output_native(op);
+                    s << ")";
+                    if (unary.op == slang::UnaryOperator::BitwiseXnor) s << " ^ 1";
+                    break;
+                default:
+                    break;
+            }
+            s << ")";
+            return;
+        }
+        case slang::ExpressionKind::BinaryOp: {
+            if (!is_native(expr)) break;
+            auto const &binary = expr.as<slang::BinaryExpression>();
+            auto const &left = binary.left();
+            auto const &right = binary.right();
+            if (is_wide_type(*expr.type) || is_wide_type(*left.type)) {
+                output_native_wide(binary);
+                return;
+            }
+            auto is_signed = left.type->isSigned() && right.type->isSigned();
+            // function name or operator, and whether the result needs to be truncated
+            auto output_op = [&](std::string_view op, bool truncate) {
+                if (truncate) s << "fsim::runtime::native::trunc(";
+                s << "(";
+                output_native(left);
+                s << op;
+                output_native(right);
+                s << ")";
+                if (truncate) s << ", " << width << ")";
+            };
+            auto output_cmp = [&](std::string_view op) {
+                s << "static_cast<uint64_t>(";
+                if (is_signed) {
+                    s << "fsim::runtime::native::sext(";
+                    output_native(left);
+                    s << ", " << left.type->getBitWidth() << ")" << op
+                      << "fsim::runtime::native::sext(";
+                    output_native(right);
+                    s << ", " << right.type->getBitWidth() << ")";
+                } else {
+                    output_native(left);
+                    s << op;
+                    output_native(right);
+                }
+                s << ")";
+            };
+            auto output_shift = [&](std::string_view func, bool with_width) {
+                s << "fsim::runtime::native::" << func << "(";
+                output_native(left);
+                s << ", ";
+                output_native(right);
+                if (with_width) s << ", " << width;
+                s << ")";
+            };
+            switch (binary.op) {
+                case slang::BinaryOperator::Add:
+                    output_op(" + ", true);
+                    break;
+                case slang::BinaryOperator::Subtract:
+                    output_op(" - ", true);
+                    break;
+                case slang::BinaryOperator::Multiply:
+                    output_op(" * ", true);
+                    break;
+                case slang::BinaryOperator::BinaryAnd:
+                    output_op(" & ", false);
+                    break;
+                case slang::BinaryOperator::BinaryOr:
+                    output_op(" | ", false);
+                    break;
+                case slang::BinaryOperator::BinaryXor:
+                    output_op(" ^ ", false);
+                    break;
+                case slang::BinaryOperator::Equality:
+                case slang::BinaryOperator::CaseEquality:
+                    output_cmp(" == ");
+                    break;
+                case slang::BinaryOperator::Inequality:
+                case slang::BinaryOperator::CaseInequality:
+                    output_cmp(" != ");
+                    break;
+                case slang::BinaryOperator::LessThan:
+                    output_cmp(" < ");
+                    break;
+                case slang::BinaryOperator::LessThanEqual:
+                    output_cmp(" <= ");
+                    break;
+                case slang::BinaryOperator::GreaterThan:
+                    output_cmp(" > ");
+                    break;
+                case slang::BinaryOperator::GreaterThanEqual:
+                    output_cmp(" >= ");
+                    break;
+                case slang::BinaryOperator::LogicalAnd:
+                case slang::BinaryOperator::LogicalOr:
+                    s << "static_cast<uint64_t>(fsim::runtime::native::is_true(";
+                    output_native(left);
+                    s << ")" << (binary.op == slang::BinaryOperator::LogicalAnd ? " && " : " || ")
+                      << "fsim::runtime::native::is_true(";
+                    output_native(right);
+                    s << "))";
+                    break;
+                case slang::BinaryOperator::LogicalShiftLeft:
+                case slang::BinaryOperator::ArithmeticShiftLeft:
+                    output_shift("shl", true);
+                    break;
+                case slang::BinaryOperator::LogicalShiftRight:
+                    output_shift("shr", false);
+                    break;
+                case slang::BinaryOperator::ArithmeticShiftRight:
+                    if (expr.type->isSigned()) {
+                        output_shift("ashr", true);
+                    } else {
+                        output_shift("shr", false);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            return;
+        }
+        case slang::ExpressionKind::ConditionalOp: {
+            if (!is_native(expr)) break;
+            auto const &cond = expr.as<slang::ConditionalExpression>();
+            s << "(fsim::runtime::native::is_true(";
+            output_native(cond.pred());
+            s << ") ? ";
+            output_native(cond.left());
+            s << " : ";
+            output_native(cond.right());
+            s << ")";
+            return;
+        }
+        case slang::ExpressionKind::Conversion: {
+            auto const &conversion = expr.as<slang::ConversionExpression>();
+            auto const &op = conversion.operand();
+            if (!is_native_type(*op.type)) break;
+            auto op_width = op.type->getBitWidth();
+            if (is_wide_type(*expr.type)) {
+                // narrow values are extended into words, wide values are resized
+                s << "fsim::runtime::native::extend<" << width << ">(";
+                output_native(op);
+                if (!is_wide_type(*op.type)) s << ", " << op_width;
+                s << ", " << (op.type->isSigned() ? "true" : "false") << ")";
+            } else if (is_wide_type(*op.type)) {
+                s << "fsim::runtime::native::trunc(";
+                output_native(op);
+                s << ", " << width << ")";
+            } else if (op_width < width && op.type->isSigned()) {
+                s << "fsim::runtime::native::trunc(static_cast<uint64_t>("
+                  << "fsim::runtime::native::sext(";
+                output_native(op);
+                s << ", " << op_width << ")), " << width << ")";
+            } else if (op_width > width) {
+                s << "fsim::runtime::native::trunc(";
+                output_native(op);
+                s << ", " << width << ")";
+            } else {
+                output_native(op);
+            }
+            return;
+        }
+        case slang::ExpressionKind::Concatenation: {
+            auto const &operands = expr.as<slang::ConcatenationExpression>().operands();
+            auto native = std::all_of(operands.begin(), operands.end(),
+                                      [](auto const *op) { return is_native_type(*op->type); });
+            if (!native || is_wide_type(*expr.type)) break;
+            uint64_t shift = width;
+            s << "(";
+            for (auto i = 0u; i < operands.size(); i++) {
+                shift -= operands[i]->type->getBitWidth();
+                s << "(";
+                output_native(*operands[i]);
+                s << " << " << shift << ")";
+                if (i != (operands.size() - 1)) s << " | ";
+            }
+            s << ")";
+            return;
+        }
+        default:
+            break;
+    }
+    // anything else is computed by the logic library
+    if (is_wide_type(*expr.type)) {
+        s << "fsim::runtime::native::wide_value<" << width << ">(";
+        expr.visit(*this);
+        s << ")";
+    } else {
+        s << "fsim::runtime::native::value(";
+        expr.visit(*this);
+        s << ", " << width << ")";
+    }
+}
+
+void ExprCodeGenVisitor::output_native_wide(const slang::UnaryExpression &unary) {
+    auto const &op = unary.operand();
+    auto output_call = [&](std::string_view func) {
+        s << "fsim::runtime::native::" << func << "(";
+        output_native(op);
+        s << ")";
+    };
+    s << "(";
+    switch (unary.op) {
+        case slang::UnaryOperator::Plus:
+            output_native(op);
+            break;
+        case slang::UnaryOperator::Minus:
+            s << "fsim::runtime::native::sub(fsim::runtime::native::Wide<"
+              << op.type->getBitWidth() << ">{}, ";
+            output_native(op);
+            s << ")";
+            break;
+        case slang::UnaryOperator::BitwiseNot:
+            output_call("bit_not");
+            break;
+        case slang::UnaryOperator::LogicalNot:
+        case slang::UnaryOperator::BitwiseNor:
+            s << "static_cast<uint64_t>(!";
+            output_call("is_true");
+            s << ")";
+            break;
+        case slang::UnaryOperator::BitwiseOr:
+            s << "static_cast<uint64_t>(";
+            output_call("is_true");
+            s << ")";
+            break;
+        case slang::UnaryOperator::BitwiseAnd:
+        case slang::UnaryOperator::BitwiseNand:
+            output_call("r_and");
+            if (unary.op == slang::UnaryOperator::BitwiseNand) s << " ^ 1";
+            break;
+        case slang::UnaryOperator::BitwiseXor:
+        case slang::UnaryOperator::BitwiseXnor:
+            output_call("r_xor");
+            if (unary.op == slang::UnaryOperator::BitwiseXnor) s << " ^ 1";
+            break;
+        default:
+            break;
+    }
+    s << ")";
+}
+
+void ExprCodeGenVisitor::output_native_wide(const slang::BinaryExpression &binary) {
+    auto const &left = binary.left();
+    auto const &right = binary.right();
+    auto output_call = [&](std::string_view func) {
+        s << "fsim::runtime::native::" << func << "(";
+        output_native(left);
+        s << ", ";
+        output_native(right);
+        s << ")";
+    };
+    switch (binary.op) {
+        case slang::BinaryOperator::Add:
+            output_call("add");
+            break;
+        case slang::BinaryOperator::Subtract:
+            output_call("sub");
+            break;
+        case slang::BinaryOperator::BinaryAnd:
+            output_call("bit_and");
+            break;
+        case slang::BinaryOperator::BinaryOr:
+            output_call("bit_or");
+            break;
+        case slang::BinaryOperator::BinaryXor:
+            output_call("bit_xor");
+            break;
+        case slang::BinaryOperator::Equality:
+        case slang::BinaryOperator::CaseEquality:
+            output_call("eq");
+            break;
+        case slang::BinaryOperator::Inequality:
+        case slang::BinaryOperator::CaseInequality:
+            s << "(";
+            output_call("eq");
+            s << " ^ 1)";
+            break;
+        case slang::BinaryOperator::LogicalAnd:
+        case slang::BinaryOperator::LogicalOr:
+            s << "static_cast<uint64_t>(fsim::runtime::native::is_true(";
+            output_native(left);
+            s << ")" << (binary.op == slang::BinaryOperator::LogicalAnd ? " && " : " || ")
+              << "fsim::runtime::native::is_true(";
+            output_native(right);
+            s << "))";
+            break;
+        case slang::BinaryOperator::LogicalShiftLeft:
+        case slang::BinaryOperator::ArithmeticShiftLeft:
+            output_call("shl");
+            break;
+        case slang::BinaryOperator::LogicalShiftRight:
+        case slang::BinaryOperator::ArithmeticShiftRight:
+            output_call("shr");
+            break;
+        default:
+            break;
+    }
+}
+
 TimingControlCodeGen::TimingControlCodeGen(std::ostream &s, CodeGenModuleInformation &module_info,
                                            ExprCodeGenVisitor &expr_v)
     : s(s), module_info_(module_info), expr_v(expr_v) {}
 
-void TimingControlCodeGen::handle(const slang::TimingControl &timing) {
+void TimingControlCodeGen::handle(const slang::TimingControl &timing, uint32_t resume_point) {
     switch (timing.kind) {
         case slang::TimingControlKind::Delay: {
             // we first release the current condition holds
             auto const &delay = timing.as<slang::DelayControl>();
 
-            s << fmt::format("{0}({1}, (", fsim_schedule_delay,
+            s << fmt::format("{0}({1}, (",
+                             resume_point ? fsim_schedule_resumable_delay : fsim_schedule_delay,
                              module_info_.current_process_name());
             delay.expr.visit(expr_v);
-            s << fmt::format(").to_uint64(), {0}, {1});", module_info_.scheduler_name(),
+            s << fmt::format(").to_uint64(), {0}, {1}", module_info_.scheduler_name(),
                              module_info_.get_new_name(fsim_next_time, false));
+            if (resume_point) s << ", " << resume_point;
+            s << ");";
             break;
         }
         case slang::TimingControlKind::SignalEvent: {
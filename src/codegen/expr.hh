@@ -52,6 +52,16 @@ private:
     void output_timing(const slang::TimingControl &timing);
 
     [[nodiscard]] bool is_return_symbol(const slang::Expression &expr) const;
+
+    void output_dumpvars(const slang::CallExpression &expr);
+
+    // 2-state expressions that fit into 64 bits are computed with native integer operations.
+    // wider ones are computed word by word with SIMD kernels
+    [[nodiscard]] bool is_native(const slang::Expression &expr) const;
+    void output_native_root(const slang::Expression &expr);
+    void output_native(const slang::Expression &expr);
+    void output_native_wide(const slang::UnaryExpression &unary);
+    void output_native_wide(const slang::BinaryExpression &binary);
 };
 
 class TimingControlCodeGen {
@@ -59,7 +69,8 @@ public:
     TimingControlCodeGen(std::ostream &s, CodeGenModuleInformation &module_info,
                          ExprCodeGenVisitor &expr_v);
 
-    void handle(const slang::TimingControl &timing);
+    // a non-zero resume point marks a delay that a restored process can restart from
+    void handle(const slang::TimingControl &timing, uint32_t resume_point = 0);
 
 private:
     std::ostream &s;
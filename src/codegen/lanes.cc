@@ -0,0 +1,850 @@
+#include "lanes.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+
+#include "../ir/except.hh"
+
+namespace fsim {
+
+auto constexpr lanes_ns = "fsim::runtime::lanes::";
+// same limit as native 2-state expressions
+constexpr uint64_t max_lanes_width = 4096;
+// combinational loops that never settle are cut off after this many passes
+constexpr uint64_t max_comb_iterations = 1024;
+
+uint64_t get_lanes_width(const slang::Type &type, const slang::SourceLocation &loc) {
+    if (!type.isIntegral()) {
+        throw NotSupportedException("Lane-parallel simulation only supports packed types", loc);
+    }
+    auto width = type.getBitWidth();
+    if (width == 0 || width > max_lanes_width) {
+        throw NotSupportedException(
+            fmt::format("Width {0} not supported in lane-parallel simulation", width), loc);
+    }
+    return width;
+}
+
+std::string get_lanes_type(uint64_t width) {
+    return fmt::format("{0}Lanes<{1}>", lanes_ns, width);
+}
+
+int64_t get_lanes_index(const slang::Expression &expr) {
+    if (!expr.constant || !expr.constant->isInteger()) {
+        throw NotSupportedException("Only constant select supported in lane-parallel simulation",
+                                    expr.sourceRange.start());
+    }
+    auto value = expr.constant->integer().as<int64_t>();
+    if (!value) {
+        throw NotSupportedException("Invalid select index", expr.sourceRange.start());
+    }
+    return *value;
+}
+
+// offset of the selected element from the lsb, in number of elements
+uint64_t get_lanes_offset(const slang::Type &type, int64_t index,
+                          const slang::SourceLocation &loc) {
+    auto range = type.getFixedRange();
+    auto offset = range.isLittleEndian() ? index - range.right : range.right - index;
+    if (offset < 0 || static_cast<uint64_t>(offset) >= range.width()) {
+        throw NotSupportedException("Out of range select not supported in lane-parallel simulation",
+                                    loc);
+    }
+    return static_cast<uint64_t>(offset);
+}
+
+// bit offset of a constant element or range select
+uint64_t get_select_offset(const slang::Expression &expr) {
+    auto loc = expr.sourceRange.start();
+    auto width = expr.type->getBitWidth();
+    if (expr.kind == slang::ExpressionKind::ElementSelect) {
+        auto const &select = expr.as<slang::ElementSelectExpression>();
+        auto index = get_lanes_index(select.selector());
+        return get_lanes_offset(*select.value().type, index, loc) * width;
+    }
+    auto const &select = expr.as<slang::RangeSelectExpression>();
+    int64_t first = get_lanes_index(select.left()), last = first;
+    switch (select.selectionKind) {
+        case slang::RangeSelectionKind::Simple:
+            last = get_lanes_index(select.right());
+            break;
+        case slang::RangeSelectionKind::IndexedUp:
+            last = first + get_lanes_index(select.right()) - 1;
+            break;
+        case slang::RangeSelectionKind::IndexedDown:
+            last = first - get_lanes_index(select.right()) + 1;
+            break;
+    }
+    // elements of packed arrays can be wider than one bit
+    auto const &type = *select.value().type;
+    auto count = static_cast<uint64_t>(std::abs(first - last)) + 1;
+    return std::min(get_lanes_offset(type, first, loc), get_lanes_offset(type, last, loc)) *
+           (width / count);
+}
+
+// values that can be computed when the class is constructed
+bool is_lanes_constant(const slang::Expression &expr) {
+    switch (expr.kind) {
+        case slang::ExpressionKind::IntegerLiteral:
+        case slang::ExpressionKind::UnbasedUnsizedIntegerLiteral:
+            return true;
+        case slang::ExpressionKind::NamedValue:
+            return expr.as<slang::NamedValueExpression>().symbol.kind ==
+                   slang::SymbolKind::Parameter;
+        case slang::ExpressionKind::Conversion:
+            return is_lanes_constant(expr.as<slang::ConversionExpression>().operand());
+        default:
+            return false;
+    }
+}
+
+class LanesNameVisitor : public slang::ASTVisitor<LanesNameVisitor, true, false> {
+public:
+    explicit LanesNameVisitor(CodeGenModuleInformation &info) : info_(info) {}
+
+    [[maybe_unused]] void handle(const slang::VariableSymbol &var) {
+        info_.add_used_names(info_.get_identifier_name(var.name));
+    }
+
+    [[maybe_unused]] void handle(const slang::NetSymbol &net) {
+        info_.add_used_names(info_.get_identifier_name(net.name));
+    }
+
+private:
+    CodeGenModuleInformation &info_;
+};
+
+// every statement is generated with the mask of active lanes. control flow narrows the mask
+// instead of branching, so lanes that take different paths are still simulated together
+class LanesEmitter {
+public:
+    LanesEmitter(std::ostream &s, CodeGenModuleInformation &info,
+                 const slang::InstanceBodySymbol *body, bool non_blocking)
+        : s(s), info_(info), body_(body), non_blocking_(non_blocking) {}
+
+    void process(const slang::Symbol &sym, const std::string &mask);
+    void stmt(const slang::Statement &stmt, const std::string &mask);
+    void expr(const slang::Expression &expr);
+
+    // module variables written by blocking assignments, in the order of first write
+    std::vector<const slang::ValueSymbol *> written;
+    // non-blocking assignments write to a copy of the variable, which is committed afterwards
+    std::vector<std::pair<const slang::ValueSymbol *, std::string>> nba_copies;
+
+private:
+    std::ostream &s;
+    CodeGenModuleInformation &info_;
+    const slang::InstanceBodySymbol *body_;
+    bool non_blocking_;
+
+    void assign(const slang::AssignmentExpression &assign, const std::string &mask);
+    void write(const slang::Expression &target, const std::string &value, uint64_t value_width,
+               uint64_t offset, bool non_blocking, const std::string &mask);
+    std::string target_name(const slang::ValueSymbol &sym, bool non_blocking);
+    void expr(const slang::Expression &expr, uint64_t width);
+    void call(std::string_view func, const slang::Expression &expr);
+    void call(std::string_view func, const slang::Expression &left, const slang::Expression &right,
+              uint64_t width);
+    void constant(const slang::ConstantValue &value, uint64_t width,
+                  const slang::SourceLocation &loc);
+};
+
+void LanesEmitter::process(const slang::Symbol &sym, const std::string &mask) {
+    switch (sym.kind) {
+        case slang::SymbolKind::ContinuousAssign: {
+            auto const &assign_expr = sym.as<slang::ContinuousAssignSymbol>().getAssignment();
+            assign(assign_expr.as<slang::AssignmentExpression>(), mask);
+            return;
+        }
+        case slang::SymbolKind::Net: {
+            auto const &net = sym.as<slang::NetSymbol>();
+            auto width = get_lanes_width(net.getType(), net.location);
+            auto value = info_.get_new_name("value");
+            s << "auto const " << value << " = ";
+            expr(*net.getInitializer(), width);
+            s << ";" << std::endl;
+            s << lanes_ns << "assign(" << target_name(net, false) << ", " << mask << ", " << value
+              << ");" << std::endl;
+            return;
+        }
+        case slang::SymbolKind::Variable: {
+            // constant initial values are set in the declaration
+            auto const *init = sym.as<slang::VariableSymbol>().getInitializer();
+            if (init && is_lanes_constant(*init)) return;
+            break;
+        }
+        case slang::SymbolKind::ProceduralBlock: {
+            auto const *body = &sym.as<slang::ProceduralBlockSymbol>().getBody();
+            if (body->kind == slang::StatementKind::Timed) {
+                // the sensitivity list is not needed since every pass evaluates all the processes
+                auto const &timed = body->as<slang::TimedStatement>();
+                switch (timed.timing.kind) {
+                    case slang::TimingControlKind::SignalEvent:
+                    case slang::TimingControlKind::EventList:
+                    case slang::TimingControlKind::ImplicitEvent:
+                        body = &timed.stmt;
+                        break;
+                    default:
+                        throw NotSupportedException(
+                            "Timing control not supported in lane-parallel simulation",
+                            sym.location);
+                }
+            }
+            stmt(*body, mask);
+            return;
+        }
+        default:
+            break;
+    }
+    throw NotSupportedException("Process not supported in lane-parallel simulation", sym.location);
+}
+
+void LanesEmitter::stmt(const slang::Statement &stmt, const std::string &mask) {
+    switch (stmt.kind) {
+        case slang::StatementKind::Empty:
+            return;
+        case slang::StatementKind::List: {
+            for (auto const *st : stmt.as<slang::StatementList>().list) {
+                this->stmt(*st, mask);
+            }
+            return;
+        }
+        case slang::StatementKind::Block: {
+            auto const &block = stmt.as<slang::BlockStatement>();
+            if (block.blockKind != slang::StatementBlockKind::Sequential) break;
+            s << "{" << std::endl;
+            this->stmt(block.body, mask);
+            s << "}" << std::endl;
+            return;
+        }
+        case slang::StatementKind::VariableDeclaration: {
+            auto const &var = stmt.as<slang::VariableDeclStatement>().symbol;
+            auto width = get_lanes_width(var.getType(), var.location);
+            auto name = info_.get_identifier_name(var.name);
+            s << get_lanes_type(width) << " " << name << ";" << std::endl;
+            if (auto const *init = var.getInitializer()) {
+                s << lanes_ns << "assign(" << name << ", " << mask << ", ";
+                expr(*init, width);
+                s << ");" << std::endl;
+            }
+            return;
+        }
+        case slang::StatementKind::ExpressionStatement: {
+            auto const &e = stmt.as<slang::ExpressionStatement>().expr;
+            if (e.kind != slang::ExpressionKind::Assignment) break;
+            assign(e.as<slang::AssignmentExpression>(), mask);
+            return;
+        }
+        case slang::StatementKind::Conditional: {
+            auto const &cond = stmt.as<slang::ConditionalStatement>();
+            auto pred = info_.get_new_name("cond");
+            s << "{" << std::endl;
+            s << "auto const " << pred << " = " << lanes_ns << "mask(" << lanes_ns << "is_true(";
+            expr(cond.cond);
+            s << "));" << std::endl;
+            auto true_mask = info_.get_new_name("mask");
+            s << "auto const " << true_mask << " = " << mask << " & " << pred << ";" << std::endl;
+            s << "if (" << true_mask << ") {" << std::endl;
+            this->stmt(cond.ifTrue, true_mask);
+            s << "}" << std::endl;
+            if (cond.ifFalse) {
+                auto false_mask = info_.get_new_name("mask");
+                s << "auto const " << false_mask << " = " << mask << " & ~" << pred << ";"
+                  << std::endl;
+                s << "if (" << false_mask << ") {" << std::endl;
+                this->stmt(*cond.ifFalse, false_mask);
+                s << "}" << std::endl;
+            }
+            s << "}" << std::endl;
+            return;
+        }
+        case slang::StatementKind::Case: {
+            auto const &case_ = stmt.as<slang::CaseStatement>();
+            if (case_.condition != slang::CaseStatementCondition::Normal) {
+                throw NotSupportedException("Only normal case condition supported",
+                                            stmt.sourceRange.start());
+            }
+            auto width = get_lanes_width(*case_.expr.type, case_.expr.sourceRange.start());
+            auto target = info_.get_new_name("case");
+            auto remaining = info_.get_new_name("mask");
+            s << "{" << std::endl;
+            s << "auto const " << target << " = ";
+            expr(case_.expr);
+            s << ";" << std::endl;
+            s << "auto " << remaining << " = " << mask << ";" << std::endl;
+            // lanes that match an item are removed from the remaining ones, same as the priority
+            // of case items
+            for (auto const &item : case_.items) {
+                auto item_mask = info_.get_new_name("mask");
+                s << "auto const " << item_mask << " = " << remaining << " & (";
+                for (auto i = 0u; i < item.expressions.size(); i++) {
+                    if (i != 0) s << " | ";
+                    s << lanes_ns << "mask(" << lanes_ns << "eq(" << target << ", ";
+                    expr(*item.expressions[i], width);
+                    s << "))";
+                }
+                s << ");" << std::endl;
+                s << remaining << " &= ~" << item_mask << ";" << std::endl;
+                s << "if (" << item_mask << ") {" << std::endl;
+                this->stmt(*item.stmt, item_mask);
+                s << "}" << std::endl;
+            }
+            if (case_.defaultCase) {
+                s << "if (" << remaining << ") {" << std::endl;
+                this->stmt(*case_.defaultCase, remaining);
+                s << "}" << std::endl;
+            }
+            s << "}" << std::endl;
+            return;
+        }
+        default:
+            break;
+    }
+    throw NotSupportedException("Statement not supported in lane-parallel simulation",
+                                stmt.sourceRange.start());
+}
+
+void LanesEmitter::assign(const slang::AssignmentExpression &assign, const std::string &mask) {
+    if (assign.isCompound() || assign.timingControl) {
+        throw NotSupportedException("Assignment not supported in lane-parallel simulation",
+                                    assign.sourceRange.start());
+    }
+    auto const &left = assign.left();
+    auto width = get_lanes_width(*left.type, left.sourceRange.start());
+    // the value is computed first so that concatenation targets can take their slices
+    auto value = info_.get_new_name("value");
+    s << "auto const " << value << " = ";
+    expr(assign.right(), width);
+    s << ";" << std::endl;
+    write(left, value, width, 0, non_blocking_ && assign.isNonBlocking(), mask);
+}
+
+void LanesEmitter::write(const slang::Expression &target, const std::string &value,
+                         uint64_t value_width, uint64_t offset, bool non_blocking,
+                         const std::string &mask) {
+    auto width = get_lanes_width(*target.type, target.sourceRange.start());
+    auto slice = width == value_width
+                     ? value
+                     : fmt::format("{0}slice<{1}, {2}>({3})", lanes_ns, offset, width, value);
+    switch (target.kind) {
+        case slang::ExpressionKind::NamedValue: {
+            auto const &sym = target.as<slang::NamedValueExpression>().symbol;
+            s << lanes_ns << "assign(" << target_name(sym, non_blocking) << ", " << mask << ", "
+              << slice << ");" << std::endl;
+            return;
+        }
+        case slang::ExpressionKind::ElementSelect:
+        case slang::ExpressionKind::RangeSelect: {
+            // only constant selects of variables, whose offsets are known at compile time
+            auto const &value_expr = target.kind == slang::ExpressionKind::ElementSelect
+                                         ? target.as<slang::ElementSelectExpression>().value()
+                                         : target.as<slang::RangeSelectExpression>().value();
+            if (value_expr.kind != slang::ExpressionKind::NamedValue) break;
+            auto const &sym = value_expr.as<slang::NamedValueExpression>().symbol;
+            s << lanes_ns << "assign<" << get_select_offset(target) << ">("
+              << target_name(sym, non_blocking) << ", " << mask << ", " << slice << ");"
+              << std::endl;
+            return;
+        }
+        case slang::ExpressionKind::Concatenation: {
+            // the last operand holds the lsb
+            auto const &operands = target.as<slang::ConcatenationExpression>().operands();
+            for (auto it = operands.rbegin(); it != operands.rend(); it++) {
+                write(**it, value, value_width, offset, non_blocking, mask);
+                offset += (*it)->type->getBitWidth();
+            }
+            return;
+        }
+        default:
+            break;
+    }
+    throw NotSupportedException("Assignment target not supported in lane-parallel simulation",
+                                target.sourceRange.start());
+}
+
+std::string LanesEmitter::target_name(const slang::ValueSymbol &sym, bool non_blocking) {
+    auto name = std::string(info_.get_identifier_name(sym.name));
+    // local variables are not visible outside the process
+    if (sym.getParentScope() != body_) return name;
+    if (non_blocking) {
+        auto it = std::find_if(nba_copies.begin(), nba_copies.end(),
+                               [&sym](auto const &copy) { return copy.first == &sym; });
+        if (it != nba_copies.end()) return it->second;
+        auto copy_name = info_.get_new_name(fmt::format("{0}_nba", name));
+        nba_copies.emplace_back(&sym, copy_name);
+        return copy_name;
+    }
+    if (std::find(written.begin(), written.end(), &sym) == written.end()) {
+        written.emplace_back(&sym);
+    }
+    return name;
+}
+
+void LanesEmitter::constant(const slang::ConstantValue &value, uint64_t width,
+                            const slang::SourceLocation &loc) {
+    if (!value.isInteger()) {
+        throw NotSupportedException("Only integer constants supported", loc);
+    }
+    auto const &v = value.integer();
+    if (v.hasUnknown()) {
+        throw NotSupportedException("Unknown values not supported in lane-parallel simulation",
+                                    loc);
+    }
+    std::optional<uint64_t> bits;
+    bool negative = false;
+    if (v.isSigned()) {
+        auto signed_value = v.as<int64_t>();
+        if (signed_value) {
+            bits = static_cast<uint64_t>(*signed_value);
+            negative = *signed_value < 0;
+        }
+    } else {
+        bits = v.as<uint64_t>();
+    }
+    if (!bits) {
+        throw NotSupportedException("Constants wider than 64 bits not supported", loc);
+    }
+    if (negative && width > 64) {
+        s << lanes_ns << "extend<" << width << ">(" << get_lanes_type(64) << "::constant(" << *bits
+          << "ull), true)";
+    } else {
+        s << get_lanes_type(width) << "::constant(" << *bits << "ull)";
+    }
+}
+
+void LanesEmitter::expr(const slang::Expression &expr, uint64_t width) {
+    auto expr_width = get_lanes_width(*expr.type, expr.sourceRange.start());
+    if (expr_width == width) {
+        this->expr(expr);
+        return;
+    }
+    s << lanes_ns << "extend<" << width << ">(";
+    this->expr(expr);
+    s << ", " << (expr.type->isSigned() ? "true" : "false") << ")";
+}
+
+void LanesEmitter::call(std::string_view func, const slang::Expression &expr) {
+    s << lanes_ns << func << "(";
+    this->expr(expr);
+    s << ")";
+}
+
+void LanesEmitter::call(std::string_view func, const slang::Expression &left,
+                        const slang::Expression &right, uint64_t width) {
+    s << lanes_ns << func << "(";
+    expr(left, width);
+    s << ", ";
+    expr(right, width);
+    s << ")";
+}
+
+void LanesEmitter::expr(const slang::Expression &expr) {
+    auto loc = expr.sourceRange.start();
+    auto width = get_lanes_width(*expr.type, loc);
+    switch (expr.kind) {
+        case slang::ExpressionKind::IntegerLiteral: {
+            constant(expr.as<slang::IntegerLiteral>().getValue(), width, loc);
+            return;
+        }
+        case slang::ExpressionKind::UnbasedUnsizedIntegerLiteral: {
+            auto value = expr.as<slang::UnbasedUnsizedIntegerLiteral>().getValue();
+            if (value.isUnknown()) {
+                throw NotSupportedException(
+                    "Unknown values not supported in lane-parallel simulation", loc);
+            }
+            s << get_lanes_type(width) << (value.value ? "::ones()" : "{}");
+            return;
+        }
+        case slang::ExpressionKind::NamedValue: {
+            auto const &sym = expr.as<slang::NamedValueExpression>().symbol;
+            if (sym.kind == slang::SymbolKind::Parameter) {
+                constant(sym.as<slang::ParameterSymbol>().getValue(), width, loc);
+            } else {
+                s << info_.get_identifier_name(sym.name);
+            }
+            return;
+        }
+        case slang::ExpressionKind::Conversion: {
+            auto const &op = expr.as<slang::ConversionExpression>().operand();
+            // extension uses the signedness of the operand
+            this->expr(op, width);
+            return;
+        }
+        case slang::ExpressionKind::UnaryOp: {
+            auto const &unary = expr.as<slang::UnaryExpression>();
+            auto const &op = unary.operand();
+            switch (unary.op) {
+                case slang::UnaryOperator::Plus:
+                    this->expr(op, width);
+                    return;
+                case slang::UnaryOperator::Minus:
+                    s << lanes_ns << "neg(";
+                    this->expr(op, width);
+                    s << ")";
+                    return;
+                case slang::UnaryOperator::BitwiseNot:
+                    s << lanes_ns << "bit_not(";
+                    this->expr(op, width);
+                    s << ")";
+                    return;
+                case slang::UnaryOperator::LogicalNot:
+                    s << lanes_ns << "bit_not(";
+                    call("is_true", op);
+                    s << ")";
+                    return;
+                case slang::UnaryOperator::BitwiseAnd:
+                    call("r_and", op);
+                    return;
+                case slang::UnaryOperator::BitwiseOr:
+                    call("r_or", op);
+                    return;
+                case slang::UnaryOperator::BitwiseXor:
+                    call("r_xor", op);
+                    return;
+                case slang::UnaryOperator::BitwiseNand:
+                case slang::UnaryOperator::BitwiseNor:
+                case slang::UnaryOperator::BitwiseXnor: {
+                    auto func = unary.op == slang::UnaryOperator::BitwiseNand  ? "r_and"
+                                : unary.op == slang::UnaryOperator::BitwiseNor ? "r_or"
+                                                                               : "r_xor";
+                    s << lanes_ns << "bit_not(";
+                    call(func, op);
+                    s << ")";
+                    return;
+                }
+                default:
+                    // increment and decrement have side effects
+                    break;
+            }
+            break;
+        }
+        case slang::ExpressionKind::BinaryOp: {
+            auto const &binary = expr.as<slang::BinaryExpression>();
+            auto const &left = binary.left();
+            auto const &right = binary.right();
+            auto left_width = get_lanes_width(*left.type, left.sourceRange.start());
+            auto right_width = get_lanes_width(*right.type, right.sourceRange.start());
+            auto operand_width = std::max(left_width, right_width);
+            auto is_signed = left.type->isSigned() && right.type->isSigned();
+            auto output_not = [&](std::string_view func, uint64_t w) {
+                s << lanes_ns << "bit_not(";
+                call(func, left, right, w);
+                s << ")";
+            };
+            auto output_logical = [&](std::string_view func) {
+                s << lanes_ns << func << "(";
+                call("is_true", left);
+                s << ", ";
+                call("is_true", right);
+                s << ")";
+            };
+            auto output_shift = [&](std::string_view func) {
+                s << lanes_ns << func << "(";
+                this->expr(left, width);
+                s << ", ";
+                this->expr(right);
+                s << ")";
+            };
+            switch (binary.op) {
+                case slang::BinaryOperator::Add:
+                    call("add", left, right, width);
+                    return;
+                case slang::BinaryOperator::Subtract:
+                    call("sub", left, right, width);
+                    return;
+                case slang::BinaryOperator::Multiply:
+                    call("mul", left, right, width);
+                    return;
+                case slang::BinaryOperator::BinaryAnd:
+                    call("bit_and", left, right, width);
+                    return;
+                case slang::BinaryOperator::BinaryOr:
+                    call("bit_or", left, right, width);
+                    return;
+                case slang::BinaryOperator::BinaryXor:
+                    call("bit_xor", left, right, width);
+                    return;
+                case slang::BinaryOperator::BinaryXnor:
+                    output_not("bit_xor", width);
+                    return;
+                case slang::BinaryOperator::Equality:
+                case slang::BinaryOperator::CaseEquality:
+                    call("eq", left, right, operand_width);
+                    return;
+                case slang::BinaryOperator::Inequality:
+                case slang::BinaryOperator::CaseInequality:
+                    output_not("eq", operand_width);
+                    return;
+                case slang::BinaryOperator::LessThan:
+                    call(is_signed ? "slt" : "lt", left, right, operand_width);
+                    return;
+                case slang::BinaryOperator::GreaterThanEqual:
+                    output_not(is_signed ? "slt" : "lt", operand_width);
+                    return;
+                case slang::BinaryOperator::GreaterThan:
+                    call(is_signed ? "slt" : "lt", right, left, operand_width);
+                    return;
+                case slang::BinaryOperator::LessThanEqual:
+                    s << lanes_ns << "bit_not(";
+                    call(is_signed ? "slt" : "lt", right, left, operand_width);
+                    s << ")";
+                    return;
+                case slang::BinaryOperator::LogicalAnd:
+                    output_logical("bit_and");
+                    return;
+                case slang::BinaryOperator::LogicalOr:
+                    output_logical("bit_or");
+                    return;
+                case slang::BinaryOperator::LogicalShiftLeft:
+                case slang::BinaryOperator::ArithmeticShiftLeft:
+                    output_shift("shl");
+                    return;
+                case slang::BinaryOperator::LogicalShiftRight:
+                    output_shift("shr");
+                    return;
+                case slang::BinaryOperator::ArithmeticShiftRight:
+                    output_shift(expr.type->isSigned() ? "ashr" : "shr");
+                    return;
+                default:
+                    // division and power are too expensive to compute bit by bit
+                    break;
+            }
+            break;
+        }
+        case slang::ExpressionKind::ConditionalOp: {
+            auto const &cond = expr.as<slang::ConditionalExpression>();
+            s << lanes_ns << "mux(";
+            call("is_true", cond.pred());
+            s << ", ";
+            this->expr(cond.left(), width);
+            s << ", ";
+            this->expr(cond.right(), width);
+            s << ")";
+            return;
+        }
+        case slang::ExpressionKind::Concatenation: {
+            auto const &operands = expr.as<slang::ConcatenationExpression>().operands();
+            s << lanes_ns << "concat(";
+            for (auto i = 0u; i < operands.size(); i++) {
+                if (i != 0) s << ", ";
+                this->expr(*operands[i]);
+            }
+            s << ")";
+            return;
+        }
+        case slang::ExpressionKind::Replication: {
+            auto const &replication = expr.as<slang::ReplicationExpression>();
+            auto const &concat = replication.concat();
+            auto concat_width = get_lanes_width(*concat.type, concat.sourceRange.start());
+            s << lanes_ns << "replicate<" << width / concat_width << ">(";
+            this->expr(concat);
+            s << ")";
+            return;
+        }
+        case slang::ExpressionKind::ElementSelect: {
+            auto const &select = expr.as<slang::ElementSelectExpression>();
+            auto const &value = select.value();
+            auto const &type = *value.type;
+            get_lanes_width(type, value.sourceRange.start());
+            if (select.selector().constant) {
+                s << lanes_ns << "slice<" << get_select_offset(expr) << ", " << width << ">(";
+                this->expr(value);
+                s << ")";
+                return;
+            }
+            // dynamic index, which can be different in every lane
+            auto range = type.getFixedRange();
+            if (width != 1 || !range.isLittleEndian()) break;
+            s << lanes_ns << "select<" << range.right << ">(";
+            this->expr(value);
+            s << ", ";
+            this->expr(select.selector());
+            s << ")";
+            return;
+        }
+        case slang::ExpressionKind::RangeSelect: {
+            auto const &select = expr.as<slang::RangeSelectExpression>();
+            auto const &value = select.value();
+            get_lanes_width(*value.type, value.sourceRange.start());
+            s << lanes_ns << "slice<" << get_select_offset(expr) << ", " << width << ">(";
+            this->expr(value);
+            s << ")";
+            return;
+        }
+        default:
+            break;
+    }
+    throw NotSupportedException("Expression not supported in lane-parallel simulation", loc);
+}
+
+using EdgeKey = std::pair<const slang::ValueSymbol *, slang::EdgeKind>;
+
+void output_comb(std::ostream &s, const Module *mod, CodeGenModuleInformation &info) {
+    auto const *body = &mod->def()->body;
+    std::stringstream process_s;
+    auto mask = info.get_new_name("mask");
+    LanesEmitter emitter(process_s, info, body, false);
+    for (auto const &comb : mod->comb_processes) {
+        if (!comb->edge_event_controls.empty()) {
+            throw NotSupportedException("Timing control not supported in lane-parallel simulation",
+                                        comb->stmts[0]->location);
+        }
+        for (auto const *sym : comb->stmts) {
+            emitter.process(*sym, mask);
+        }
+    }
+
+    s << "// evaluates combinational logic until every lane settles. returns false if it doesn't "
+         "settle, e.g. combinational loops"
+      << std::endl;
+    s << "bool comb() {" << std::endl;
+    auto iteration = info.get_new_name("iteration");
+    s << "for (uint64_t " << iteration << " = 0; " << iteration << " < " << max_comb_iterations
+      << "; " << iteration << "++) {" << std::endl;
+    s << "auto const " << mask << " = " << lanes_ns << "all_lanes;" << std::endl;
+    std::vector<std::pair<std::string_view, std::string>> previous;
+    for (auto const *sym : emitter.written) {
+        auto name = info.get_identifier_name(sym->name);
+        auto prev = info.get_new_name(fmt::format("{0}_prev", name));
+        s << "auto const " << prev << " = " << name << ";" << std::endl;
+        previous.emplace_back(name, prev);
+    }
+    s << process_s.str();
+    s << "if (true";
+    for (auto const &[name, prev] : previous) {
+        s << " && " << name << " == " << prev;
+    }
+    s << ") return true;" << std::endl;
+    s << "}" << std::endl << "return false;" << std::endl << "}" << std::endl;
+}
+
+void output_edge(std::ostream &s, const EdgeKey &key, const std::vector<const FFProcess *> &ffs,
+                 const Module *mod, CodeGenModuleInformation &info) {
+    auto const &[var, edge] = key;
+    std::stringstream process_s;
+    auto mask = info.get_new_name("mask");
+    LanesEmitter emitter(process_s, info, &mod->def()->body, true);
+    for (auto const *ff : ffs) {
+        emitter.stmt(*ff->body, mask);
+    }
+
+    auto edge_name = edge == slang::EdgeKind::PosEdge ? "posedge" : "negedge";
+    auto var_name = info.get_identifier_name(var->name);
+    s << "// triggers the always_ff blocks in the given lanes, after " << var_name
+      << " is updated by the testbench" << std::endl;
+    s << "void " << edge_name << "_" << var_name << "(" << lanes_ns << "Mask " << mask << " = "
+      << lanes_ns << "all_lanes) {" << std::endl;
+    for (auto const &[sym, copy] : emitter.nba_copies) {
+        s << "auto " << copy << " = " << info.get_identifier_name(sym->name) << ";" << std::endl;
+    }
+    s << process_s.str();
+    for (auto const &[sym, copy] : emitter.nba_copies) {
+        s << info.get_identifier_name(sym->name) << " = " << copy << ";" << std::endl;
+    }
+    s << "comb();" << std::endl << "}" << std::endl;
+}
+
+void output_lanes_vars(std::ostream &s, const Module *mod, CodeGenModuleInformation &info) {
+    LanesEmitter emitter(s, info, &mod->def()->body, false);
+    for (auto const &member : mod->def()->body.members()) {
+        switch (member.kind) {
+            case slang::SymbolKind::Variable:
+            case slang::SymbolKind::Net: {
+                auto const &var = member.as<slang::ValueSymbol>();
+                if (member.kind == slang::SymbolKind::Variable &&
+                    var.as<slang::VariableSymbol>().flags.has(
+                        slang::VariableFlags::CompilerGenerated)) {
+                    continue;
+                }
+                auto width = get_lanes_width(var.getType(), var.location);
+                s << get_lanes_type(width) << " " << info.get_identifier_name(var.name);
+                auto const *init = var.getInitializer();
+                if (member.kind == slang::SymbolKind::Variable && init) {
+                    if (!is_lanes_constant(*init)) {
+                        throw NotSupportedException(
+                            "Only constant initial values supported in lane-parallel simulation",
+                            var.location);
+                    }
+                    s << " = ";
+                    emitter.expr(*init);
+                }
+                s << ";" << std::endl;
+                break;
+            }
+            case slang::SymbolKind::GenerateBlock:
+            case slang::SymbolKind::GenerateBlockArray:
+                throw NotSupportedException(
+                    "Generate blocks not supported in lane-parallel simulation", member.location);
+            default:
+                break;
+        }
+    }
+}
+
+void LanesCodeGen::output(const std::string &dir) {
+    auto const *def = top_->def();
+    // the class only models a single design without testbench code, which drives it from C++
+    if (!top_->child_instances.empty()) {
+        throw NotSupportedException("Child instances not supported in lane-parallel simulation",
+                                    def->location);
+    }
+    if (!top_->init_processes.empty() || !top_->final_processes.empty()) {
+        throw NotSupportedException(
+            "Initial and final blocks not supported in lane-parallel simulation", def->location);
+    }
+
+    info_.current_module = top_;
+    {
+        LanesNameVisitor v(info_);
+        def->visit(v);
+    }
+
+    // always_ff blocks with multiple edges, e.g. asynchronous reset, are triggered by each of them
+    std::vector<std::pair<EdgeKey, std::vector<const FFProcess *>>> edges;
+    for (auto const &ff : top_->ff_processes) {
+        if (!ff->body) {
+            throw NotSupportedException("Timing control not supported in lane-parallel simulation",
+                                        ff->stmts[0]->location);
+        }
+        for (auto const &[edge, var] : ff->edges) {
+            if (edge == slang::EdgeKind::BothEdges || edge == slang::EdgeKind::None) {
+                throw NotSupportedException("Only posedge and negedge supported in lane-parallel "
+                                            "simulation",
+                                            ff->stmts[0]->location);
+            }
+            EdgeKey key = {var, edge};
+            auto it = std::find_if(edges.begin(), edges.end(),
+                                   [&key](auto const &entry) { return entry.first == key; });
+            if (it == edges.end()) {
+                edges.emplace_back(key, std::vector<const FFProcess *>{ff.get()});
+            } else {
+                it->second.emplace_back(ff.get());
+            }
+        }
+    }
+
+    std::stringstream s;
+    auto class_name = info_.get_identifier_name(top_->name);
+    s << "#pragma once" << std::endl
+      << "#include \"runtime/lanes.hh\"" << std::endl
+      << std::endl
+      << "namespace fsim::lanes {" << std::endl;
+    s << "// 64 independent simulations of " << top_->name << ", one per bit lane" << std::endl;
+    s << "class " << class_name << " {" << std::endl << "public:" << std::endl;
+    s << class_name << "() { comb(); }" << std::endl;
+
+    output_lanes_vars(s, top_, info_);
+    output_comb(s, top_, info_);
+    for (auto const &[key, ffs] : edges) {
+        output_edge(s, key, ffs, top_, info_);
+    }
+
+    s << "};" << std::endl << "} // namespace fsim::lanes" << std::endl;
+
+    std::filesystem::path dir_path = dir;
+    auto filename = dir_path / get_lanes_hh_filename(top_->name);
+    write_to_file(filename.string(), s);
+}
+
+}  // namespace fsim
@@ -0,0 +1,29 @@
+#ifndef FSIM_CODEGEN_LANES_HH
+#define FSIM_CODEGEN_LANES_HH
+
+#include "util.hh"
+
+namespace fsim {
+
+// generates a header-only class that simulates 64 independent copies of a 2-state design at once,
+// one per bit lane. see runtime/lanes.hh. the class is driven by a C++ testbench that sets the
+// inputs of each lane and calls the edge functions, so there is no scheduler involved
+class LanesCodeGen {
+public:
+    explicit LanesCodeGen(const Module *top) : top_(top) {}
+
+    void output(const std::string &dir);
+
+private:
+    const Module *top_;
+    CodeGenModuleInformation info_;
+};
+
+template <typename T>
+inline std::string get_lanes_hh_filename(const T &name) {
+    return fmt::format("{0}_lanes.hh", name);
+}
+
+}  // namespace fsim
+
+#endif  // FSIM_CODEGEN_LANES_HH
@@ -1,7 +1,7 @@
 #include "ninja.hh"
 
 #include <filesystem>
-#include <set>
+#include <map>
 
 #include "../platform/dvpi.hh"
 #include "fmt/format.h"
@@ -9,11 +9,11 @@
 
 namespace fsim {
 
-std::set<std::string_view> get_defs(const Module *module) {
+std::map<std::string_view, const Module *> get_defs(const Module *module) {
     auto defs = module->get_defs();
-    std::set<std::string_view> result;
+    std::map<std::string_view, const Module *> result;
     for (auto const *def : defs) {
-        result.emplace(def->name);
+        result.emplace(def->name, def);
     }
     return result;
 }
@@ -33,12 +33,27 @@ std::string get_linker_flags(const platform::DPILocator *dpi) {
     return fmt::format("{0}", std::move(res));
 }
 
-void NinjaCodeGen::output(const std::string &dir) {
-    std::filesystem::path dir_path = dir;
-    auto ninja_filename = dir_path / "build.ninja";
-    std::stringstream stream;
+std::vector<std::string> get_cflags(uint8_t optimization_level) {
+    std::vector<std::string> flags = {"-std=c++20", "-march=native", "-m64"};
+    auto level = std::clamp<uint32_t>(optimization_level, 0, 3);
+    flags.emplace_back(fmt::format("-O{0}", level));
+    if (level == 0) {
+        flags.emplace_back("-g");
+    }
+    // ignore warning flags for apple clang
+    flags.emplace_back("-Wno-unknown-attributes");
+    flags.emplace_back("-Wno-unused-command-line-argument");
+    // windows need to have dynmac flag
+#ifdef _WIN32
+    flags.emplace_back("-D_DLL");
+#endif
+    return flags;
+}
+
+NinjaCodeGen::NinjaCodeGen(const Module *top, NinjaCodeGenOptions &options,
+                           const platform::DPILocator *dpi)
+    : top_(top), options_(options), dpi_(dpi) {
     // filling out missing information
-    // use the output dir as the runtime dir
     if (options_.cxx_path.empty()) {
         // hope for the best?
         auto const *cxx = std::getenv("FSIM_CXX");
@@ -51,40 +66,55 @@ void NinjaCodeGen::output(const std::string &dir) {
     if (options_.binary_name.empty()) {
         options_.binary_name = default_output_name;
     }
+}
+
+void NinjaCodeGen::output(const std::string &dir) {
+    std::filesystem::path dir_path = dir;
+    auto ninja_filename = dir_path / "build.ninja";
+    std::stringstream stream;
 
+    // use the output dir as the runtime dir
     std::filesystem::path runtime_dir = std::filesystem::absolute(dir);
     auto include_dir = runtime_dir / "include";
     auto lib_path = runtime_dir / "lib";
     auto runtime_lib_path = lib_path / "libfsim-runtime.so";
-    stream << "cflags = -I" << include_dir << " -std=c++20 -march=native -m64 ";
-    auto level = std::clamp<uint32_t>(options_.optimization_level, 0, 3);
-    stream << "-O" << level << " ";
-    if (level == 0) {
-        stream << "-g ";
-    }
-    // ignore warning flags for apple clang
-    stream << "-Wno-unknown-attributes -Wno-unused-command-line-argument ";
-    // windows need to have dynmac flag
-#ifdef _WIN32
-    stream << "-D_DLL ";
-#endif
-    stream << std::endl << std::endl;
+    auto cflags = get_cflags(options_.optimization_level);
+    stream << "cflags = -I" << include_dir << " " << fmt::format("{0}", fmt::join(cflags, " "))
+           << std::endl
+           << std::endl;
     // codegen rules
+    // the runtime headers are parsed once into a precompiled header, which both gcc and clang pick
+    // up through -include when <header>.gch exists
+    auto pch_name = fmt::format("{0}.gch", prelude_filename);
+    stream << "rule pch" << std::endl;
+    stream << "  depfile = $out.d" << std::endl;
+    stream << "  command = " << options_.cxx_path
+           << " -MD -MF $out.d $cflags -x c++-header -c $in -o $out" << std::endl
+           << "  description = $out" << std::endl
+           << std::endl;
     stream << "rule cc" << std::endl;
     stream << "  depfile = $out.d" << std::endl;
-    stream << "  command = " << options_.cxx_path << " -MD -MF $out.d $cflags -c $in -o $out"
-           << std::endl
+    stream << "  command = " << options_.cxx_path << " -MD -MF $out.d $cflags -include "
+           << prelude_filename << " -c $in -o $out" << std::endl
            << "  description = $out" << std::endl
            << std::endl;
 
-    // output for each module definition
-    auto defs = get_defs(top_);
+    // output for each translation unit
     std::string objs;
-    // add main object as well
-    defs.emplace(main_name);
-    for (auto const &name : defs) {
+    bool has_pch = false;
+    for (auto const &name : translation_units(dir)) {
+        auto cached = options_.cached_objects.find(name);
+        if (cached != options_.cached_objects.end()) {
+            objs.append(cached->second).append(" ");
+            continue;
+        }
+        if (!has_pch) {
+            stream << "build " << pch_name << ": pch " << prelude_filename << std::endl;
+            has_pch = true;
+        }
         auto obj_name = fmt::format("{0}.o", name);
-        stream << "build " << obj_name << ": cc " << get_cc_filename(name) << std::endl;
+        stream << "build " << obj_name << ": cc " << get_cc_filename(name) << " | " << pch_name
+               << std::endl;
         objs.append(obj_name).append(" ");
     }
 #ifdef _WIN32
@@ -109,5 +139,73 @@ void NinjaCodeGen::output(const std::string &dir) {
     stream << "build " << options_.binary_name << ": main " << objs << std::endl;
 
     write_to_file(ninja_filename.string(), stream, false);
+
+    // scheduler.hh etc. are included by every module file as well
+    std::stringstream prelude;
+    prelude << "#ifndef FSIM_PRELUDE_HH" << std::endl
+            << "#define FSIM_PRELUDE_HH" << std::endl
+            << prelude_include << "#include \"runtime/checkpoint.hh\"" << std::endl
+            << "#include \"runtime/macro.hh\"" << std::endl
+            << "#include \"runtime/scheduler.hh\"" << std::endl
+            << "#endif" << std::endl;
+    write_to_file((dir_path / prelude_filename).string(), prelude, false);
+}
+
+const std::vector<std::string> &NinjaCodeGen::translation_units(const std::string &dir) {
+    if (translation_units_) return *translation_units_;
+    std::filesystem::path dir_path = dir;
+    std::vector<std::string> result = {main_name};
+
+    std::vector<std::string_view> group;
+    uint64_t group_complexity = 0;
+    uint64_t num_groups = 0;
+    auto flush_group = [&]() {
+        if (group.size() == 1) {
+            result.emplace_back(group[0]);
+        } else if (group.size() > 1) {
+            // named after main, so the jumbo files never collide with any module
+            auto name = fmt::format("{0}.jumbo{1}", main_name, ++num_groups);
+            std::stringstream stream;
+            for (auto const &def_name : group) {
+                stream << "#include \"" << get_cc_filename(def_name) << "\"" << std::endl;
+            }
+            write_to_file((dir_path / get_cc_filename(name)).string(), stream, false);
+            result.emplace_back(name);
+        }
+        group.clear();
+        group_complexity = 0;
+    };
+
+    // sorted by name to keep the groups stable across builds
+    for (auto const &[name, def] : get_defs(top_)) {
+        // parts written by CXXCodeGen
+        std::vector<std::string> parts;
+        while (true) {
+            auto part_name = get_part_name(name, parts.size() + 1);
+            if (!std::filesystem::exists(dir_path / get_cc_filename(part_name))) break;
+            parts.emplace_back(part_name);
+        }
+        if (options_.tu_complexity == 0 || !parts.empty()) {
+            result.emplace_back(name);
+            result.insert(result.end(), parts.begin(), parts.end());
+            continue;
+        }
+        // modules without any statements still cost something to compile
+        auto complexity = def->complexity() + 1;
+        if (complexity > options_.tu_complexity) {
+            result.emplace_back(name);
+            continue;
+        }
+
+        if (group_complexity + complexity > options_.tu_complexity) {
+            flush_group();
+        }
+        group.emplace_back(name);
+        group_complexity += complexity;
+    }
+    flush_group();
+
+    translation_units_ = std::move(result);
+    return *translation_units_;
 }
 }  // namespace fsim
@@ -1,6 +1,9 @@
 #ifndef FSIM_NINJA_HH
 #define FSIM_NINJA_HH
 
+#include <optional>
+#include <unordered_map>
+
 #include "../ir/ir.hh"
 
 namespace fsim {
@@ -14,20 +17,34 @@ struct NinjaCodeGenOptions {
     std::string binary_name;
 
     std::vector<std::string> sv_libs;
+    // objects linked as is instead of being compiled, indexed by translation unit. see
+    // builder/cache.hh
+    std::unordered_map<std::string, std::string> cached_objects;
+    // modules whose complexity is no more than the threshold are grouped into jumbo translation
+    // units of about the same complexity. 0 turns off grouping. see CXXCodeGenOptions
+    uint64_t tu_complexity = 0;
 };
 
+// compiler flags for every object, except for the include directory
+std::vector<std::string> get_cflags(uint8_t optimization_level);
+
 class NinjaCodeGen {
     // generates native ninja code (bypass cmake)
 public:
-    NinjaCodeGen(const Module *top, NinjaCodeGenOptions &options, const platform::DPILocator *dpi)
-        : top_(top), options_(options), dpi_(dpi) {}
+    // fills out the missing compiler path and binary name in the options
+    NinjaCodeGen(const Module *top, NinjaCodeGenOptions &options, const platform::DPILocator *dpi);
 
     void output(const std::string &dir);
 
+    // translation units named after their .cc files, e.g. module for module.cc. has to be called
+    // after the C++ code is generated, since large modules are split into several files
+    const std::vector<std::string> &translation_units(const std::string &dir);
+
 private:
     const Module *top_;
     NinjaCodeGenOptions &options_;
     const platform::DPILocator *dpi_ = nullptr;
+    std::optional<std::vector<std::string>> translation_units_;
 };
 }  // namespace fsim
 
@@ -35,7 +35,16 @@ void VarDeclarationVisitor::handle(const slang::VariableSymbol &var) {
     handle_(var, var.lifetime);
 }
 
+bool VarDeclarationVisitor::add_inline_var(const slang::ValueSymbol &var) {
+    if (module_info.inline_instance.empty()) return true;
+    // ports aliased to parent variables don't have any storage
+    if (module_info.get_port_alias(&var)) return false;
+    module_info.add_inline_var(&var);
+    return true;
+}
+
 [[maybe_unused]] void VarDeclarationVisitor::handle(const slang::NetSymbol &var) {
+    if (!add_inline_var(var)) return;
     // output variable definition
     auto var_type_decl = get_var_decl(var);
     s << var_type_decl << ";" << std::endl;
@@ -70,6 +79,7 @@ void VarDeclarationVisitor::handle_(const slang::ValueSymbol &var,
                                     slang::VariableLifetime life_time) {
     // not interested in formal argument for now
     if (var.kind == slang::SymbolKind::FormalArgument) return;
+    if (!add_inline_var(var)) return;
     // static. only required if the declaration scope is not module
     bool defined_in_func = defined_in_function(var);
     if (defined_in_func && life_time == slang::VariableLifetime::Static) {
@@ -233,6 +243,10 @@ private:
     }
 
     void print_name() {
+        if (auto const *inline_name = module_info_.get_inline_var_name(&sym_)) {
+            s_ << " " << name_prefix_ << *inline_name;
+            return;
+        }
         auto n = module_info_.get_identifier_name(sym_.name);
         s_ << " " << name_prefix_ << n;
     }
@@ -269,7 +283,13 @@ StmtCodeGenVisitor::StmtCodeGenVisitor(std::ostream &s, const CXXCodeGenOptions
     s << std::endl;
     auto const &timing = stmt.timing;
     TimingControlCodeGen timing_codegen(s, module_info, expr_v);
-    timing_codegen.handle(timing);
+    auto it = module_info.resume_points.find(&stmt);
+    if (it != module_info.resume_points.end()) {
+        s << fmt::format("fsim_resume_{0}:", it->second) << std::endl;
+        timing_codegen.handle(timing, it->second);
+    } else {
+        timing_codegen.handle(timing);
+    }
     stmt.stmt.visit(*this);
 }
 
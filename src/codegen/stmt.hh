@@ -30,6 +30,8 @@ private:
     const slang::InstanceSymbol *inst_ = nullptr;
 
     [[nodiscard]] std::string get_var_decl(const slang::Symbol &sym) const;
+    // returns false if the variable of an inlined instance is not declared
+    bool add_inline_var(const slang::ValueSymbol &var);
 
     void handle_(const slang::ValueSymbol &var,
                  slang::VariableLifetime = slang::VariableLifetime::Automatic);
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <unordered_map>
 
+#include "../builder/hash.hh"
 #include "reproc++/drain.hpp"
 #include "reproc++/reproc.hpp"
 #include "slang/compilation/Compilation.h"
@@ -88,10 +89,81 @@ std::vector<std::string> get_tokens(const std::string &line, const std::string &
 }
 }  // namespace util::string
 
+// indent the generated code by its braces, which is good enough to read and a lot faster than
+// starting clang-format for every file. namespaces are not indented
+std::string indent_cxx_file(std::string_view content) {
+    std::string result;
+    result.reserve(content.size() + content.size() / 4);
+    // indentation added by each open brace
+    std::vector<uint64_t> braces;
+    uint64_t depth = 0;
+    bool in_block_comment = false;
+    while (!content.empty()) {
+        auto end = content.find('\n');
+        auto line = content.substr(0, end);
+        content = end == std::string_view::npos ? std::string_view{} : content.substr(end + 1);
+
+        auto first = line.find_first_not_of(" \t");
+        auto last = line.find_last_not_of(" \t\r");
+        if (first == std::string_view::npos) {
+            result.push_back('\n');
+            continue;
+        }
+        line = line.substr(first, last - first + 1);
+        if (!in_block_comment && line[0] == '#') {
+            result.append(line).push_back('\n');
+            continue;
+        }
+
+        auto indent = depth;
+        if (line[0] == '}' && !braces.empty()) {
+            indent -= braces.back();
+        } else if (indent > 0 && (line == "public:" || line == "private:")) {
+            indent--;
+        }
+        result.append(indent * 4, ' ').append(line).push_back('\n');
+
+        bool is_namespace = line.starts_with("namespace ") || line.starts_with("extern \"C\"");
+        char quote = 0;
+        for (auto i = 0u; i < line.size(); i++) {
+            auto c = line[i];
+            auto next = i + 1 < line.size() ? line[i + 1] : 0;
+            if (in_block_comment) {
+                if (c == '*' && next == '/') {
+                    in_block_comment = false;
+                    i++;
+                }
+            } else if (quote) {
+                if (c == '\\') {
+                    i++;
+                } else if (c == quote) {
+                    quote = 0;
+                }
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '/' && next == '/') {
+                break;
+            } else if (c == '/' && next == '*') {
+                in_block_comment = true;
+                i++;
+            } else if (c == '{') {
+                braces.emplace_back(is_namespace ? 0 : 1);
+                depth += braces.back();
+            } else if (c == '}' && !braces.empty()) {
+                depth -= braces.back();
+                braces.pop_back();
+            }
+        }
+    }
+    return result;
+}
+
 std::string format_cxx_file(const std::string &content) {
-    const static bool clang_format_available = util::fs::which("clang-format").has_value();
-    // clang-format not available. return as is
-    if (!clang_format_available) return content;
+    // clang-format is only used to debug the generated code, since starting a process for every
+    // file takes longer than generating the code
+    const static bool use_clang_format = std::getenv("FSIM_CLANG_FORMAT") != nullptr &&
+                                         util::fs::which("clang-format").has_value();
+    if (!use_clang_format) return indent_cxx_file(content);
     // pipe through the files
     reproc::process process;
     const static std::vector<const char *> args = {"clang-format", nullptr};
@@ -119,38 +191,32 @@ std::string format_cxx_file(const std::string &content) {
     return output;
 }
 
+// generated files start with the hash of their content, so an unchanged file is detected by
+// its first line instead of reading it in full. files that are not written are not rebuilt by ninja
+std::string get_content_stamp(const std::string &filename, std::string_view content) {
+    auto const *comment = filename.ends_with(".ninja") ? "#" : "//";
+    return fmt::format("{0} fsim {1}", comment, Hash().add(content).str());
+}
+
 void write_to_file(const std::string &filename, std::stringstream &stream, bool format) {
     auto raw_buf = stream.str();
     auto buf = format ? format_cxx_file(raw_buf) : raw_buf;
-    if (!std::filesystem::exists(filename)) {
-        // doesn't exist, directly write to the file
-        std::ofstream s(filename, std::ios::trunc);
-        s << buf;
-    } else {
-        // need to compare size
-        // if they are different, output to that file
-        {
-            std::ifstream f(filename, std::ifstream::ate | std::ifstream::binary);
-            auto size = static_cast<uint64_t>(f.tellg());
-            if (size != buf.size()) {
-                std::ofstream s(filename, std::ios::trunc);
-                s << buf;
-            } else {
-                // they are the same size, now need to compare its actual content
-                std::string contents;
-                f.seekg(0, std::ios::end);
-                contents.resize(f.tellg());
-                f.seekg(0, std::ios::beg);
-                f.read(&contents[0], static_cast<int64_t>(contents.size()));
-
-                if (contents != buf) {
-                    f.close();
-                    std::ofstream s(filename, std::ios::trunc);
-                    s << buf;
-                }
-            }
-        }
+    auto stamp = get_content_stamp(filename, buf);
+    {
+        std::ifstream f(filename);
+        std::string line;
+        if (f.is_open() && std::getline(f, line) && line == stamp) return;
+    }
+    // write to a temporary file first so an interrupted write never leaves a truncated file
+    // behind a matching stamp
+    auto tmp_filename = filename + ".tmp";
+    {
+        std::ofstream s(tmp_filename, std::ios::trunc);
+        s << stamp << std::endl << buf;
+        s.close();
+        if (!s) throw std::runtime_error(fmt::format("Unable to write {0}", filename));
     }
+    std::filesystem::rename(tmp_filename, filename);
 }
 
 std::string CodeGenModuleInformation::get_new_name(const std::string &prefix, bool track_new_name) {
@@ -193,6 +259,19 @@ const slang::Compilation *CodeGenModuleInformation::get_compilation() const {
     return current_module ? current_module->get_compilation() : nullptr;
 }
 
+std::string CodeGenModuleInformation::module_pointer() const {
+    // inlined instances don't have a module object of their own, so they report as the parent
+    return "this";
+}
+
+const std::string &CodeGenModuleInformation::add_inline_var(const slang::Symbol *sym) {
+    if (!inline_vars_.contains(sym)) {
+        auto prefix = fmt::format("{0}_{1}", inline_instance, get_identifier_name(sym->name));
+        inline_vars_.emplace(sym, get_new_name(prefix));
+    }
+    return inline_vars_.at(sym);
+}
+
 inline bool valid_cxx_name(std::string_view name) {
     if (name.empty()) return false;
     auto first = name[0];
@@ -213,6 +292,14 @@ std::string_view CodeGenModuleInformation::get_identifier_name(std::string_view
     }
 }
 
+const std::string &CodeGenModuleInformation::get_process_function_name(const Process *process) {
+    if (process_functions_.find(process) == process_functions_.end()) {
+        auto name = get_new_name("comb_process");
+        process_functions_.emplace(process, name);
+    }
+    return process_functions_.at(process);
+}
+
 std::pair<std::string_view, uint32_t> get_loc(const slang::SourceLocation &loc,
                                               const slang::Compilation *compilation) {
     if (!compilation) return {};
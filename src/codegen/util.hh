@@ -12,6 +12,19 @@ namespace fsim {
 auto constexpr main_name = "module";
 auto constexpr default_output_name = "fsim.out";
 
+// runtime headers included by every generated file. they are precompiled into the prelude, which
+// is included before any generated file is compiled. see NinjaCodeGen
+auto constexpr prelude_include = R"(#include "logic/array.hh"
+#include "logic/logic.hh"
+#include "logic/struct.hh"
+#include "logic/union.hh"
+#include "runtime/module.hh"
+#include "runtime/native.hh"
+#include "runtime/system_task.hh"
+#include "runtime/variable.hh"
+)";
+auto constexpr prelude_filename = "fsim_prelude.hh";
+
 void write_to_file(const std::string &filename, std::stringstream &stream, bool format = true);
 
 namespace util::fs {
@@ -33,6 +46,13 @@ inline std::string get_hh_filename(const T &name) {
     return fmt::format("{0}.hh", name);
 }
 
+// large modules are split into <name>.cc, <name>.1.cc, <name>.2.cc etc. dots are not allowed in
+// module names, so the parts never collide with other modules
+template <typename T>
+inline std::string get_part_name(const T &name, uint64_t part) {
+    return fmt::format("{0}.{1}", name, part);
+}
+
 class CodeGenModuleInformation {
 public:
     // used to hold different information while passing between different visitors
@@ -60,11 +80,52 @@ public:
 
     const Module *current_module = nullptr;
     const slang::SubroutineSymbol *current_function = nullptr;
+    // generate native integer operations for 2-state expressions
+    bool native_2state = false;
+    // non-empty when generating variables and processes of a child instance inlined into its
+    // parent
+    std::string_view inline_instance;
+    // delays of the current process that a process restored from a checkpoint can jump to
+    std::unordered_map<const slang::Statement *, uint32_t> resume_points;
+
+    [[nodiscard]] std::string module_pointer() const;
+    // ports of the inlined instance that share the storage with parent variables
+    Module::PortAliases port_aliases;
+
+    [[nodiscard]] const slang::ValueSymbol *get_port_alias(const slang::ValueSymbol *sym) const {
+        auto it = port_aliases.find(sym);
+        return it != port_aliases.end() ? it->second : nullptr;
+    }
 
     const slang::Compilation *get_compilation() const;
 
+    // inlined instances don't have an object of their own. their variables are members of the
+    // parent class, named after the instance
+    std::unordered_set<std::string_view> inlined_instances;
+    const std::string &add_inline_var(const slang::Symbol *sym);
+    [[nodiscard]] const std::string *get_inline_var_name(const slang::Symbol *sym) const {
+        auto it = inline_vars_.find(sym);
+        return it != inline_vars_.end() ? &it->second : nullptr;
+    }
+
     std::string_view get_identifier_name(std::string_view name);
 
+    // processes that are generated as class member functions
+    const std::string &get_process_function_name(const Process *process);
+    [[nodiscard]] bool has_process_function(const Process *process) const {
+        return process_functions_.find(process) != process_functions_.end();
+    }
+
+    // processes of a large module are set up in member functions of their own, each generated
+    // into a separate part file. see CXXCodeGenOptions::tu_complexity
+    struct ProcessChunk {
+        std::string function_name;
+        std::vector<const Process *> processes;
+    };
+    std::vector<ProcessChunk> init_chunks;
+    std::vector<ProcessChunk> comb_chunks;
+    std::vector<ProcessChunk> ff_chunks;
+
 private:
     std::stack<std::string> process_names_;
     std::unordered_set<std::string> used_names_;
@@ -74,6 +135,9 @@ private:
     // e.g. escaped identifiers
     std::unordered_map<std::string_view, std::string> renamed_identifier_;
 
+    std::unordered_map<const Process *, std::string> process_functions_;
+    std::unordered_map<const slang::Symbol *, std::string> inline_vars_;
+
     std::string scheduler_name_;
 };
 
@@ -74,23 +74,25 @@ std::vector<const DependencyAnalysisVisitor::Node *> sort(const DGraph *graph) {
     return result;
 }
 
-void Module::analyze() {
+void Module::analyze(const std::unordered_set<std::string> &skipped_defs) {
     analyze_connections();
 
-    // compute procedure combinational blocks
-    analyze_comb();
+    if (!skipped_defs.contains(std::string(name))) {
+        // compute procedure combinational blocks
+        analyze_comb();
 
-    analyze_init();
+        analyze_init();
 
-    analyze_final();
+        analyze_final();
 
-    analyze_ff();
+        analyze_ff();
+    }
 
     // analyze this all the functions calls
     analyze_function();
 
     // this is a recursive call to walk through all the module definitions
-    analyze_inst();
+    analyze_inst(skipped_defs);
 }
 
 class PortVariableSymbolCollector
@@ -254,6 +256,122 @@ private:
     std::unordered_set<const slang::Symbol *> provides;
 };
 
+// detects any statement that may suspend the process
+class ProcessSuspensionVisitor : public slang::ASTVisitor<ProcessSuspensionVisitor, true, true> {
+public:
+    [[maybe_unused]] void handle(const slang::TimedStatement &stmt) {
+        // @(*) is the only timing control that doesn't suspend the process
+        if (stmt.timing.kind != slang::TimingControlKind::ImplicitEvent) may_suspend = true;
+        visitDefault(stmt);
+    }
+
+    [[maybe_unused]] void handle(const slang::AssignmentExpression &expr) {
+        if (expr.timingControl) may_suspend = true;
+        visitDefault(expr);
+    }
+
+    [[maybe_unused]] void handle(const slang::WaitStatement &stmt) {
+        may_suspend = true;
+        visitDefault(stmt);
+    }
+
+    [[maybe_unused]] void handle(const slang::BlockStatement &stmt) {
+        // fork/join
+        if (stmt.blockKind != slang::StatementBlockKind::Sequential) may_suspend = true;
+        visitDefault(stmt);
+    }
+
+    [[maybe_unused]] void handle(const slang::CallExpression &call) {
+        // user tasks may contain timing controls
+        if (call.subroutine.index() == 0) {
+            auto const *subroutine = std::get<0>(call.subroutine);
+            if (subroutine->subroutineKind == slang::SubroutineKind::Task) may_suspend = true;
+        }
+        visitDefault(call);
+    }
+
+    bool may_suspend = false;
+};
+
+bool may_suspend(const Process *process) {
+    ProcessSuspensionVisitor visitor;
+    for (auto const *stmt : process->stmts) {
+        stmt->visit(visitor);
+    }
+    return visitor.may_suspend;
+}
+
+bool may_suspend(const slang::Statement &stmt) {
+    ProcessSuspensionVisitor visitor;
+    stmt.visit(visitor);
+    return visitor.may_suspend;
+}
+
+// collects module-level variables a process reads and writes
+class ProcessAccessVisitor : public slang::ASTVisitor<ProcessAccessVisitor, true, true> {
+public:
+    [[maybe_unused]] void handle(const slang::AssignmentExpression &expr) {
+        VariableExtractor v;
+        expr.left().visit(v);
+        for (auto const *name : v.vars) {
+            if (is_module_var(name->symbol)) writes.emplace(&name->symbol);
+        }
+        visitDefault(expr);
+    }
+
+    [[maybe_unused]] void handle(const slang::NamedValueExpression &expr) {
+        if (is_module_var(expr.symbol)) reads.emplace(&expr.symbol);
+    }
+
+    [[maybe_unused]] void handle(const slang::CallExpression &call) {
+        // user functions can access module variables we don't see here
+        if (!call.isSystemCall()) has_user_call = true;
+        visitDefault(call);
+    }
+
+    std::unordered_set<const slang::Symbol *> reads;
+    std::unordered_set<const slang::Symbol *> writes;
+    bool has_user_call = false;
+
+private:
+    static bool is_module_var(const slang::Symbol &sym) {
+        return !sym.getParentScope()->isProceduralContext();
+    }
+};
+
+bool intersect(const std::unordered_set<const slang::Symbol *> &a,
+               const std::unordered_set<const slang::Symbol *> &b) {
+    return std::any_of(a.begin(), a.end(), [&b](auto const *sym) { return b.contains(sym); });
+}
+
+void compute_comb_levels(const std::vector<std::unique_ptr<CombProcess>> &processes) {
+    // processes are already in topological order. a process has to be placed after any
+    // previous process that shares a variable with it, as long as one of them writes to it
+    std::vector<ProcessAccessVisitor> accesses(processes.size());
+    for (auto i = 0u; i < processes.size(); i++) {
+        auto const &p = processes[i];
+        if (p->kind == CombProcess::CombKind::GeneralPurpose) continue;
+        auto &access = accesses[i];
+        for (auto const *stmt : p->stmts) {
+            stmt->visit(access);
+        }
+        if (access.has_user_call) continue;
+
+        int level = 0;
+        for (auto j = 0u; j < i; j++) {
+            auto const &prev = processes[j];
+            if (prev->level < 0) continue;
+            auto const &prev_access = accesses[j];
+            if (intersect(access.writes, prev_access.reads) ||
+                intersect(access.reads, prev_access.writes) ||
+                intersect(access.writes, prev_access.writes)) {
+                level = std::max(level, prev->level + 1);
+            }
+        }
+        p->level = level;
+    }
+}
+
 void Module::analyze_comb() {
     DependencyAnalysisVisitor v(def_);
     def_->visit(v);
@@ -330,7 +448,11 @@ void Module::analyze_comb() {
 
     for (auto const &p : comb_processes) {
         analyze_edge_event_control(p.get());
+        p->levelized = p->kind != CombProcess::CombKind::GeneralPurpose &&
+                       p->edge_event_controls.empty() && !may_suspend(p.get());
     }
+
+    compute_comb_levels(comb_processes);
 }
 
 void extract_procedure_blocks(std::vector<std::unique_ptr<Process>> &processes,
@@ -446,6 +568,9 @@ void Module::analyze_ff() {
             auto &process = ff_processes.emplace_back(std::make_unique<FFProcess>());
             process->edges = edges;
             process->stmts.emplace_back(stmt);
+            if (!may_suspend(timed_body.stmt)) {
+                process->body = &timed_body.stmt;
+            }
         }
     }
 
@@ -456,49 +581,50 @@ void Module::analyze_ff() {
 
 class ModuleAnalyzeVisitor : public slang::ASTVisitor<ModuleAnalyzeVisitor, false, false> {
 public:
-    explicit ModuleAnalyzeVisitor(Module *target) : target_(target) {}
+    ModuleAnalyzeVisitor(Module *target, const std::unordered_set<std::string> &skipped_defs)
+        : target_(target), skipped_defs_(skipped_defs) {}
     [[maybe_unused]] void handle(const slang::InstanceSymbol &inst) {
         if (target_->def() == &inst) {
             visitDefault(inst);
         } else {
             auto const &def = inst.getDefinition();
             if (def.definitionKind == slang::DefinitionKind::Module) {
-                // child instance
-                auto def_name = inst.getDefinition().name;
+                // child instance. every instance is analyzed on its own since port connections
+                // differ between instances of the same definition
                 // TODO. deal with parametrization
-                if (module_defs_.find(def_name) == module_defs_.end()) {
-                    auto child = std::make_shared<Module>(&inst);
-                    module_defs_.emplace(def_name, child);
-                    // this will call the analysis function recursively
-                    child->analyze();
-                }
-                auto c = module_defs_.at(def_name);
-                target_->child_instances.emplace(inst.name, c);
+                auto child = std::make_shared<Module>(&inst);
+                // this will call the analysis function recursively
+                child->analyze(skipped_defs_);
+                target_->child_instances.emplace(inst.name, child);
             }
         }
     }
 
 private:
-    std::unordered_map<std::string_view, std::shared_ptr<Module>> module_defs_;
     Module *target_;
+    const std::unordered_set<std::string> &skipped_defs_;
 };
 
-void Module::analyze_inst() {
-    ModuleAnalyzeVisitor vis(this);
+void Module::analyze_inst(const std::unordered_set<std::string> &skipped_defs) {
+    ModuleAnalyzeVisitor vis(this, skipped_defs);
     def_->visit(vis);
 }
 
 // NOLINTNEXTLINE
-void get_defs(const Module *module, std::unordered_set<const Module *> &result) {
+void get_defs(const Module *module, std::unordered_set<std::string_view> &names,
+              std::unordered_set<const Module *> &result) {
+    // instances of the same definition share the generated class
+    if (!names.emplace(module->name).second) return;
     result.emplace(module);
     for (auto const &[_, inst] : module->child_instances) {
-        get_defs(inst.get(), result);
+        get_defs(inst.get(), names, result);
     }
 }
 
 std::unordered_set<const Module *> Module::get_defs() const {
     std::unordered_set<const Module *> result;
-    ::fsim::get_defs(this, result);
+    std::unordered_set<std::string_view> names;
+    ::fsim::get_defs(this, names, result);
     return result;
 }
 
@@ -548,6 +674,15 @@ std::unordered_set<std::string_view> Module::get_tracked_vars() const {
         }
     }
 
+    // variables aliased by child output ports have to be tracked since they are used in place of
+    // the output ports
+    for (auto const &iter : child_instances) {
+        auto const &aliases = iter.second->get_port_aliases();
+        for (auto const &[_, var] : aliases) {
+            result.emplace(var->name);
+        }
+    }
+
     return result;
 }
 
@@ -580,4 +715,35 @@ std::vector<const slang::SubroutineSymbol *> Module::get_global_functions() cons
     return res;
 }
 
+void add_port_aliases(const std::vector<Module::PortDef> &ports, const Module *mod,
+                      Module::PortAliases &aliases) {
+    for (auto const &[port, expr] : ports) {
+        if (expr->kind != slang::ExpressionKind::NamedValue) continue;
+        auto const *port_var = mod->port_vars.at(port->name);
+        auto const &var = expr->as<slang::NamedValueExpression>().symbol;
+        if (!port_var->getType().isMatching(var.getType())) continue;
+        aliases.emplace(port_var, &var);
+    }
+}
+
+Module::PortAliases Module::get_port_aliases() const {
+    PortAliases result;
+    add_port_aliases(inputs, this, result);
+    add_port_aliases(outputs, this, result);
+    return result;
+}
+
+uint64_t Module::complexity() const {
+    ModuleComplexityVisitor v;
+    def_->body.visit(v);
+    return v.complexity;
+}
+
+bool Module::inlinable(uint64_t threshold) const {
+    // only leaf modules are inlined. initial/final blocks and functions are generated as part of
+    // the module class, so modules that have them are kept as is
+    return child_instances.empty() && init_processes.empty() && final_processes.empty() &&
+           functions.empty() && complexity() <= threshold;
+}
+
 }  // namespace fsim
\ No newline at end of file
@@ -37,12 +37,26 @@ public:
     std::vector<const slang::Symbol *> sensitive_list;
 
     CombKind kind;
+
+    // no timing control inside the process. it can be evaluated directly in topological order
+    // without a fiber
+    bool levelized = false;
+
+    // processes with the same level don't share any variable that either of them writes to, so
+    // they can be evaluated in parallel. -1 means it has to be evaluated serially after all the
+    // levels
+    int level = -1;
 };
 
 class FFProcess : public Process {
 public:
     FFProcess() : Process(slang::ProceduralBlockKind::AlwaysFF) {}
     std::vector<std::pair<slang::EdgeKind, const slang::ValueSymbol *>> edges;
+
+    // statement after the edge list. only set when there is no other timing control inside, in
+    // which case the process can be evaluated directly on edges, e.g. batched with other processes
+    // that share the same edges
+    const slang::Statement *body = nullptr;
 };
 
 class Function {
@@ -77,7 +91,9 @@ public:
     // functions, tasks etc
     std::vector<std::unique_ptr<Function>> functions;
 
-    void analyze();
+    // definitions in skipped_defs only have their ports, functions and child instances analyzed,
+    // which is all their parents need. see builder/fingerprint.hh
+    void analyze(const std::unordered_set<std::string> &skipped_defs = {});
 
     // circular dependencies is not allowed in SV, so shared pointer is fine
     std::map<std::string, std::shared_ptr<Module>> child_instances;
@@ -92,6 +108,16 @@ public:
 
     [[nodiscard]] std::vector<const slang::SubroutineSymbol *> get_global_functions() const;
 
+    // port variables that are directly connected to a variable with the same type in the parent
+    // module. they can share the storage with the parent variable
+    using PortAliases = std::unordered_map<const slang::ValueSymbol *, const slang::ValueSymbol *>;
+    [[nodiscard]] PortAliases get_port_aliases() const;
+
+    // complexity of the module definition, computed by ModuleComplexityVisitor
+    [[nodiscard]] uint64_t complexity() const;
+    // whether the module can be inlined into its parent module
+    [[nodiscard]] bool inlinable(uint64_t threshold) const;
+
 private:
     const slang::InstanceSymbol *def_;
 
@@ -102,7 +128,7 @@ private:
     void analyze_final();
     void analyze_function();
 
-    void analyze_inst();
+    void analyze_inst(const std::unordered_set<std::string> &skipped_defs);
 };
 
 }  // namespace fsim
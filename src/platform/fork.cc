@@ -0,0 +1,37 @@
+#include "fork.hh"
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace fsim::platform {
+
+std::optional<int64_t> fork_process() {
+#ifdef _WIN32
+    return std::nullopt;
+#else
+    auto pid = ::fork();
+    if (pid < 0) return std::nullopt;
+    return pid;
+#endif
+}
+
+std::optional<ChildExit> wait_child() {
+#ifdef _WIN32
+    return std::nullopt;
+#else
+    int status;
+    pid_t pid;
+    do {
+        pid = ::waitpid(-1, &status, 0);
+    } while (pid < 0 && errno == EINTR);
+    if (pid < 0) return std::nullopt;
+    int code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return ChildExit{pid, code};
+#endif
+}
+
+}  // namespace fsim::platform
@@ -0,0 +1,25 @@
+#ifndef FSIM_PLATFORM_FORK_HH
+#define FSIM_PLATFORM_FORK_HH
+
+#include <cstdint>
+#include <optional>
+
+namespace fsim::platform {
+
+// copy-on-write copy of the current process. only the calling thread is copied.
+// returns 0 in the child, the child id in the parent, and nullopt if the process can't be forked
+// or fork is not available, e.g. on Windows
+std::optional<int64_t> fork_process();
+
+struct ChildExit {
+    int64_t id;
+    // non-zero if the child is killed by a signal
+    int code;
+};
+
+// waits for any child of the current process to exit. nullopt if there is no child
+std::optional<ChildExit> wait_child();
+
+}  // namespace fsim::platform
+
+#endif  // FSIM_PLATFORM_FORK_HH
@@ -0,0 +1,58 @@
+#include "mmap.hh"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fsim::platform {
+
+MappedFile::MappedFile(const std::string &filename) {
+#ifdef _WIN32
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        return;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) return;
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) return;
+    auto *ptr = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!ptr) return;
+    data_ = static_cast<const std::byte *>(ptr);
+    size_ = static_cast<uint64_t>(size.QuadPart);
+#else
+    auto fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st {};
+    // empty files can't be mapped
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        auto size = static_cast<uint64_t>(st.st_size);
+        auto *ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            data_ = static_cast<const std::byte *>(ptr);
+            size_ = size;
+        }
+    }
+    // the mapping stays valid after the file is closed
+    ::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+#else
+    if (data_) ::munmap(const_cast<std::byte *>(data_), size_);
+#endif
+}
+
+}  // namespace fsim::platform
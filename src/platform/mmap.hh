@@ -0,0 +1,33 @@
+#ifndef FSIM_PLATFORM_MMAP_HH
+#define FSIM_PLATFORM_MMAP_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fsim::platform {
+
+// read-only mapping of a whole file. data() is nullptr if the file can't be mapped
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &filename);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    [[nodiscard]] const std::byte *data() const { return data_; }
+    [[nodiscard]] uint64_t size() const { return size_; }
+
+private:
+    const std::byte *data_ = nullptr;
+    uint64_t size_ = 0;
+#ifdef _WIN32
+    void *file_ = nullptr;
+    void *mapping_ = nullptr;
+#endif
+};
+
+}  // namespace fsim::platform
+
+#endif  // FSIM_PLATFORM_MMAP_HH
@@ -0,0 +1,93 @@
+#include "batch.hh"
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "fmt/format.h"
+#include "module.hh"
+#include "scheduler.hh"
+
+namespace fsim::runtime {
+
+constexpr std::string_view batch_arg = "+fsim_batch=";
+constexpr std::string_view batch_args_arg = "+fsim_batch_args=";
+constexpr std::string_view batch_log_arg = "+fsim_batch_log=";
+
+std::vector<std::vector<std::string>> read_instance_args(const std::string &filename) {
+    std::ifstream stream(filename);
+    if (!stream.is_open()) {
+        throw std::runtime_error(fmt::format("Unable to open {0}", filename));
+    }
+    std::vector<std::vector<std::string>> result;
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::istringstream ss(line);
+        auto &args = result.emplace_back();
+        std::string arg;
+        while (ss >> arg) {
+            args.emplace_back(arg);
+        }
+    }
+    return result;
+}
+
+Batch::Batch(int argc, char *argv[]) {
+    for (auto i = 0; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg.starts_with(batch_arg)) {
+            num_instances_ = std::stoull(std::string(arg.substr(batch_arg.size())));
+        } else if (arg.starts_with(batch_args_arg)) {
+            instance_args_ = read_instance_args(std::string(arg.substr(batch_args_arg.size())));
+        } else if (arg.starts_with(batch_log_arg)) {
+            log_prefix_ = arg.substr(batch_log_arg.size());
+        } else {
+            common_args_.emplace_back(arg);
+        }
+    }
+}
+
+std::vector<std::string> Batch::instance_args(uint64_t index) const {
+    auto result = common_args_;
+    if (index < instance_args_.size()) {
+        auto const &args = instance_args_[index];
+        result.insert(result.end(), args.begin(), args.end());
+    }
+    return result;
+}
+
+std::string Batch::log_filename(uint64_t index) const {
+    return fmt::format("{0}.{1}.log", log_prefix_, index);
+}
+
+void Batch::run(const ModuleFactory &create_top, const SchedulerConfig &config) const {
+    marl::Scheduler workers(marl::Scheduler::Config::allCores());
+    // every running instance blocks one thread while waiting for its processes, so the number of
+    // concurrent instances is bounded
+    auto num_threads = std::min<uint64_t>(num_instances_, std::thread::hardware_concurrency());
+    num_threads = std::max<uint64_t>(num_threads, 1);
+    std::atomic<uint64_t> next_instance = 0;
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (auto i = 0u; i < num_threads; i++) {
+        threads.emplace_back([&]() {
+            uint64_t index;
+            while ((index = next_instance.fetch_add(1)) < num_instances_) {
+                std::ofstream output(log_filename(index));
+                Scheduler scheduler(&workers);
+                scheduler.set_args(instance_args(index));
+                if (config) config(scheduler);
+                auto top = create_top();
+                top->set_output(&output);
+                scheduler.run(top.get());
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace fsim::runtime
@@ -0,0 +1,44 @@
+#ifndef FSIM_BATCH_HH
+#define FSIM_BATCH_HH
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fsim::runtime {
+
+class Module;
+class Scheduler;
+
+// one list of plusargs per line
+std::vector<std::vector<std::string>> read_instance_args(const std::string &filename);
+
+// runs multiple copies of the same design in one process, e.g. different seeds of the same test.
+// each copy has its own scheduler, plusargs and output file, and all of them share one worker
+// pool. it is turned on by +fsim_batch=<num>. instance i gets the plusargs in line i of
+// +fsim_batch_args=<file> on top of the common ones, and writes its output to <prefix>.<i>.log,
+// where the prefix is set by +fsim_batch_log=<prefix>
+class Batch {
+public:
+    Batch(int argc, char *argv[]);
+
+    [[nodiscard]] bool enabled() const { return num_instances_ > 0; }
+    [[nodiscard]] uint64_t num_instances() const { return num_instances_; }
+    [[nodiscard]] std::vector<std::string> instance_args(uint64_t index) const;
+    [[nodiscard]] std::string log_filename(uint64_t index) const;
+
+    using ModuleFactory = std::function<std::unique_ptr<Module>()>;
+    using SchedulerConfig = std::function<void(Scheduler &)>;
+    void run(const ModuleFactory &create_top, const SchedulerConfig &config = {}) const;
+
+private:
+    uint64_t num_instances_ = 0;
+    std::string log_prefix_ = "fsim";
+    std::vector<std::string> common_args_;
+    std::vector<std::vector<std::string>> instance_args_;
+};
+
+}  // namespace fsim::runtime
+
+#endif  // FSIM_BATCH_HH
@@ -0,0 +1,130 @@
+#include "checkpoint.hh"
+
+#include <fstream>
+
+#include "fmt/format.h"
+#include "mmap.hh"
+#include "module.hh"
+
+namespace fsim::runtime {
+
+static_assert(std::is_trivially_copyable_v<CheckpointHeader> && sizeof(CheckpointHeader) % 8 == 0);
+static_assert(std::is_trivially_copyable_v<ProcessRecord> && sizeof(ProcessRecord) % 8 == 0);
+static_assert(std::is_trivially_copyable_v<VarRecord> && sizeof(VarRecord) % 8 == 0);
+
+constexpr uint64_t align_value(uint64_t size) { return (size + 7) & ~7ull; }
+
+Checkpoint::Checkpoint(Module *top) { top->checkpoint_vars(this); }
+
+uint64_t Checkpoint::hash_name(std::string_view name) {
+    // FNV-1a, which is stable across builds
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (auto c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::vector<VarRecord> Checkpoint::records() const {
+    std::vector<VarRecord> result;
+    result.reserve(vars_.size());
+    uint64_t offset = 0;
+    for (auto const &var : vars_) {
+        result.emplace_back(VarRecord{var.name_hash, offset, var.size});
+        offset += align_value(var.size);
+    }
+    return result;
+}
+
+void Checkpoint::save_values(const std::vector<VarRecord> &records, std::byte *data) const {
+    for (auto i = 0u; i < vars_.size(); i++) {
+        vars_[i].save(vars_[i].var, data + records[i].offset);
+    }
+}
+
+void Checkpoint::restore_values(std::span<const VarRecord> records, const std::byte *data) const {
+    if (records.size() != vars_.size()) {
+        throw std::runtime_error("Checkpoint variables do not match the design");
+    }
+    for (auto i = 0u; i < vars_.size(); i++) {
+        if (records[i].name_hash != vars_[i].name_hash || records[i].size != vars_[i].size) {
+            throw std::runtime_error("Checkpoint variables do not match the design");
+        }
+    }
+    for (auto i = 0u; i < vars_.size(); i++) {
+        vars_[i].restore(vars_[i].var, data + records[i].offset);
+    }
+}
+
+CheckpointFile::CheckpointFile(const std::string &filename)
+    : file_(std::make_unique<platform::MappedFile>(filename)) {
+    auto const *data = file_->data();
+    auto size = file_->size();
+    if (!data) {
+        throw std::runtime_error(fmt::format("Unable to open {0}", filename));
+    }
+    auto invalid = [&filename]() {
+        return std::runtime_error(fmt::format("{0} is not a valid checkpoint", filename));
+    };
+    if (size < sizeof(CheckpointHeader)) throw invalid();
+    // the mapping is page aligned, so every record is properly aligned
+    header_ = reinterpret_cast<const CheckpointHeader *>(data);
+    auto const &header = *header_;
+    if (header.magic != CheckpointHeader::magic_value ||
+        header.version != CheckpointHeader::current_version || header.file_size != size) {
+        throw invalid();
+    }
+    auto num_processes =
+        header.num_init_processes + header.num_comb_processes + header.num_ff_processes;
+    if (header.process_offset + num_processes * sizeof(ProcessRecord) > header.var_offset ||
+        header.var_offset + header.num_vars * sizeof(VarRecord) > header.data_offset ||
+        header.data_offset > size) {
+        throw invalid();
+    }
+    processes_ = {reinterpret_cast<const ProcessRecord *>(data + header.process_offset),
+                  num_processes};
+    vars_ = {reinterpret_cast<const VarRecord *>(data + header.var_offset), header.num_vars};
+    data_ = data + header.data_offset;
+    for (auto const &var : vars_) {
+        if (header.data_offset + var.offset + var.size > size) throw invalid();
+    }
+}
+
+CheckpointFile::~CheckpointFile() = default;
+
+void CheckpointFile::write(const std::string &filename, const CheckpointHeader &header,
+                           const std::vector<ProcessRecord> &processes, const Checkpoint &vars) {
+    auto records = vars.records();
+    auto data_size = records.empty() ? 0 : records.back().offset + align_value(records.back().size);
+
+    auto result = header;
+    result.magic = CheckpointHeader::magic_value;
+    result.version = CheckpointHeader::current_version;
+    result.num_vars = records.size();
+    result.process_offset = sizeof(CheckpointHeader);
+    result.var_offset = result.process_offset + processes.size() * sizeof(ProcessRecord);
+    result.data_offset = result.var_offset + records.size() * sizeof(VarRecord);
+    result.file_size = result.data_offset + data_size;
+
+    std::vector<std::byte> buffer(result.file_size);
+    std::memcpy(buffer.data(), &result, sizeof(result));
+    if (!processes.empty()) {
+        std::memcpy(buffer.data() + result.process_offset, processes.data(),
+                    processes.size() * sizeof(ProcessRecord));
+    }
+    if (!records.empty()) {
+        std::memcpy(buffer.data() + result.var_offset, records.data(),
+                    records.size() * sizeof(VarRecord));
+    }
+    vars.save_values(records, buffer.data() + result.data_offset);
+
+    std::ofstream stream(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!stream.is_open()) {
+        throw std::runtime_error(fmt::format("Unable to open {0}", filename));
+    }
+    stream.write(reinterpret_cast<const char *>(buffer.data()),
+                 static_cast<std::streamsize>(buffer.size()));
+}
+
+}  // namespace fsim::runtime
@@ -0,0 +1,158 @@
+#ifndef FSIM_CHECKPOINT_HH
+#define FSIM_CHECKPOINT_HH
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace fsim::platform {
+class MappedFile;
+}
+
+namespace fsim::runtime {
+
+class Module;
+class TrackedVar;
+
+// checkpoint file layout. every record has a fixed size and values are 8-byte aligned, so the file
+// is mapped as is and restoring a variable is a plain copy out of the mapping
+//   header, process records, variable records, value data
+struct CheckpointHeader {
+    static constexpr std::array<char, 8> magic_value = {'F', 'S', 'I', 'M', 'C', 'K', 'P', 'T'};
+    static constexpr uint64_t current_version = 1;
+
+    std::array<char, 8> magic;
+    uint64_t version;
+    uint64_t sim_time;
+    // used to check that the checkpoint is taken from the same design
+    uint64_t num_init_processes;
+    uint64_t num_comb_processes;
+    uint64_t num_ff_processes;
+    uint64_t num_vars;
+    // offsets from the start of the file
+    uint64_t process_offset;
+    uint64_t var_offset;
+    uint64_t data_offset;
+    uint64_t file_size;
+};
+
+// processes are stored in creation order, init processes first, then comb and ff processes
+struct ProcessRecord {
+    enum class State : uint32_t {
+        // finished, or waiting for its sensitivity list
+        idle = 0,
+        // suspended at a resume point until event_time
+        delayed = 1
+    };
+
+    State state;
+    uint32_t resume_point;
+    uint64_t event_time;
+};
+
+struct VarRecord {
+    uint64_t name_hash;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// only the value of a tracked variable is saved. the tracking state is rebuilt by the design
+template <typename T, bool = std::is_base_of_v<TrackedVar, T>>
+struct checkpoint_value {
+    using type = T;
+};
+
+template <typename T>
+struct checkpoint_value<T, true> {
+    using type = typename T::value_type;
+};
+
+// variables of the design in the order the generated Module::checkpoint_vars visits them
+class Checkpoint {
+public:
+    explicit Checkpoint(Module *top);
+
+    // called by the generated Module::checkpoint_vars
+    template <typename T>
+    void add_var(T &var, std::string_view name);
+    // unpacked arrays are saved element by element. elements share the name of the array
+    template <typename T, std::size_t N>
+    void add_var(T (&var)[N], std::string_view name) {
+        for (auto &v : var) {
+            add_var(v, name);
+        }
+    }
+
+    [[nodiscard]] uint64_t num_vars() const { return vars_.size(); }
+    // the value data layout is computed from the variable sizes
+    [[nodiscard]] std::vector<VarRecord> records() const;
+    void save_values(const std::vector<VarRecord> &records, std::byte *data) const;
+    // throws std::runtime_error if the records don't match the variables
+    void restore_values(std::span<const VarRecord> records, const std::byte *data) const;
+
+private:
+    struct Var {
+        void *var;
+        uint64_t name_hash;
+        uint64_t size;
+        void (*save)(const void *var, std::byte *data);
+        void (*restore)(void *var, const std::byte *data);
+    };
+
+    std::vector<Var> vars_;
+
+    static uint64_t hash_name(std::string_view name);
+};
+
+template <typename T>
+void Checkpoint::add_var(T &var, std::string_view name) {
+    using V = typename checkpoint_value<T>::type;
+    if constexpr (std::is_trivially_copyable_v<V>) {
+        vars_.emplace_back(Var{
+            &var, hash_name(name), sizeof(V),
+            [](const void *ptr, std::byte *data) {
+                std::memcpy(data, &static_cast<const V &>(*static_cast<const T *>(ptr)), sizeof(V));
+            },
+            [](void *ptr, const std::byte *data) {
+                // assign through the value type so that restoring doesn't trigger any process
+                V value;
+                std::memcpy(&value, data, sizeof(V));
+                static_cast<V &>(*static_cast<T *>(ptr)) = value;
+            }});
+    } else {
+        throw std::runtime_error("Unable to checkpoint variable " + std::string(name));
+    }
+}
+
+// a mapped checkpoint file
+class CheckpointFile {
+public:
+    // throws std::runtime_error if the file is not a valid checkpoint
+    explicit CheckpointFile(const std::string &filename);
+    ~CheckpointFile();
+
+    [[nodiscard]] const CheckpointHeader &header() const { return *header_; }
+    [[nodiscard]] std::span<const ProcessRecord> processes() const { return processes_; }
+    [[nodiscard]] std::span<const VarRecord> vars() const { return vars_; }
+    [[nodiscard]] const std::byte *data() const { return data_; }
+
+    static void write(const std::string &filename, const CheckpointHeader &header,
+                      const std::vector<ProcessRecord> &processes, const Checkpoint &vars);
+
+private:
+    std::unique_ptr<platform::MappedFile> file_;
+    const CheckpointHeader *header_ = nullptr;
+    std::span<const ProcessRecord> processes_;
+    std::span<const VarRecord> vars_;
+    const std::byte *data_ = nullptr;
+};
+
+}  // namespace fsim::runtime
+
+#endif  // FSIM_CHECKPOINT_HH
@@ -0,0 +1,372 @@
+#include "dump.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <unordered_map>
+
+#include "module.hh"
+#include "variable.hh"
+#include "version.hh"
+#include "wave.hh"
+
+namespace fsim::runtime {
+
+// ids are never reused so a stale thread local entry can't point to a ring of a new dumper
+static std::atomic<uint64_t> dumper_count = 0;
+
+// LRM 21.7.2.1. identifiers are made of printable ASCII characters
+std::string vcd_code(uint64_t id) {
+    constexpr char first = '!';
+    constexpr uint64_t num_chars = '~' - '!' + 1;
+    std::string result;
+    do {
+        result.push_back(static_cast<char>(first + id % num_chars));
+        id /= num_chars;
+    } while (id);
+    return result;
+}
+
+// LRM 21.7.2
+class VCDWriter : public WaveformWriter {
+public:
+    explicit VCDWriter(const std::string &filename);
+
+    void write_header(const std::vector<DumpVar> &vars, uint64_t time,
+                      const std::vector<std::string> &values) override;
+    void write_change(uint64_t time, uint32_t id, std::string_view value) override;
+    void write_dump_off(uint64_t time) override;
+    void write_dump_on(uint64_t time, const std::vector<std::string> &values) override;
+    void close() override;
+
+private:
+    std::ofstream stream_;
+    std::vector<std::string> codes_;
+    std::vector<uint64_t> widths_;
+    bool time_written_ = false;
+    uint64_t last_time_ = 0;
+
+    void write_time(uint64_t time);
+    void write_value(uint32_t id, std::string_view value);
+};
+
+std::vector<std::string_view> split_scope(std::string_view name) {
+    std::vector<std::string_view> result;
+    while (!name.empty()) {
+        auto pos = name.find('.');
+        result.emplace_back(name.substr(0, pos));
+        if (pos == std::string_view::npos) break;
+        name = name.substr(pos + 1);
+    }
+    return result;
+}
+
+Dumper::Dumper(const uint64_t *sim_time)
+    : sim_time_(sim_time), dumper_id_(dumper_count.fetch_add(1) + 1) {}
+
+Dumper::~Dumper() { close(*sim_time_); }
+
+void Dumper::set_filename(std::string_view filename) {
+    std::lock_guard guard(vars_lock_);
+    if (!vars_.empty()) return;
+    filename_ = filename;
+}
+
+void Dumper::add_scope(Module *module, std::string_view scope_name, uint64_t levels) {
+    auto scopes = split_scope(scope_name);
+    {
+        std::lock_guard guard(vars_lock_);
+        scope_stack_ = std::vector<std::string>(scopes.begin(), scopes.end());
+    }
+    module->dump_vars(this, levels);
+    {
+        std::lock_guard guard(vars_lock_);
+        scope_stack_.clear();
+    }
+}
+
+void Dumper::add_instance(Module *module, std::string_view name, uint64_t levels) {
+    // the caller has used up the last level
+    if (levels == 1) return;
+    push_scope(name);
+    module->dump_vars(this, levels == 0 ? 0 : levels - 1);
+    pop_scope();
+}
+
+void Dumper::push_scope(std::string_view name) {
+    std::lock_guard guard(vars_lock_);
+    scope_stack_.emplace_back(name);
+}
+
+void Dumper::pop_scope() {
+    std::lock_guard guard(vars_lock_);
+    scope_stack_.pop_back();
+}
+
+void Dumper::register_var(Var var) {
+    std::lock_guard guard(vars_lock_);
+    if (started_ || var.var->dumper == this) return;
+    if (vars_.empty()) start();
+
+    auto id = static_cast<uint32_t>(vars_.size());
+    for (auto const &scope : scope_stack_) {
+        if (!var.info.scope.empty()) var.info.scope.append(".");
+        var.info.scope.append(scope);
+    }
+    var.var->dump_id = id;
+    var.var->dumper = this;
+    auto &v = vars_.emplace_back(std::move(var));
+    // initial value
+    v.snapshot(this, v.var, id);
+}
+
+void Dumper::dump_on() {
+    if (closed_ || enabled_.exchange(true)) return;
+    // changes are dropped while dumping is off, so the writer needs every current value
+    std::lock_guard guard(vars_lock_);
+    for (auto i = 0u; i < vars_.size(); i++) {
+        vars_[i].snapshot(this, vars_[i].var, i);
+    }
+}
+
+void Dumper::dump_off() { enabled_ = false; }
+
+ChangeRing *Dumper::local_ring() {
+    thread_local uint64_t cached_id = 0;
+    thread_local ChangeRing *cached_ring = nullptr;
+    if (cached_id == dumper_id_) [[likely]] {
+        return cached_ring;
+    }
+
+    thread_local std::unordered_map<uint64_t, ChangeRing *> rings;
+    auto &ring = rings[dumper_id_];
+    if (!ring) {
+        std::lock_guard guard(rings_lock_);
+        ring = rings_.emplace_back(std::make_unique<ChangeRing>()).get();
+    }
+    cached_id = dumper_id_;
+    cached_ring = ring;
+    return ring;
+}
+
+ValueChange *Dumper::acquire(ChangeRing *ring) {
+    auto *change = ring->try_acquire();
+    while (!change) [[unlikely]] {
+        // back pressure. wake up the writer and wait for it to drain the rings
+        {
+            std::lock_guard guard(lock_);
+            drain_requested_ = true;
+        }
+        cond_.notify_one();
+        std::this_thread::yield();
+        change = ring->try_acquire();
+    }
+    return change;
+}
+
+void Dumper::start() {
+    if (filename_.ends_with(".fwv")) {
+        waveform_ = std::make_unique<CompactWaveWriter>(filename_);
+    } else {
+        waveform_ = std::make_unique<VCDWriter>(filename_);
+    }
+    writer_thread_ = std::thread([this] { write_loop(); });
+}
+
+void Dumper::end_time_step(uint64_t time) {
+    {
+        std::lock_guard guard(vars_lock_);
+        if (vars_.empty() || closed_) return;
+        started_ = true;
+    }
+    {
+        std::lock_guard guard(lock_);
+        steps_.emplace_back(TimeStep{time, enabled_.load()});
+    }
+    cond_.notify_one();
+}
+
+void Dumper::close(uint64_t time) {
+    if (!writer_thread_.joinable()) return;
+    end_time_step(time);
+    {
+        std::lock_guard guard(lock_);
+        closing_ = true;
+    }
+    cond_.notify_one();
+    writer_thread_.join();
+    // nothing drains the rings anymore
+    enabled_ = false;
+    closed_ = true;
+}
+
+void Dumper::write_loop() {
+    using namespace std::chrono_literals;
+    std::unique_lock lock(lock_);
+    while (true) {
+        // the timeout keeps the rings from filling up during long time steps
+        cond_.wait_for(lock, 10ms,
+                       [this] { return !steps_.empty() || closing_ || drain_requested_; });
+        auto steps = std::move(steps_);
+        steps_.clear();
+        drain_requested_ = false;
+        auto closing = closing_;
+        lock.unlock();
+
+        drain();
+        // changes are in time order once sorted, since time steps never overlap
+        std::sort(pending_.begin(), pending_.end(),
+                  [](auto const &a, auto const &b) { return a.seq < b.seq; });
+        uint64_t done = 0;
+        for (auto const &step : steps) {
+            done = write_step(step, done);
+        }
+        pending_.erase(pending_.begin(), pending_.begin() + static_cast<int64_t>(done));
+
+        lock.lock();
+        if (closing && steps_.empty()) break;
+    }
+    waveform_->close();
+}
+
+void Dumper::drain() {
+    std::lock_guard guard(rings_lock_);
+    for (auto &ring : rings_) {
+        // changes are formatted in write_step, since variables may still be registered
+        ring->drain([this](ValueChange &change) { pending_.emplace_back(std::move(change)); });
+    }
+}
+
+uint64_t Dumper::write_step(const TimeStep &step, uint64_t first) {
+    // only the last value of each variable in the time step is dumped
+    current_.resize(vars_.size());
+    emitted_.resize(vars_.size());
+    auto last = first;
+    for (; last < pending_.size() && pending_[last].time <= step.time; last++) {
+        auto &change = pending_[last];
+        current_[change.id] = vars_[change.id].format(change);
+        changed_.emplace_back(change.id);
+    }
+    std::sort(changed_.begin(), changed_.end());
+    changed_.erase(std::unique(changed_.begin(), changed_.end()), changed_.end());
+
+    if (!header_written_) {
+        std::vector<DumpVar> vars;
+        vars.reserve(vars_.size());
+        for (auto const &var : vars_) {
+            vars.emplace_back(var.info);
+        }
+        waveform_->write_header(vars, step.time, current_);
+        emitted_ = current_;
+        header_written_ = true;
+    } else if (dumping_) {
+        for (auto id : changed_) {
+            if (current_[id] == emitted_[id]) continue;
+            waveform_->write_change(step.time, id, current_[id]);
+            emitted_[id] = current_[id];
+        }
+    }
+    changed_.clear();
+
+    if (dumping_ != step.enabled) {
+        dumping_ = step.enabled;
+        if (dumping_) {
+            waveform_->write_dump_on(step.time, current_);
+            emitted_ = current_;
+        } else {
+            waveform_->write_dump_off(step.time);
+        }
+    }
+    waveform_->end_time_step(step.time);
+    return last;
+}
+
+VCDWriter::VCDWriter(const std::string &filename)
+    : stream_(filename, std::ios::out | std::ios::trunc) {}
+
+void VCDWriter::write_header(const std::vector<DumpVar> &vars, uint64_t time,
+                             const std::vector<std::string> &values) {
+    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    char date[64];
+    std::strftime(date, sizeof(date), "%c", std::localtime(&now));
+    stream_ << "$date\n    " << date << "\n$end\n";
+    stream_ << "$version\n    fsim " << VERSION << "\n$end\n";
+    // fsim doesn't model timescale
+    stream_ << "$timescale 1ns $end\n";
+
+    // variables are registered in depth first order, so the scopes are properly nested
+    std::vector<std::string_view> scopes;
+    for (auto i = 0u; i < vars.size(); i++) {
+        auto const &var = vars[i];
+        auto var_scopes = split_scope(var.scope);
+        uint64_t common = 0;
+        while (common < scopes.size() && common < var_scopes.size() &&
+               scopes[common] == var_scopes[common]) {
+            common++;
+        }
+        for (auto j = common; j < scopes.size(); j++) {
+            stream_ << "$upscope $end\n";
+        }
+        for (auto j = common; j < var_scopes.size(); j++) {
+            stream_ << "$scope module " << var_scopes[j] << " $end\n";
+        }
+        scopes = var_scopes;
+        codes_.emplace_back(vcd_code(i));
+        widths_.emplace_back(var.width);
+        stream_ << "$var wire " << var.width << " " << codes_[i] << " " << var.name << " $end\n";
+    }
+    for (auto i = 0u; i < scopes.size(); i++) {
+        stream_ << "$upscope $end\n";
+    }
+    stream_ << "$enddefinitions $end\n";
+
+    write_time(time);
+    stream_ << "$dumpvars\n";
+    for (auto i = 0u; i < values.size(); i++) {
+        write_value(i, values[i]);
+    }
+    stream_ << "$end\n";
+}
+
+void VCDWriter::write_change(uint64_t time, uint32_t id, std::string_view value) {
+    write_time(time);
+    write_value(id, value);
+}
+
+void VCDWriter::write_dump_off(uint64_t time) {
+    write_time(time);
+    stream_ << "$dumpoff\n";
+    for (auto i = 0u; i < codes_.size(); i++) {
+        write_value(i, "x");
+    }
+    stream_ << "$end\n";
+}
+
+void VCDWriter::write_dump_on(uint64_t time, const std::vector<std::string> &values) {
+    write_time(time);
+    stream_ << "$dumpon\n";
+    for (auto i = 0u; i < values.size(); i++) {
+        write_value(i, values[i]);
+    }
+    stream_ << "$end\n";
+}
+
+void VCDWriter::close() { stream_.close(); }
+
+void VCDWriter::write_time(uint64_t time) {
+    if (time_written_ && time == last_time_) return;
+    stream_ << "#" << time << '\n';
+    last_time_ = time;
+    time_written_ = true;
+}
+
+void VCDWriter::write_value(uint32_t id, std::string_view value) {
+    if (widths_[id] == 1) {
+        stream_ << value << codes_[id] << '\n';
+    } else {
+        stream_ << "b" << value << " " << codes_[id] << '\n';
+    }
+}
+
+}  // namespace fsim::runtime
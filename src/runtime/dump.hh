@@ -0,0 +1,233 @@
+#ifndef FSIM_DUMP_HH
+#define FSIM_DUMP_HH
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fsim::runtime {
+
+class Module;
+class TrackedVar;
+
+// a value change captured on the simulation side. values are copied into the payload as is and
+// only turned into text by the writer thread
+struct ValueChange {
+    static constexpr uint64_t payload_size = 48;
+
+    // global order of the change, since fibers can migrate between worker threads
+    uint64_t seq = 0;
+    uint64_t time = 0;
+    uint32_t id = 0;
+    alignas(16) std::array<std::byte, payload_size> payload = {};
+    // formatted value for types that can't be copied into the payload
+    std::string value;
+};
+
+template <typename T>
+constexpr bool fit_in_payload = std::is_trivially_copyable_v<T> &&
+                                sizeof(T) <= ValueChange::payload_size && alignof(T) <= 16;
+
+// single producer single consumer ring. every worker thread writes to its own ring, so capturing
+// a change never takes a lock
+class ChangeRing {
+public:
+    static constexpr uint64_t capacity = 1u << 14;
+
+    ChangeRing() : slots_(capacity) {}
+
+    // producer side. returns nullptr when the ring is full
+    ValueChange *try_acquire() {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == capacity) return nullptr;
+        return &slots_[head & (capacity - 1)];
+    }
+
+    void publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // consumer side
+    template <typename F>
+    void drain(F &&f) {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        auto head = head_.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            f(slots_[tail & (capacity - 1)]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+private:
+    std::vector<ValueChange> slots_;
+    alignas(64) std::atomic<uint64_t> head_ = 0;
+    alignas(64) std::atomic<uint64_t> tail_ = 0;
+};
+
+struct DumpVar {
+    // hierarchical scope, separated by .
+    std::string scope;
+    std::string name;
+    uint64_t width;
+};
+
+// waveform file format. values are binary strings with the most significant bit first, which may
+// contain x and z
+class WaveformWriter {
+public:
+    virtual ~WaveformWriter() = default;
+
+    virtual void write_header(const std::vector<DumpVar> &vars, uint64_t time,
+                              const std::vector<std::string> &values) = 0;
+    virtual void write_change(uint64_t time, uint32_t id, std::string_view value) = 0;
+    // called after all the changes in the time step are written
+    virtual void end_time_step(uint64_t time) { (void)time; }
+    virtual void write_dump_off(uint64_t time) = 0;
+    virtual void write_dump_on(uint64_t time, const std::vector<std::string> &values) = 0;
+    virtual void close() = 0;
+};
+
+// dumps value changes of registered variables into a waveform file. the simulation side only copies
+// the changed values into per-thread rings. a background thread orders the changes, formats them
+// and does the file IO, so waveform dumping doesn't stall the workers
+class Dumper {
+public:
+    explicit Dumper(const uint64_t *sim_time);
+    ~Dumper();
+
+    // $dumpfile. only takes effect before any variable is registered. files ending with .fwv use
+    // the compact format in wave.hh, everything else is VCD
+    void set_filename(std::string_view filename);
+
+    // $dumpvars. levels follows LRM 21.7.1.2, where 0 means every level below the scope. the
+    // scope name can be hierarchical, which is split into nested VCD scopes
+    void add_scope(Module *module, std::string_view scope_name, uint64_t levels);
+    // called by the generated Module::dump_vars
+    template <typename T>
+    void add_var(T &var, std::string_view name);
+    void add_instance(Module *module, std::string_view name, uint64_t levels);
+    // scope of an instance inlined into its parent, whose variables are added by the parent
+    void push_scope(std::string_view name);
+    void pop_scope();
+
+    // $dumpon and $dumpoff
+    void dump_on();
+    void dump_off();
+
+    template <typename T>
+    void capture(uint32_t id, const T &value) {
+        if (!enabled_.load(std::memory_order_relaxed)) return;
+        record(id, value);
+    }
+
+    // called by the scheduler when all the events in the time step are done. variables can't be
+    // registered after the first time step is dumped
+    void end_time_step(uint64_t time);
+    // flushes everything and stops the writer thread
+    void close(uint64_t time);
+
+private:
+    struct Var {
+        TrackedVar *var;
+        DumpVar info;
+        std::string (*format)(ValueChange &change);
+        void (*snapshot)(Dumper *dumper, TrackedVar *var, uint32_t id);
+    };
+
+    struct TimeStep {
+        uint64_t time;
+        bool enabled;
+    };
+
+    const uint64_t *sim_time_;
+    // used to look up the per-thread rings, since multiple schedulers can run in one process
+    uint64_t dumper_id_;
+    std::string filename_ = "dump.vcd";
+
+    // simulation side
+    std::mutex vars_lock_;
+    std::vector<Var> vars_;
+    std::vector<std::string> scope_stack_;
+    bool started_ = false;
+    std::atomic<bool> enabled_ = true;
+    // set once the writer thread is stopped
+    std::atomic<bool> closed_ = false;
+    std::atomic<uint64_t> seq_ = 0;
+
+    std::mutex rings_lock_;
+    std::vector<std::unique_ptr<ChangeRing>> rings_;
+
+    // shared with the writer thread
+    std::mutex lock_;
+    std::condition_variable cond_;
+    std::vector<TimeStep> steps_;
+    bool closing_ = false;
+    bool drain_requested_ = false;
+    std::thread writer_thread_;
+
+    // writer side
+    std::unique_ptr<WaveformWriter> waveform_;
+    std::vector<ValueChange> pending_;
+    std::vector<std::string> current_;
+    std::vector<std::string> emitted_;
+    std::vector<uint32_t> changed_;
+    bool header_written_ = false;
+    bool dumping_ = true;
+
+    template <typename T>
+    void record(uint32_t id, const T &value) {
+        auto *ring = local_ring();
+        auto *change = acquire(ring);
+        change->seq = seq_.fetch_add(1, std::memory_order_relaxed);
+        change->time = *sim_time_;
+        change->id = id;
+        if constexpr (fit_in_payload<T>) {
+            std::memcpy(change->payload.data(), &value, sizeof(T));
+        } else {
+            change->value = value.str("b");
+        }
+        ring->publish();
+    }
+
+    ChangeRing *local_ring();
+    ValueChange *acquire(ChangeRing *ring);
+    void register_var(Var var);
+    void start();
+
+    void write_loop();
+    void drain();
+    // returns the index of the first pending change after the time step
+    uint64_t write_step(const TimeStep &step, uint64_t first);
+};
+
+template <typename T>
+void Dumper::add_var(T &var, std::string_view name) {
+    using V = typename T::value_type;
+    Var v{&var,
+          {{}, std::string(name), T::size},
+          [](ValueChange &change) -> std::string {
+              if constexpr (fit_in_payload<V>) {
+                  V value;
+                  std::memcpy(&value, change.payload.data(), sizeof(V));
+                  return value.str("b");
+              } else {
+                  return std::move(change.value);
+              }
+          },
+          [](Dumper *dumper, TrackedVar *tracked, uint32_t id) {
+              dumper->record(id, static_cast<const V &>(*static_cast<T *>(tracked)));
+          }};
+    register_var(std::move(v));
+}
+
+}  // namespace fsim::runtime
+
+#endif  // FSIM_DUMP_HH
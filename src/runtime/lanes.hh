@@ -0,0 +1,321 @@
+#ifndef FSIM_LANES_HH
+#define FSIM_LANES_HH
+
+#include <array>
+#include <cstdint>
+
+// bit-sliced values used by lane-parallel simulation of 2-state designs. every bit of a signal is
+// a 64-bit word, in which bit i belongs to lane i. each lane is an independent simulation, so one
+// bitwise operation on the words advances all 64 simulations at once. control flow is turned into
+// per-lane masks and every write is predicated by the mask of the active lanes
+namespace fsim::runtime::lanes {
+
+constexpr uint64_t num_lanes = 64;
+// one bit per lane
+using Mask = uint64_t;
+constexpr Mask all_lanes = ~0ull;
+
+template <uint64_t width>
+struct Lanes {
+    // bits[i] holds bit i of every lane
+    std::array<uint64_t, width> bits = {};
+
+    // the same value in every lane
+    static constexpr Lanes constant(uint64_t value) {
+        Lanes result;
+        for (uint64_t i = 0; i < width; i++) {
+            result.bits[i] = (i < 64 && ((value >> i) & 1)) ? all_lanes : 0;
+        }
+        return result;
+    }
+
+    static constexpr Lanes ones() {
+        Lanes result;
+        result.bits.fill(all_lanes);
+        return result;
+    }
+
+    // used by testbenches to drive and observe individual lanes
+    [[nodiscard]] constexpr uint64_t get(uint64_t lane) const {
+        static_assert(width <= 64, "Use get_bit() for values wider than 64 bits");
+        uint64_t value = 0;
+        for (uint64_t i = 0; i < width; i++) {
+            value |= ((bits[i] >> lane) & 1) << i;
+        }
+        return value;
+    }
+
+    constexpr void set(uint64_t lane, uint64_t value) {
+        static_assert(width <= 64, "Use set_bit() for values wider than 64 bits");
+        for (uint64_t i = 0; i < width; i++) {
+            bits[i] = (bits[i] & ~(1ull << lane)) | (((value >> i) & 1) << lane);
+        }
+    }
+
+    [[nodiscard]] constexpr bool get_bit(uint64_t lane, uint64_t index) const {
+        return (bits[index] >> lane) & 1;
+    }
+
+    constexpr void set_bit(uint64_t lane, uint64_t index, bool value) {
+        bits[index] = (bits[index] & ~(1ull << lane)) | (static_cast<uint64_t>(value) << lane);
+    }
+
+    constexpr bool operator==(const Lanes &) const = default;
+};
+
+// predicated writes. they return whether any lane is changed
+template <uint64_t w>
+constexpr bool assign(Lanes<w> &target, Mask mask, const Lanes<w> &value) {
+    uint64_t diff = 0;
+    for (uint64_t i = 0; i < w; i++) {
+        auto v = (value.bits[i] & mask) | (target.bits[i] & ~mask);
+        diff |= v ^ target.bits[i];
+        target.bits[i] = v;
+    }
+    return diff != 0;
+}
+
+// writes to bits [offset, offset + w) of the target
+template <uint64_t offset, uint64_t w, uint64_t target_w>
+constexpr bool assign(Lanes<target_w> &target, Mask mask, const Lanes<w> &value) {
+    static_assert(offset + w <= target_w, "Slice out of range");
+    uint64_t diff = 0;
+    for (uint64_t i = 0; i < w; i++) {
+        auto &bit = target.bits[offset + i];
+        auto v = (value.bits[i] & mask) | (bit & ~mask);
+        diff |= v ^ bit;
+        bit = v;
+    }
+    return diff != 0;
+}
+
+template <uint64_t w>
+constexpr Mask mask(const Lanes<w> &value) {
+    static_assert(w == 1, "Only 1-bit value can be used as a mask");
+    return value.bits[0];
+}
+
+template <uint64_t w>
+constexpr Lanes<w> bit_and(const Lanes<w> &a, const Lanes<w> &b) {
+    Lanes<w> r;
+    for (uint64_t i = 0; i < w; i++) r.bits[i] = a.bits[i] & b.bits[i];
+    return r;
+}
+
+template <uint64_t w>
+constexpr Lanes<w> bit_or(const Lanes<w> &a, const Lanes<w> &b) {
+    Lanes<w> r;
+    for (uint64_t i = 0; i < w; i++) r.bits[i] = a.bits[i] | b.bits[i];
+    return r;
+}
+
+template <uint64_t w>
+constexpr Lanes<w> bit_xor(const Lanes<w> &a, const Lanes<w> &b) {
+    Lanes<w> r;
+    for (uint64_t i = 0; i < w; i++) r.bits[i] = a.bits[i] ^ b.bits[i];
+    return r;
+}
+
+template <uint64_t w>
+constexpr Lanes<w> bit_not(const Lanes<w> &a) {
+    Lanes<w> r;
+    for (uint64_t i = 0; i < w; i++) r.bits[i] = ~a.bits[i];
+    return r;
+}
+
+// ripple-carry adder. the carry is computed for all lanes at once
+template <uint64_t w>
+constexpr Lanes<w> add(const Lanes<w> &a, const Lanes<w> &b, uint64_t carry = 0) {
+    Lanes<w> r;
+    for (uint64_t i = 0; i < w; i++) {
+        auto x = a.bits[i] ^ b.bits[i];
+        r.bits[i] = x ^ carry;
+        carry = (a.bits[i] & b.bits[i]) | (x & carry);
+    }
+    return r;
+}
+
+template <uint64_t w>
+constexpr Lanes<w> sub(const Lanes<w> &a, const Lanes<w> &b) {
+    // a - b = a + ~b + 1
+    return add(a, bit_not(b), all_lanes);
+}
+
+template <uint64_t w>
+constexpr Lanes<w> neg(const Lanes<w> &a) {
+    return sub(Lanes<w>{}, a);
+}
+
+// shift-and-add multiplier
+template <uint64_t w>
+constexpr Lanes<w> mul(const Lanes<w> &a, const Lanes<w> &b) {
+    Lanes<w> r;
+    for (uint64_t i = 0; i < w; i++) {
+        // partial product a << i, only in lanes where bit i of b is set
+        Lanes<w> partial;
+        for (uint64_t j = i; j < w; j++) partial.bits[j] = a.bits[j - i] & b.bits[i];
+        r = add(r, partial);
+    }
+    return r;
+}
+
+constexpr Lanes<1> from_mask(Mask mask) {
+    Lanes<1> r;
+    r.bits[0] = mask;
+    return r;
+}
+
+template <uint64_t w>
+constexpr Lanes<1> r_or(const Lanes<w> &a) {
+    uint64_t r = 0;
+    for (uint64_t i = 0; i < w; i++) r |= a.bits[i];
+    return from_mask(r);
+}
+
+template <uint64_t w>
+constexpr Lanes<1> r_and(const Lanes<w> &a) {
+    uint64_t r = all_lanes;
+    for (uint64_t i = 0; i < w; i++) r &= a.bits[i];
+    return from_mask(r);
+}
+
+template <uint64_t w>
+constexpr Lanes<1> r_xor(const Lanes<w> &a) {
+    uint64_t r = 0;
+    for (uint64_t i = 0; i < w; i++) r ^= a.bits[i];
+    return from_mask(r);
+}
+
+template <uint64_t w>
+constexpr Lanes<1> is_true(const Lanes<w> &a) {
+    return r_or(a);
+}
+
+template <uint64_t w>
+constexpr Lanes<1> eq(const Lanes<w> &a, const Lanes<w> &b) {
+    return bit_not(r_or(bit_xor(a, b)));
+}
+
+// unsigned less than, which is the borrow out of a - b
+template <uint64_t w>
+constexpr Lanes<1> lt(const Lanes<w> &a, const Lanes<w> &b) {
+    uint64_t borrow = 0;
+    for (uint64_t i = 0; i < w; i++) {
+        borrow = (~a.bits[i] & b.bits[i]) | (~(a.bits[i] ^ b.bits[i]) & borrow);
+    }
+    return from_mask(borrow);
+}
+
+template <uint64_t w>
+constexpr Lanes<1> slt(Lanes<w> a, Lanes<w> b) {
+    // flipping the sign bits turns it into an unsigned comparison
+    a.bits[w - 1] = ~a.bits[w - 1];
+    b.bits[w - 1] = ~b.bits[w - 1];
+    return lt(a, b);
+}
+
+template <uint64_t w>
+constexpr Lanes<w> mux(const Lanes<1> &cond, const Lanes<w> &a, const Lanes<w> &b) {
+    Lanes<w> r;
+    auto c = cond.bits[0];
+    for (uint64_t i = 0; i < w; i++) r.bits[i] = (a.bits[i] & c) | (b.bits[i] & ~c);
+    return r;
+}
+
+// barrel shifters. each bit of the amount conditionally shifts every lane by a power of two.
+// fill holds the bit shifted in from the left in each lane, which is the sign bit for ashr
+template <uint64_t w, uint64_t amount_w>
+constexpr Lanes<w> shift(const Lanes<w> &a, const Lanes<amount_w> &amount, bool left,
+                         uint64_t fill) {
+    auto r = a;
+    for (uint64_t k = 0; k < amount_w; k++) {
+        auto select = amount.bits[k];
+        if (!select) continue;
+        auto distance = k < 64 ? (1ull << k) : w;
+        Lanes<w> shifted;
+        for (uint64_t i = 0; i < w; i++) {
+            if (left) {
+                shifted.bits[i] = i >= distance ? r.bits[i - distance] : 0;
+            } else {
+                shifted.bits[i] = distance < w - i ? r.bits[i + distance] : fill;
+            }
+        }
+        for (uint64_t i = 0; i < w; i++) {
+            r.bits[i] = (shifted.bits[i] & select) | (r.bits[i] & ~select);
+        }
+    }
+    return r;
+}
+
+template <uint64_t w, uint64_t amount_w>
+constexpr Lanes<w> shl(const Lanes<w> &a, const Lanes<amount_w> &amount) {
+    return shift(a, amount, true, 0);
+}
+
+template <uint64_t w, uint64_t amount_w>
+constexpr Lanes<w> shr(const Lanes<w> &a, const Lanes<amount_w> &amount) {
+    return shift(a, amount, false, 0);
+}
+
+template <uint64_t w, uint64_t amount_w>
+constexpr Lanes<w> ashr(const Lanes<w> &a, const Lanes<amount_w> &amount) {
+    return shift(a, amount, false, a.bits[w - 1]);
+}
+
+// truncates or extends to the new width
+template <uint64_t new_w, uint64_t w>
+constexpr Lanes<new_w> extend(const Lanes<w> &a, bool is_signed) {
+    Lanes<new_w> r;
+    auto fill = is_signed ? a.bits[w - 1] : 0;
+    for (uint64_t i = 0; i < new_w; i++) r.bits[i] = i < w ? a.bits[i] : fill;
+    return r;
+}
+
+template <uint64_t offset, uint64_t new_w, uint64_t w>
+constexpr Lanes<new_w> slice(const Lanes<w> &a) {
+    static_assert(offset + new_w <= w, "Slice out of range");
+    Lanes<new_w> r;
+    for (uint64_t i = 0; i < new_w; i++) r.bits[i] = a.bits[offset + i];
+    return r;
+}
+
+// bit select with a different index in each lane. indices out of range read 0
+template <int64_t lower, uint64_t w, uint64_t index_w>
+constexpr Lanes<1> select(const Lanes<w> &a, const Lanes<index_w> &index) {
+    // largest index that index_w bits can hold. positions beyond it can't be selected, and
+    // comparing against their truncated value would alias them to lower positions
+    constexpr uint64_t max_index = index_w >= 64 ? ~0ull : (1ull << (index_w % 64)) - 1;
+    uint64_t r = 0;
+    for (uint64_t i = 0; i < w; i++) {
+        auto value = static_cast<int64_t>(i) + lower;
+        if (value < 0 || static_cast<uint64_t>(value) > max_index) continue;
+        r |= mask(eq(index, Lanes<index_w>::constant(static_cast<uint64_t>(value)))) & a.bits[i];
+    }
+    return from_mask(r);
+}
+
+template <uint64_t n, uint64_t w>
+constexpr Lanes<n * w> replicate(const Lanes<w> &a) {
+    Lanes<n * w> r;
+    for (uint64_t i = 0; i < n * w; i++) r.bits[i] = a.bits[i % w];
+    return r;
+}
+
+// the first value is the most significant one, same as SystemVerilog
+template <uint64_t w, uint64_t... ws>
+constexpr auto concat(const Lanes<w> &a, const Lanes<ws> &...rest) {
+    if constexpr (sizeof...(ws) == 0) {
+        return a;
+    } else {
+        auto low = concat(rest...);
+        constexpr auto low_w = (ws + ...);
+        Lanes<w + low_w> r;
+        for (uint64_t i = 0; i < low_w; i++) r.bits[i] = low.bits[i];
+        for (uint64_t i = 0; i < w; i++) r.bits[low_w + i] = a.bits[i];
+        return r;
+    }
+}
+
+}  // namespace fsim::runtime::lanes
+
+#endif  // FSIM_LANES_HH
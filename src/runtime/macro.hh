@@ -17,12 +17,27 @@
         if (scheduler->finished()) return;                                               \
     } while (0)
 
-#define END_PROCESS(process)             \
-    do {                                 \
-        process->cond.signal();          \
-        process->finished = true;        \
-        process->running = false;        \
-        process->should_trigger = false; \
+// delay at the top level of a process body. point is the label the process jumps to when it is
+// restored from a checkpoint
+#define SCHEDULE_RESUMABLE_DELAY(process, pound_time, scheduler, next_time, point)      \
+    do {                                                                                \
+        auto next_time = fsim::runtime::ScheduledTimeslot(                              \
+            process->restored ? process->event_time : scheduler->sim_time + pound_time, \
+            process);                                                                   \
+        process->restored = false;                                                      \
+        process->resume_point = point;                                                  \
+        scheduler->schedule_delay(next_time);                                           \
+        SUSPEND_PROCESS(process);                                                       \
+        process->resume_point = 0;                                                      \
+        if (scheduler->finished()) return;                                              \
+    } while (0)
+
+#define END_PROCESS(process)                                             \
+    do {                                                                 \
+        process->cond.signal();                                          \
+        process->finished = true;                                        \
+        process->running = false;                                        \
+        process->should_trigger.store(false, std::memory_order_relaxed); \
     } while (0)
 
 #define END_FORK_PROCESS(process) \
@@ -32,12 +47,22 @@
         process->running = false; \
     } while (0)
 
-#define SCHEDULE_NBA(target, value, process)                          \
-    do {                                                              \
-        if (!target.match(value)) {                                   \
-            auto wire = value;                                        \
-            process->schedule_nba([this, wire]() { target = wire; }); \
-        }                                                             \
+#define SCHEDULE_NBA(target, value, process)     \
+    do {                                         \
+        if (!target.match(value)) {              \
+            auto wire = value;                   \
+            process->schedule_nba(target, wire); \
+        }                                        \
+    } while (0)
+
+// var_ptr is the variable that target selects from. NBAs are grouped by it during commit. nullptr
+// forces a serial commit
+#define SCHEDULE_NBA_VAR(target, var_ptr, value, process)                      \
+    do {                                                                       \
+        if (!target.match(value)) {                                            \
+            auto wire = value;                                                 \
+            process->schedule_nba(var_ptr, [this, wire]() { target = wire; }); \
+        }                                                                      \
     } while (0)
 
 #define SCHEDULE_EDGE(process, variable, edge_type) \
@@ -1,5 +1,9 @@
 #include "module.hh"
 
+#include <iostream>
+
+#include "checkpoint.hh"
+#include "dump.hh"
 #include "fmt/format.h"
 #include "marl/waitgroup.h"
 #include "scheduler.hh"
@@ -20,8 +24,15 @@ inline void start_process(Process *process) {
     process->running = true;
 }
 
+inline void end_levelized_process(Process *process) {
+    // same as END_PROCESS without signaling the condition variable
+    process->finished = true;
+    process->running = false;
+    process->should_trigger.store(false, std::memory_order_relaxed);
+}
+
 inline bool should_trigger_process(Process *process) {
-    return process->should_trigger && process->finished;
+    return process->should_trigger.load(std::memory_order_relaxed) && process->finished;
 }
 
 // NOLINTNEXTLINE
@@ -52,6 +63,20 @@ void Module::final(Scheduler *scheduler) {
     }
 }
 
+void Module::dump_vars(Dumper *dumper, uint64_t levels) {  // NOLINT
+    // generated modules override this with their own variables and named child instances
+    for (auto *inst : child_instances_) {
+        dumper->add_instance(inst, inst->inst_name, levels);
+    }
+}
+
+void Module::checkpoint_vars(Checkpoint *checkpoint) {  // NOLINT
+    // generated modules override this with their own variables and all child instances
+    for (auto *inst : child_instances_) {
+        inst->checkpoint_vars(checkpoint);
+    }
+}
+
 std::string Module::hierarchy_name() const {
     std::string result = std::string(inst_name);
     auto const *module = this->parent;
@@ -63,71 +88,158 @@ std::string Module::hierarchy_name() const {
     return result;
 }
 
+void Module::set_output(std::ostream *output) {  // NOLINT
+    output_ = output;
+    for (auto *inst : child_instances_) {
+        inst->set_output(output);
+    }
+}
+
+std::ostream &Module::output() const { return output_ ? *output_ : std::cout; }
+
+inline void run_process(CombProcess *process) {
+    if (process->levelized) {
+        // no need to switch to a fiber since it never suspends
+        process->func();
+        end_levelized_process(process);
+    } else {
+        start_process(process);
+        marl::schedule([process]() { process->func(); });
+        wait_process_switch(process);
+    }
+}
+
 class CombinationalGraph {
 public:
     explicit CombinationalGraph(const std::vector<CombProcess *> &comb_processes)
-        : comb_processes_(comb_processes) {}
+        : comb_processes_(comb_processes) {
+        for (auto *p : comb_processes) {
+            if (p->level < 0) {
+                serial_processes_.emplace_back(p);
+            } else {
+                auto level = static_cast<uint64_t>(p->level);
+                if (levels_.size() <= level) levels_.resize(level + 1);
+                levels_[level].emplace_back(p);
+            }
+        }
+    }
 
-    void run() {
-        for (auto *p : comb_processes_) {
-            // if it's not finished, it means it's waiting
-            if (should_trigger_process(p)) {
-                start_process(p);
-                marl::schedule([p]() { p->func(); });
-                wait_process_switch(p);
+    void run(Scheduler *scheduler, bool drain_dirty) {
+        // changes from the previous level have to be seen by the next one
+        auto &signals = scheduler->signals();
+        if (drain_dirty) signals.propagate_dirty();
+        if (levels_.empty()) {
+            run_serial(comb_processes_);
+            return;
+        }
+
+        for (auto const &level : levels_) {
+            if (level.size() == 1) {
+                run_serial(level);
+            } else {
+                run_parallel(level);
             }
+            if (drain_dirty) signals.propagate_dirty();
         }
+        run_serial(serial_processes_);
     }
 
 private:
     const std::vector<CombProcess *> &comb_processes_;
+    // partitioned by levels
+    std::vector<std::vector<CombProcess *>> levels_;
+    std::vector<CombProcess *> serial_processes_;
+    std::vector<CombProcess *> suspended_processes_;
+
+    static void run_serial(const std::vector<CombProcess *> &processes) {
+        for (auto *p : processes) {
+            // if it's not finished, it means it's waiting
+            if (should_trigger_process(p)) {
+                run_process(p);
+            }
+        }
+    }
+
+    void run_parallel(const std::vector<CombProcess *> &processes) {
+        // processes in the same level don't depend on each other. the wait group works as the
+        // barrier before moving on to the next level
+        marl::WaitGroup level_control;
+        for (auto *p : processes) {
+            if (!should_trigger_process(p)) continue;
+            start_process(p);
+            if (p->levelized) {
+                level_control.add();
+                marl::schedule([p, level_control]() {
+                    p->func();
+                    end_levelized_process(p);
+                    level_control.done();
+                });
+            } else {
+                suspended_processes_.emplace_back(p);
+                marl::schedule([p]() { p->func(); });
+            }
+        }
+        level_control.wait();
+
+        for (auto *p : suspended_processes_) {
+            wait_process_switch(p);
+        }
+        suspended_processes_.clear();
+    }
 };
 
-void Module::active() {  // NOLINT
+void Module::active(Scheduler *scheduler) { active(scheduler, true); }
+
+void Module::active(Scheduler *scheduler, bool drain_dirty) {  // NOLINT
+    // comb processes start out finished. processes restored from a checkpoint may already be
+    // running at this point
     if (!comb_graph_) {
         comb_graph_ = std::make_shared<CombinationalGraph>(comb_processes_);
-        // every process is finished by default
-        for (auto *p : comb_processes_) {
-            p->finished = true;
-        }
     }
 
-    bool changed;
-    do {
-        // try to finish what's still there
-        wait_for_timed_processes();
+    // try to finish what's still there
+    wait_for_timed_processes();
 
-        changed = false;
-        while (!sensitivity_stable()) {
-            comb_graph_->run();
+    // FF processes are scheduled by the scheduler, which may trigger combinational logic in
+    // any instance. hence child instances are visited at least once
+    do {
+        comb_graph_->run(scheduler, drain_dirty);
+        if (parallel_instances_ && child_instances_.size() > 1) {
+            // children only evaluate what has been triggered so far. whatever they trigger is
+            // drained by sensitivity_stable() after all of them are done
+            if (drain_dirty) scheduler->signals().propagate_dirty();
+            marl::WaitGroup instance_control(child_instances_.size());
             for (auto *inst : child_instances_) {
-                inst->active();
+                marl::schedule([inst, scheduler, instance_control]() {
+                    inst->active(scheduler, false);
+                    instance_control.done();
+                });
+            }
+            instance_control.wait();
+        } else {
+            for (auto *inst : child_instances_) {
+                inst->active(scheduler, drain_dirty);
             }
-            changed = true;
-            wait_for_timed_processes();
-        }
-
-        while (!edge_stable()) {
-            // try to finish what's still there
-            schedule_ff();
-            changed = true;
-
-            wait_for_timed_processes();
         }
-    } while (changed);
+        wait_for_timed_processes();
+    } while (!sensitivity_stable(scheduler, drain_dirty));
 }
 
-bool Module::sensitivity_stable() {
-    if (comb_processes_.empty()) return true;
-    auto r = std::all_of(comb_processes_.begin(), comb_processes_.end(), [](auto *p) {
-        return !p->should_trigger || (!p->running && !p->finished);
-    });
-    return r;
+bool Module::sensitivity_stable(Scheduler *scheduler, bool drain_dirty) {
+    if (!drain_dirty) return !comb_triggered(false);
+    // writes since the last evaluation may trigger more processes
+    scheduler->signals().propagate_dirty();
+    // including the ones in child instances that ran in parallel, since they didn't drain
+    return !comb_triggered(parallel_instances_ && child_instances_.size() > 1);
 }
 
-bool Module::edge_stable() {
-    return std::all_of(ff_process_.begin(), ff_process_.end(),
-                       [](auto *p) { return !p->should_trigger || (!p->running && !p->finished); });
+bool Module::comb_triggered(bool recursive) const {  // NOLINT
+    auto r = std::any_of(comb_processes_.begin(), comb_processes_.end(), [](auto *p) {
+        return p->should_trigger.load(std::memory_order_relaxed) && (p->running || p->finished);
+    });
+    if (r || !recursive) return r;
+    return std::any_of(child_instances_.begin(), child_instances_.end(),
+                       [](auto *i) { return i->comb_triggered(true); });
 }
 
 bool Module::stabilized() const {  // NOLINT
@@ -168,34 +280,4 @@ void Module::wait_for_timed_processes() {
     }
 }
 
-void Module::schedule_ff() {  // NOLINT
-    if (ff_process_.empty()) return;
-
-    // this is just to make sure we call each functions
-    // 1. first pass to compute the number of process to trigger
-    std::vector<FFProcess *> processes;
-    processes.reserve(ff_process_.size());
-    for (auto *p : ff_process_) {
-        if (should_trigger_process(p)) {
-            processes.emplace_back(p);
-        }
-    }
-
-    // 2. actually trigger the function if necessary
-    if (!processes.empty()) {
-        marl::WaitGroup trigger_control(processes.size());
-
-        for (auto *p : processes) {
-            start_process(p);
-            marl::schedule([p, trigger_control]() {
-                trigger_control.done();
-                // non-blocking. we only use the wait group to make sure that the function
-                // actually gets scheduled before we return the call
-                p->func();
-            });
-        }
-        trigger_control.wait();
-    }
-}
-
 }  // namespace fsim::runtime
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <mutex>
+#include <ostream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -14,6 +15,8 @@ struct FFProcess;
 struct InitialProcess;
 struct ForkProcess;
 class CombinationalGraph;
+class Dumper;
+class Checkpoint;
 
 class Module {
 public:
@@ -25,6 +28,11 @@ public:
     virtual void comb(Scheduler *scheduler);
     virtual void ff(Scheduler *scheduler);
     virtual void final(Scheduler *scheduler);
+    // registers variables for $dumpvars. levels follows LRM 21.7.1.2
+    virtual void dump_vars(Dumper *dumper, uint64_t levels);
+    // registers every variable of the instance and its child instances for checkpointing
+    virtual void checkpoint_vars(Checkpoint *checkpoint);
+    virtual ~Module() = default;
 
     std::string_view def_name;
     std::string_view inst_name;
@@ -34,13 +42,18 @@ public:
     [[nodiscard]] std::string hierarchy_name() const;
 
     // active region
-    void active();
+    void active(Scheduler *scheduler);
     [[nodiscard]] bool stabilized() const;
 
     // cout locks
     static void cout_lock() { cout_lock_.lock(); }
     static void cout_unlock() { cout_lock_.unlock(); }
 
+    // stream used by $display and $write. it is stdout unless set, which also applies to all the
+    // child instances
+    void set_output(std::ostream *output);
+    [[nodiscard]] std::ostream &output() const;
+
 protected:
     std::vector<CombProcess *> comb_processes_;
     std::vector<FFProcess *> ff_process_;
@@ -49,16 +62,22 @@ protected:
 
     // child instances
     std::vector<Module *> child_instances_;
+    // child instances only talk to each other through port connections in this module, so
+    // their active regions can run in parallel
+    bool parallel_instances_ = false;
 
 private:
     std::shared_ptr<CombinationalGraph> comb_graph_;
-    bool sensitivity_stable();
-    bool edge_stable();
+    // draining the dirty bits triggers processes in any instance, so instances that run in
+    // parallel with their siblings leave it to the thread that owns the delta cycle
+    void active(Scheduler *scheduler, bool drain_dirty);
+    bool sensitivity_stable(Scheduler *scheduler, bool drain_dirty);
+    [[nodiscard]] bool comb_triggered(bool recursive) const;
 
     void wait_for_timed_processes();
-    void schedule_ff();
 
     static std::mutex cout_lock_;
+    std::ostream *output_ = nullptr;
 };
 }  // namespace fsim::runtime
 
@@ -0,0 +1,391 @@
+#ifndef FSIM_NATIVE_HH
+#define FSIM_NATIVE_HH
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "logic/logic.hh"
+
+// used by 2-state simulation to evaluate expressions with native integer operations. values that
+// fit into 64 bits are zero-extended to uint64_t. wider values are stored as word arrays and
+// computed by the kernels below, which use AVX2/AVX-512 when the simulator is compiled with them
+namespace fsim::runtime::native {
+
+constexpr uint64_t mask(uint64_t width) { return width >= 64 ? ~0ull : (1ull << width) - 1; }
+
+constexpr uint64_t trunc(uint64_t value, uint64_t width) { return value & mask(width); }
+
+constexpr int64_t sext(uint64_t value, uint64_t width) {
+    auto shift = 64 - width;
+    return static_cast<int64_t>(value << shift) >> shift;
+}
+
+constexpr uint64_t shl(uint64_t value, uint64_t amount, uint64_t width) {
+    return amount >= width ? 0 : trunc(value << amount, width);
+}
+
+constexpr uint64_t shr(uint64_t value, uint64_t amount) { return amount >= 64 ? 0 : value >> amount; }
+
+constexpr uint64_t ashr(uint64_t value, uint64_t amount, uint64_t width) {
+    auto v = sext(value, width) >> (amount >= 64 ? 63 : amount);
+    return trunc(static_cast<uint64_t>(v), width);
+}
+
+constexpr uint64_t r_xor(uint64_t value) { return std::popcount(value) & 1; }
+
+constexpr bool is_true(uint64_t value) { return value != 0; }
+
+// get the value out of logic/bit types
+template <typename T>
+constexpr uint64_t value(const T &v, uint64_t width) {
+    if constexpr (std::is_integral_v<T>) {
+        return trunc(static_cast<uint64_t>(v), width);
+    } else {
+        return trunc(v.to_uint64(), width);
+    }
+}
+
+// little-endian words. unused bits in the top word are always zero
+template <uint64_t width>
+struct Wide {
+    static constexpr uint64_t num_words = (width + 63) / 64;
+    static constexpr uint64_t top_mask = mask(width - (num_words - 1) * 64);
+
+    std::array<uint64_t, num_words> words = {};
+
+    void normalize() { words[num_words - 1] &= top_mask; }
+};
+
+namespace kernel {
+enum class BitwiseOp { And, Or, Xor };
+
+template <BitwiseOp op>
+inline void bitwise(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t n) {
+    uint64_t i = 0;
+#if defined(__AVX512F__)
+    for (; i + 8 <= n; i += 8) {
+        auto va = _mm512_loadu_si512(a + i);
+        auto vb = _mm512_loadu_si512(b + i);
+        __m512i vr;
+        if constexpr (op == BitwiseOp::And) {
+            vr = _mm512_and_si512(va, vb);
+        } else if constexpr (op == BitwiseOp::Or) {
+            vr = _mm512_or_si512(va, vb);
+        } else {
+            vr = _mm512_xor_si512(va, vb);
+        }
+        _mm512_storeu_si512(r + i, vr);
+    }
+#endif
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i vr;
+        if constexpr (op == BitwiseOp::And) {
+            vr = _mm256_and_si256(va, vb);
+        } else if constexpr (op == BitwiseOp::Or) {
+            vr = _mm256_or_si256(va, vb);
+        } else {
+            vr = _mm256_xor_si256(va, vb);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), vr);
+    }
+#endif
+    for (; i < n; i++) {
+        if constexpr (op == BitwiseOp::And) {
+            r[i] = a[i] & b[i];
+        } else if constexpr (op == BitwiseOp::Or) {
+            r[i] = a[i] | b[i];
+        } else {
+            r[i] = a[i] ^ b[i];
+        }
+    }
+}
+
+inline void bitwise_not(uint64_t *r, const uint64_t *a, uint64_t n) {
+    uint64_t i = 0;
+#if defined(__AVX512F__)
+    auto ones512 = _mm512_set1_epi64(-1);
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_si512(r + i, _mm512_xor_si512(_mm512_loadu_si512(a + i), ones512));
+    }
+#endif
+#if defined(__AVX2__)
+    auto ones256 = _mm256_set1_epi64x(-1);
+    for (; i + 4 <= n; i += 4) {
+        auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), _mm256_xor_si256(va, ones256));
+    }
+#endif
+    for (; i < n; i++) {
+        r[i] = ~a[i];
+    }
+}
+
+inline bool equal(const uint64_t *a, const uint64_t *b, uint64_t n) {
+    uint64_t i = 0;
+#if defined(__AVX512F__)
+    for (; i + 8 <= n; i += 8) {
+        auto va = _mm512_loadu_si512(a + i);
+        auto vb = _mm512_loadu_si512(b + i);
+        if (_mm512_cmpneq_epi64_mask(va, vb)) return false;
+    }
+#endif
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(va, vb)) != -1) return false;
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+inline bool any(const uint64_t *a, uint64_t n) {
+    uint64_t i = 0;
+#if defined(__AVX512F__)
+    for (; i + 8 <= n; i += 8) {
+        auto va = _mm512_loadu_si512(a + i);
+        if (_mm512_test_epi64_mask(va, va)) return true;
+    }
+#endif
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        if (!_mm256_testz_si256(va, va)) return true;
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i]) return true;
+    }
+    return false;
+}
+
+inline uint64_t parity(const uint64_t *a, uint64_t n) {
+    uint64_t r = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        r ^= a[i];
+    }
+    return std::popcount(r) & 1;
+}
+
+// returns the carry out
+inline uint64_t add(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t n,
+                    uint64_t carry = 0) {
+    for (uint64_t i = 0; i < n; i++) {
+        auto sum = a[i] + carry;
+        carry = sum < carry;
+        r[i] = sum + b[i];
+        carry += r[i] < sum;
+    }
+    return carry;
+}
+
+inline void sub(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t n) {
+    // a - b = a + ~b + 1
+    uint64_t borrow = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        auto diff = a[i] - b[i];
+        auto next_borrow = (a[i] < b[i]) | (diff < borrow);
+        r[i] = diff - borrow;
+        borrow = next_borrow;
+    }
+}
+
+inline void shl(uint64_t *r, const uint64_t *a, uint64_t n, uint64_t amount) {
+    auto word_shift = amount / 64;
+    auto bit_shift = amount % 64;
+    for (uint64_t i = n; i-- > 0;) {
+        uint64_t v = 0;
+        if (i >= word_shift) {
+            v = a[i - word_shift] << bit_shift;
+            if (bit_shift && i > word_shift) v |= a[i - word_shift - 1] >> (64 - bit_shift);
+        }
+        r[i] = v;
+    }
+}
+
+inline void shr(uint64_t *r, const uint64_t *a, uint64_t n, uint64_t amount) {
+    auto word_shift = amount / 64;
+    auto bit_shift = amount % 64;
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t v = 0;
+        if (i + word_shift < n) {
+            v = a[i + word_shift] >> bit_shift;
+            if (bit_shift && i + word_shift + 1 < n) v |= a[i + word_shift + 1] << (64 - bit_shift);
+        }
+        r[i] = v;
+    }
+}
+}  // namespace kernel
+
+template <uint64_t w>
+Wide<w> bit_and(const Wide<w> &a, const Wide<w> &b) {
+    Wide<w> r;
+    kernel::bitwise<kernel::BitwiseOp::And>(r.words.data(), a.words.data(), b.words.data(),
+                                            Wide<w>::num_words);
+    return r;
+}
+
+template <uint64_t w>
+Wide<w> bit_or(const Wide<w> &a, const Wide<w> &b) {
+    Wide<w> r;
+    kernel::bitwise<kernel::BitwiseOp::Or>(r.words.data(), a.words.data(), b.words.data(),
+                                           Wide<w>::num_words);
+    return r;
+}
+
+template <uint64_t w>
+Wide<w> bit_xor(const Wide<w> &a, const Wide<w> &b) {
+    Wide<w> r;
+    kernel::bitwise<kernel::BitwiseOp::Xor>(r.words.data(), a.words.data(), b.words.data(),
+                                            Wide<w>::num_words);
+    return r;
+}
+
+template <uint64_t w>
+Wide<w> bit_not(const Wide<w> &a) {
+    Wide<w> r;
+    kernel::bitwise_not(r.words.data(), a.words.data(), Wide<w>::num_words);
+    r.normalize();
+    return r;
+}
+
+template <uint64_t w>
+Wide<w> add(const Wide<w> &a, const Wide<w> &b) {
+    Wide<w> r;
+    kernel::add(r.words.data(), a.words.data(), b.words.data(), Wide<w>::num_words);
+    r.normalize();
+    return r;
+}
+
+template <uint64_t w>
+Wide<w> sub(const Wide<w> &a, const Wide<w> &b) {
+    Wide<w> r;
+    kernel::sub(r.words.data(), a.words.data(), b.words.data(), Wide<w>::num_words);
+    r.normalize();
+    return r;
+}
+
+template <uint64_t w>
+Wide<w> shl(const Wide<w> &a, uint64_t amount) {
+    Wide<w> r;
+    if (amount < w) {
+        kernel::shl(r.words.data(), a.words.data(), Wide<w>::num_words, amount);
+        r.normalize();
+    }
+    return r;
+}
+
+template <uint64_t w>
+Wide<w> shr(const Wide<w> &a, uint64_t amount) {
+    Wide<w> r;
+    if (amount < w) {
+        kernel::shr(r.words.data(), a.words.data(), Wide<w>::num_words, amount);
+    }
+    return r;
+}
+
+template <uint64_t w>
+uint64_t eq(const Wide<w> &a, const Wide<w> &b) {
+    return kernel::equal(a.words.data(), b.words.data(), Wide<w>::num_words);
+}
+
+template <uint64_t w>
+bool is_true(const Wide<w> &a) {
+    return kernel::any(a.words.data(), Wide<w>::num_words);
+}
+
+template <uint64_t w>
+uint64_t r_and(const Wide<w> &a) {
+    auto const &words = a.words;
+    auto all_ones = std::all_of(words.begin(), words.end() - 1, [](auto v) { return v == ~0ull; });
+    return all_ones && words.back() == Wide<w>::top_mask;
+}
+
+template <uint64_t w>
+uint64_t r_xor(const Wide<w> &a) {
+    return kernel::parity(a.words.data(), Wide<w>::num_words);
+}
+
+// conversions between different widths
+template <uint64_t w>
+Wide<w> extend(uint64_t value, uint64_t width, bool is_signed) {
+    Wide<w> r;
+    auto negative = is_signed && ((value >> (width - 1)) & 1);
+    r.words[0] = negative ? static_cast<uint64_t>(sext(value, width)) : value;
+    for (uint64_t i = 1; i < Wide<w>::num_words; i++) {
+        r.words[i] = negative ? ~0ull : 0;
+    }
+    r.normalize();
+    return r;
+}
+
+template <uint64_t w, uint64_t op_w>
+Wide<w> extend(const Wide<op_w> &value, bool is_signed) {
+    Wide<w> r;
+    auto negative = is_signed && ((value.words[(op_w - 1) / 64] >> ((op_w - 1) % 64)) & 1);
+    auto n = std::min(Wide<w>::num_words, Wide<op_w>::num_words);
+    std::copy(value.words.begin(), value.words.begin() + n, r.words.begin());
+    if (negative && op_w < w) {
+        // fill the bits above the sign bit
+        auto top = Wide<op_w>::num_words - 1;
+        r.words[top] |= ~Wide<op_w>::top_mask;
+        for (auto i = top + 1; i < Wide<w>::num_words; i++) {
+            r.words[i] = ~0ull;
+        }
+    }
+    r.normalize();
+    return r;
+}
+
+template <uint64_t op_w>
+uint64_t trunc(const Wide<op_w> &value, uint64_t width) {
+    return trunc(value.words[0], width);
+}
+
+// conversion from/to logic/bit types
+template <uint64_t w, typename T>
+Wide<w> wide_value(const T &v) {
+    Wide<w> r;
+    [&]<std::size_t... i>(std::index_sequence<i...>) {
+        ((r.words[i] = v.template slice<std::min<uint64_t>(i * 64 + 63, w - 1), i * 64>()
+                           .to_uint64()),
+         ...);
+    }
+    (std::make_index_sequence<Wide<w>::num_words>());
+    r.normalize();
+    return r;
+}
+
+template <uint64_t w, uint64_t i>
+auto word_bit(const Wide<w> &v) {
+    constexpr auto word_width = std::min<uint64_t>(w - i * 64, 64);
+    return logic::bit<word_width - 1, 0>(v.words[i]);
+}
+
+template <uint64_t w>
+auto to_bit(const Wide<w> &v) {
+    constexpr auto n = Wide<w>::num_words;
+    return [&]<std::size_t... i>(std::index_sequence<i...>) {
+        // most significant word goes first
+        return logic::concat(word_bit<w, n - 1 - i>(v)...);
+    }
+    (std::make_index_sequence<n>());
+}
+
+}  // namespace fsim::runtime::native
+
+#endif  // FSIM_NATIVE_HH
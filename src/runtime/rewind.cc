@@ -0,0 +1,92 @@
+#include "rewind.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "batch.hh"
+#include "fmt/format.h"
+#include "fork.hh"
+
+namespace fsim::runtime {
+
+constexpr std::string_view fork_at_arg = "+fsim_fork_at=";
+constexpr std::string_view fork_args_arg = "+fsim_fork_args=";
+constexpr std::string_view fork_log_arg = "+fsim_fork_log=";
+constexpr std::string_view fork_jobs_arg = "+fsim_fork_jobs=";
+
+Rewind::Rewind(const std::vector<std::string> &args)
+    : max_jobs_(std::max(std::thread::hardware_concurrency(), 1u)) {
+    for (auto const &arg : args) {
+        if (arg.starts_with(fork_at_arg)) {
+            branch_time_ = std::stoull(arg.substr(fork_at_arg.size()));
+        } else if (arg.starts_with(fork_args_arg)) {
+            continuation_args_ = read_instance_args(arg.substr(fork_args_arg.size()));
+        } else if (arg.starts_with(fork_log_arg)) {
+            log_prefix_ = arg.substr(fork_log_arg.size());
+        } else if (arg.starts_with(fork_jobs_arg)) {
+            max_jobs_ = std::max<uint64_t>(std::stoull(arg.substr(fork_jobs_arg.size())), 1);
+        } else {
+            common_args_.emplace_back(arg);
+        }
+    }
+}
+
+uint64_t Rewind::num_continuations() const {
+    return std::max<uint64_t>(continuation_args_.size(), 1);
+}
+
+std::vector<std::string> Rewind::continuation_args(uint64_t index) const {
+    auto result = common_args_;
+    if (index < continuation_args_.size()) {
+        auto const &args = continuation_args_[index];
+        result.insert(result.end(), args.begin(), args.end());
+    }
+    return result;
+}
+
+std::string Rewind::log_filename(uint64_t index) const {
+    return fmt::format("{0}.{1}.log", log_prefix_, index);
+}
+
+std::optional<uint64_t> Rewind::branch(std::ostream &out) const {
+    std::unordered_map<int64_t, uint64_t> running;
+    auto wait_continuation = [&]() {
+        auto child = platform::wait_child();
+        if (!child) {
+            // nothing left to wait for
+            running.clear();
+            return;
+        }
+        auto it = running.find(child->id);
+        if (it == running.end()) return;
+        if (child->code != 0) {
+            out << fmt::format("continuation {0} exited with {1}. see {2}", it->second,
+                               child->code, log_filename(it->second))
+                << std::endl;
+        }
+        running.erase(it);
+    };
+
+    for (uint64_t i = 0; i < num_continuations(); i++) {
+        while (running.size() >= max_jobs_) {
+            wait_continuation();
+        }
+        auto id = platform::fork_process();
+        if (!id) {
+            while (!running.empty()) {
+                wait_continuation();
+            }
+            throw std::runtime_error("Unable to fork the simulation");
+        }
+        if (*id == 0) return i;
+        running.emplace(*id, i);
+    }
+    while (!running.empty()) {
+        wait_continuation();
+    }
+    return std::nullopt;
+}
+
+}  // namespace fsim::runtime
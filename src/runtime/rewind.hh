@@ -0,0 +1,41 @@
+#ifndef FSIM_REWIND_HH
+#define FSIM_REWIND_HH
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fsim::runtime {
+
+// fast rewind. with +fsim_fork_at=<time>, the simulation forks itself once every event before the
+// given time is done, so that many continuations start from the same warmed-up state without
+// simulating the prefix again. the memory is shared copy-on-write between the processes.
+// continuation i gets the plusargs in line i of +fsim_fork_args=<file> on top of the common ones
+// and writes its output to <prefix>.<i>.log, where the prefix is set by +fsim_fork_log=<prefix>.
+// at most +fsim_fork_jobs=<num> continuations run at the same time
+class Rewind {
+public:
+    explicit Rewind(const std::vector<std::string> &args);
+
+    [[nodiscard]] bool enabled() const { return branch_time_.has_value(); }
+    [[nodiscard]] uint64_t branch_time() const { return *branch_time_; }
+    [[nodiscard]] uint64_t num_continuations() const;
+    [[nodiscard]] std::vector<std::string> continuation_args(uint64_t index) const;
+    [[nodiscard]] std::string log_filename(uint64_t index) const;
+
+    // forks every continuation. returns the continuation index in the child processes and nullopt
+    // in the parent, once all of them have exited. failed continuations are reported to out
+    std::optional<uint64_t> branch(std::ostream &out) const;
+
+private:
+    std::optional<uint64_t> branch_time_;
+    uint64_t max_jobs_;
+    std::string log_prefix_ = "fsim";
+    std::vector<std::string> common_args_;
+    std::vector<std::vector<std::string>> continuation_args_;
+};
+
+}  // namespace fsim::runtime
+
+#endif  // FSIM_REWIND_HH
@@ -1,15 +1,58 @@
 #include "scheduler.hh"
 
+#include <bit>
+#include <fstream>
 #include <iostream>
 #include <utility>
 
+#include "checkpoint.hh"
+#include "dump.hh"
+#include "fmt/format.h"
+#include "marl/waitgroup.h"
 #include "module.hh"
+#include "rewind.hh"
 #include "variable.hh"
 #include "vpi.hh"
 
 namespace fsim::runtime {
 
-void Process::schedule_nba(const std::function<void()> &f) const { scheduler->schedule_nba(f); }
+constexpr std::string_view restart_arg = "+fsim_restart=";
+
+void Process::schedule_nba(const std::function<void()> &f) { schedule_nba(nullptr, f); }
+
+void Process::schedule_nba(void *target, const std::function<void()> &f) {
+    add_nba(NBA{target, nullptr, nullptr, f});
+}
+
+void Process::add_nba(NBA &&nba) {
+    // only register the process once per time step
+    if (nbas.empty()) scheduler->add_nba_process(this);
+    nbas.emplace_back(std::move(nba));
+}
+
+void *NBAArena::allocate(uint64_t size, uint64_t alignment) {
+    while (chunk_index_ < chunks_.size()) {
+        auto const &[chunk, chunk_size] = chunks_[chunk_index_];
+        auto offset = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= chunk_size) {
+            offset_ = offset + size;
+            return chunk.get() + offset;
+        }
+        chunk_index_++;
+        offset_ = 0;
+    }
+    // out of memory. chunks are kept around after reset so this is rare
+    auto chunk_size = std::max(size, default_chunk_size);
+    auto &[chunk, _] = chunks_.emplace_back(std::make_unique<std::byte[]>(chunk_size), chunk_size);
+    chunk_index_ = chunks_.size() - 1;
+    offset_ = size;
+    return chunk.get();
+}
+
+void NBAArena::reset() {
+    chunk_index_ = 0;
+    offset_ = 0;
+}
 
 CombProcess::CombProcess() {
     // by default, it's not running
@@ -23,28 +66,196 @@ FFProcess::FFProcess() {
     finished = true;
 }
 
+void SignalStore::add_fanout(TrackedVar *var, FanoutKind kind, Process *process) {
+    if (var->signal_id == TrackedVar::no_signal_id) {
+        var->signal_id = num_signals_++;
+    }
+    pending_.emplace_back(Fanout{var->signal_id, kind, process});
+}
+
+void SignalStore::finalize() {
+    // counting sort by signal id and fanout kind. the order of processes in the same fanout list
+    // is kept
+    offsets_.assign(num_signals_ * num_fanout_kinds + 1, 0);
+    for (auto const &fanout : pending_) {
+        offsets_[fanout.id * num_fanout_kinds + static_cast<uint32_t>(fanout.kind) + 1]++;
+    }
+    for (auto i = 1u; i < offsets_.size(); i++) {
+        offsets_[i] += offsets_[i - 1];
+    }
+    fanouts_.resize(pending_.size());
+    auto pos = offsets_;
+    for (auto const &fanout : pending_) {
+        fanouts_[pos[fanout.id * num_fanout_kinds + static_cast<uint32_t>(fanout.kind)]++] =
+            fanout.process;
+    }
+    std::vector<Fanout>().swap(pending_);
+    dirty_ = std::vector<std::atomic<uint64_t>>((num_signals_ + 63) / 64);
+}
+
+void SignalStore::propagate_dirty() {
+    if (!has_dirty_.exchange(false, std::memory_order_acq_rel)) return;
+    for (auto i = 0u; i < dirty_.size(); i++) {
+        if (!dirty_[i].load(std::memory_order_relaxed)) continue;
+        auto bits = dirty_[i].exchange(0, std::memory_order_acq_rel);
+        while (bits) {
+            auto id = i * 64 + std::countr_zero(bits);
+            bits &= bits - 1;
+            for (auto *process : fanout(id, FanoutKind::comb)) {
+                process->should_trigger.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
 ScheduledTimeslot::ScheduledTimeslot(uint64_t time, Process *process)
     : time(time), process(process) {}
 
+void TimingWheel::schedule(uint64_t time, Process *process) {
+    size_.fetch_add(1, std::memory_order_acq_rel);
+    insert(time, process);
+}
+
+std::optional<uint64_t> TimingWheel::next(std::vector<Process *> &processes) {
+    while (!empty()) {
+        auto current = current_time_.load(std::memory_order_acquire);
+        // level 0 holds events that only differ from the current time in the lowest bits
+        if (auto index = find_slot(0, current & slot_mask)) {
+            auto time = (current & ~slot_mask) | *index;
+            current_time_.store(time, std::memory_order_release);
+            auto *process = take_slot(0, *index);
+            // the bit may be stale if the slot was drained concurrently
+            if (!process) continue;
+            while (process) {
+                processes.emplace_back(process);
+                process = process->next_event;
+                size_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+            return time;
+        }
+
+        // cascade the next occupied slot from upper levels down to lower levels
+        bool cascaded = false;
+        for (auto level = 1u; level < num_levels; level++) {
+            auto shift = level * level_bits;
+            auto index = find_slot(level, ((current >> shift) & slot_mask) + 1);
+            if (!index) continue;
+            auto upper_shift = shift + level_bits;
+            auto time = ((current >> upper_shift) << upper_shift) | (*index << shift);
+            current_time_.store(time, std::memory_order_release);
+            auto *process = take_slot(level, *index);
+            while (process) {
+                auto *next = process->next_event;
+                insert(process->event_time, process);
+                process = next;
+            }
+            cascaded = true;
+            break;
+        }
+        if (cascaded) continue;
+
+        // the rest of the events are too far in the future
+        std::lock_guard guard(overflow_lock_);
+        // producers have not finished inserting yet
+        if (overflow_.empty()) break;
+        auto time = overflow_.top().time;
+        current_time_.store(time, std::memory_order_release);
+        while (!overflow_.empty() &&
+               ((overflow_.top().time ^ time) >> (num_levels * level_bits)) == 0) {
+            auto const &event = overflow_.top();
+            insert(event.time, event.process);
+            overflow_.pop();
+        }
+    }
+    return std::nullopt;
+}
+
+void TimingWheel::insert(uint64_t time, Process *process) {
+    auto current = current_time_.load(std::memory_order_acquire);
+    // events are never scheduled in the past
+    if (time < current) time = current;
+    // also read by checkpoints, so it is set even if the event overflows
+    process->event_time = time;
+    auto diff = time ^ current;
+    auto level = diff ? (std::bit_width(diff) - 1) / level_bits : 0;
+    if (level >= num_levels) {
+        std::lock_guard guard(overflow_lock_);
+        overflow_.emplace(time, process);
+        return;
+    }
+
+    auto index = (time >> (level * level_bits)) & slot_mask;
+    auto &head = slots_[level][index];
+    auto *old_head = head.load(std::memory_order_relaxed);
+    do {
+        process->next_event = old_head;
+    } while (!head.compare_exchange_weak(old_head, process, std::memory_order_release,
+                                         std::memory_order_relaxed));
+    occupied_[level][index / 64].fetch_or(1ull << (index % 64), std::memory_order_release);
+}
+
+std::optional<uint64_t> TimingWheel::find_slot(uint64_t level, uint64_t start) const {
+    for (auto word = start / 64; word < num_words; word++) {
+        auto bits = occupied_[level][word].load(std::memory_order_acquire);
+        // mask out slots before start
+        if (word == start / 64) bits &= ~0ull << (start % 64);
+        if (bits) return word * 64 + std::countr_zero(bits);
+    }
+    return std::nullopt;
+}
+
+Process *TimingWheel::take_slot(uint64_t level, uint64_t index) {
+    // clear the bit first so that a concurrent insertion will set it again
+    occupied_[level][index / 64].fetch_and(~(1ull << (index % 64)), std::memory_order_acq_rel);
+    return slots_[level][index].exchange(nullptr, std::memory_order_acquire);
+}
+
 ScheduledJoin::ScheduledJoin(const std::vector<const ForkProcess *> &process,
                              Process *parent_process, JoinType type)
     : processes(process), parent_process(parent_process), type(type) {}
 
-Scheduler::Scheduler() : marl_scheduler_(marl::Scheduler::Config::allCores()) {
-    // bind to the main thread
-    marl_scheduler_.bind();
+Scheduler::Scheduler()
+    : own_marl_scheduler_(
+          std::make_unique<marl::Scheduler>(marl::Scheduler::Config::allCores())) {
+    marl_scheduler_ = own_marl_scheduler_.get();
+    bind_workers();
+}
+
+Scheduler::Scheduler(marl::Scheduler *workers) : marl_scheduler_(workers) { bind_workers(); }
+
+Scheduler::Scheduler(int argc, char *argv[]) : args_(argv, argv + argc) {
+    auto rewind = std::make_unique<Rewind>(args_);
+    if (rewind->enabled()) {
+        // no worker threads. every process runs on the calling thread
+        marl::Scheduler::Config config;
+        config.setWorkerThreadCount(0);
+        own_marl_scheduler_ = std::make_unique<marl::Scheduler>(config);
+        rewind_ = std::move(rewind);
+    } else {
+        own_marl_scheduler_ =
+            std::make_unique<marl::Scheduler>(marl::Scheduler::Config::allCores());
+    }
+    marl_scheduler_ = own_marl_scheduler_.get();
+    bind_workers();
+}
+
+void Scheduler::bind_workers() {
+    // bind to the current thread
+    marl_scheduler_->bind();
+    auto num_workers = marl_scheduler_->config().workerThread.count;
+    nba_shards_.resize(std::max(num_workers, 1));
 }
 
 inline bool has_init_left(const std::vector<std::unique_ptr<InitialProcess>> &inits) {
     return std::any_of(inits.begin(), inits.end(), [](auto const &i) { return !i->finished; });
 }
 
-void printout_finish(int code, uint64_t time, std::string_view loc) {
-    std::cout << "$finish(" << code << ") called at " << time;
+void printout_finish(std::ostream &out, int code, uint64_t time, std::string_view loc) {
+    out << "$finish(" << code << ") called at " << time;
     if (!loc.empty()) {
-        std::cout << " (" << loc << ")";
+        out << " (" << loc << ")";
     }
-    std::cout << std::endl;
+    out << std::endl;
 }
 
 inline void wake_up_thread(Process *process) {
@@ -95,17 +306,31 @@ bool join_processes(std::vector<ScheduledJoin> &joins) {
 }
 
 void Scheduler::run(Module *top) {
+    for (auto const &arg : args_) {
+        if (arg.starts_with(restart_arg)) {
+            restore_checkpoint(arg.substr(restart_arg.size()));
+        }
+    }
+
     // schedule init for every module
     top_ = top;
     top->comb(this);
     top->ff(this);
+    top->init(this);
+    top->final(this);
+    // no more fanouts after elaboration
+    signals_.finalize();
+    elaborated_ = true;
 
     // start of the simulation
     if (vpi_) vpi_->start();
 
-    // init will run immediately so need to initialize comb and ff first
-    top->init(this);
-    top->final(this);
+    if (restore_file_) {
+        restore_processes();
+    } else {
+        for (auto *process : pending_init_) schedule_init(process);
+        pending_init_.clear();
+    }
 
     // either wait for the finish or wait for the complete from init
     while (true) {
@@ -135,22 +360,27 @@ void Scheduler::run(Module *top) {
             }
         }
 
+        if (dumper_) dumper_->end_time_step(sim_time);
+        if (checkpoint_requested_) write_checkpoints();
+
         // schedule for the next time slot
         {
-            // need to lock it since the moment we unlock a process, it may try to
-            // schedule more events immediately
-            std::lock_guard guard(event_queue_lock_);
-            if (!event_queue_.empty()) {
-                auto next_slot_time = event_queue_.top().time;
+            // the wheel advances to the next time slot before any process is released, so
+            // processes that schedule more events immediately will see the new time
+            auto next_slot_time = event_queue_.next(next_events_);
+            // nothing changes until the next time slot, so this is the state at the branch time
+            if (rewind_ && next_slot_time && *next_slot_time > rewind_->branch_time()) {
+                if (!branch()) break;
+            }
+            if (next_slot_time) {
                 // jump to the next
-                sim_time = next_slot_time;
+                sim_time = *next_slot_time;
                 //  we could have multiple events scheduled at the same time slot
                 //  release all of them at once
-                while (!event_queue_.empty() && event_queue_.top().time == next_slot_time) {
-                    auto const &event = event_queue_.top();
-                    wake_up_thread(event.process);
-                    event_queue_.pop();
+                for (auto *process : next_events_) {
+                    wake_up_thread(process);
                 }
+                next_events_.clear();
             }
         }
     }
@@ -159,12 +389,16 @@ void Scheduler::run(Module *top) {
     // this only happens when a process has infinite loop or waiting for the next event schedule
     terminate_ = true;
     terminate_processes();
+    // the continuations finish the simulation
+    if (branched_) return;
 
     // execute final
     for (auto &final : final_processes_) {
         schedule_final(final.get());
     }
 
+    if (dumper_) dumper_->close(sim_time);
+
     // end of simulation
     if (vpi_) vpi_->end();
 }
@@ -211,6 +445,14 @@ ForkProcess *Scheduler::create_fork_process() {
 }
 
 void Scheduler::schedule_init(InitialProcess *process) {
+    auto *scheduler = process->scheduler;
+    // processes restored from a checkpoint are started after the whole design is elaborated
+    if (scheduler && scheduler->restore_file_) return;
+    // the same for the rest, since they may register event controls after being created
+    if (scheduler && !scheduler->elaborated_) {
+        scheduler->pending_init_.emplace_back(process);
+        return;
+    }
     process->running = true;
     marl::schedule([process] {
         process->func();
@@ -228,8 +470,7 @@ void Scheduler::schedule_final(FinalProcess *final) {
 }
 
 void Scheduler::schedule_delay(const ScheduledTimeslot &event) {
-    std::lock_guard guard(event_queue_lock_);
-    event_queue_.emplace(event);
+    event_queue_.schedule(event.time, event.process);
 }
 
 void Scheduler::schedule_join_check(const ScheduledJoin &join) {
@@ -250,18 +491,60 @@ void Scheduler::schedule_finish(int code, std::string_view loc) {
     }
 }
 
-void Scheduler::schedule_nba(const std::function<void()> &func) {
-    std::lock_guard guard(nba_lock_);
-    nbas_.emplace_back(func);
+template <typename T>
+void push_lock_free(std::atomic<T *> &head, T *node, T *T::*next) {
+    auto *old_head = head.load(std::memory_order_relaxed);
+    do {
+        node->*next = old_head;
+    } while (!head.compare_exchange_weak(old_head, node, std::memory_order_release,
+                                         std::memory_order_relaxed));
+}
+
+void Scheduler::add_nba_process(Process *process) {
+    push_lock_free(nba_processes_, process, &Process::next_nba);
+}
+
+void Scheduler::schedule_ff(FFProcess *process) {
+    // only queue the process once
+    if (process->queued.exchange(true, std::memory_order_acq_rel)) return;
+    push_lock_free(ready_ff_, process, &FFProcess::next_ready);
+}
+
+Dumper *Scheduler::dumper() {
+    std::call_once(dumper_flag_, [this] { dumper_ = std::make_unique<Dumper>(&sim_time); });
+    return dumper_.get();
 }
 
-void Scheduler::add_process_edge_control(Process *process) {
-    process_edge_controls_.emplace_back(process);
+void Scheduler::save_checkpoint(std::string_view filename) {
+    std::lock_guard guard(checkpoint_lock_);
+    checkpoint_files_.emplace_back(filename);
+    checkpoint_requested_ = true;
+}
+
+void Scheduler::restore_checkpoint(const std::string &filename) {
+    restore_file_ = std::make_unique<CheckpointFile>(filename);
+}
+
+void Scheduler::set_args(int argc, char *argv[]) {
+    args_ = std::vector<std::string>(argv, argv + argc);
+}
+
+void Scheduler::add_tracked_var(TrackedVar *var) {
+    var->scheduler = this;
+    var->edge_control = true;
+}
+
+void Scheduler::add_edged_var(TrackedVar *var) {
+    push_lock_free(edged_vars_, var, &TrackedVar::next_edged);
+}
+
+void Scheduler::add_process_edge_control(Process *process, TrackedVar *var) {
+    add_tracked_var(var);
+    signals_.add_fanout(var, SignalStore::FanoutKind::edge_control, process);
 }
 
 Scheduler::~Scheduler() {
-    nbas_.clear();
-    marl_scheduler_.unbind();  // NOLINT
+    marl_scheduler_->unbind();  // NOLINT
 }
 
 bool Scheduler::loop_stabilized() const {
@@ -274,14 +557,203 @@ bool Scheduler::terminate() const {
            (!has_init_left(init_processes_) && top_->stabilized() && event_queue_.empty());
 }
 
+bool Scheduler::branch() {
+    auto rewind = std::move(rewind_);
+    // only the calling thread survives the fork, which rules out the waveform writer. the waveform
+    // ends at the branch point
+    if (dumper_) dumper_->close(sim_time);
+    top_->output().flush();
+    std::cout.flush();
+
+    auto index = rewind->branch(top_->output());
+    if (!index) {
+        branched_ = true;
+        return false;
+    }
+    continuation_ = index;
+    set_args(rewind->continuation_args(*index));
+    continuation_output_ = std::make_unique<std::ofstream>(rewind->log_filename(*index));
+    top_->set_output(continuation_output_.get());
+    return true;
+}
+
+template <typename T>
+std::string get_suspended_process(const std::vector<std::unique_ptr<T>> &processes,
+                                  std::string_view kind) {
+    for (auto i = 0u; i < processes.size(); i++) {
+        auto const &p = processes[i];
+        if (!p->finished && !p->resume_point) {
+            return fmt::format("{0} process {1} is not suspended at a top-level delay", kind, i);
+        }
+    }
+    return {};
+}
+
+std::string Scheduler::checkpoint_error() const {
+    // fibers can't be saved. a process can only be restarted if it is idle or waiting at one of
+    // the delays at the top level of its body
+    for (auto const &error : {get_suspended_process(init_processes_, "initial"),
+                              get_suspended_process(comb_processes_, "always"),
+                              get_suspended_process(ff_processes_, "always_ff"),
+                              get_suspended_process(fork_processes_, "fork")}) {
+        if (!error.empty()) return error;
+    }
+    // NBAs are always committed at the end of a time step
+    if (nba_processes_.load()) return "pending NBAs";
+    return {};
+}
+
+template <typename T>
+void add_process_records(const std::vector<std::unique_ptr<T>> &processes,
+                         std::vector<ProcessRecord> &records) {
+    for (auto const &p : processes) {
+        if (p->finished) {
+            records.emplace_back(ProcessRecord{ProcessRecord::State::idle, 0, 0});
+        } else {
+            records.emplace_back(
+                ProcessRecord{ProcessRecord::State::delayed, p->resume_point, p->event_time});
+        }
+    }
+}
+
+void Scheduler::write_checkpoints() {
+    std::vector<std::string> filenames;
+    {
+        std::lock_guard guard(checkpoint_lock_);
+        filenames = std::move(checkpoint_files_);
+        checkpoint_files_.clear();
+        checkpoint_requested_ = false;
+    }
+
+    auto error = checkpoint_error();
+    for (auto const &filename : filenames) {
+        if (error.empty()) {
+            try {
+                CheckpointHeader header = {};
+                header.sim_time = sim_time;
+                header.num_init_processes = init_processes_.size();
+                header.num_comb_processes = comb_processes_.size();
+                header.num_ff_processes = ff_processes_.size();
+                std::vector<ProcessRecord> records;
+                add_process_records(init_processes_, records);
+                add_process_records(comb_processes_, records);
+                add_process_records(ff_processes_, records);
+                Checkpoint vars(top_);
+                CheckpointFile::write(filename, header, records, vars);
+                continue;
+            } catch (const std::runtime_error &ex) {
+                error = ex.what();
+            }
+        }
+        top_->output() << "$save(" << filename << ") failed at " << sim_time << ": " << error
+                       << std::endl;
+    }
+}
+
+template <typename T>
+void restore_process_records(const std::vector<std::unique_ptr<T>> &processes,
+                             std::span<const ProcessRecord> records) {
+    for (auto i = 0u; i < processes.size(); i++) {
+        auto *p = processes[i].get();
+        auto const &record = records[i];
+        p->should_trigger.store(false, std::memory_order_relaxed);
+        if (record.state == ProcessRecord::State::idle) {
+            p->finished = true;
+            p->running = false;
+            continue;
+        }
+        // the process jumps to its resume point and waits for the rest of the delay
+        p->finished = false;
+        p->running = true;
+        p->restored = true;
+        p->resume_point = record.resume_point;
+        p->event_time = record.event_time;
+        marl::schedule([p] { p->func(); });
+    }
+}
+
+void Scheduler::restore_processes() {
+    auto const &header = restore_file_->header();
+    if (header.num_init_processes != init_processes_.size() ||
+        header.num_comb_processes != comb_processes_.size() ||
+        header.num_ff_processes != ff_processes_.size()) {
+        throw std::runtime_error("Checkpoint processes do not match the design");
+    }
+    Checkpoint vars(top_);
+    vars.restore_values(restore_file_->vars(), restore_file_->data());
+    sim_time = header.sim_time;
+
+    auto records = restore_file_->processes();
+    restore_process_records(init_processes_, records.subspan(0, init_processes_.size()));
+    records = records.subspan(init_processes_.size());
+    restore_process_records(comb_processes_, records.subspan(0, comb_processes_.size()));
+    records = records.subspan(comb_processes_.size());
+    restore_process_records(ff_processes_, records);
+    // everything has been copied out of the mapping
+    restore_file_.reset();
+}
+
+inline uint64_t get_nba_shard(const void *target, uint64_t num_shards) {
+    // pointers are aligned, so mix the bits before taking the modulo
+    auto value = reinterpret_cast<uintptr_t>(target) * 0x9E3779B97F4A7C15ull;
+    return (value >> 32) % num_shards;
+}
+
 bool Scheduler::execute_nba() {
-    // maybe split it up into multiple fiber threads?
-    bool has_nba = !nbas_.empty();
-    for (auto const &f : nbas_) {
-        f();
+    auto *process = nba_processes_.exchange(nullptr, std::memory_order_acquire);
+    if (!process) return false;
+
+    // processes register themselves in arbitrary order. sort them so that the last writer to
+    // the same variable is deterministic
+    while (process) {
+        nba_commit_order_.emplace_back(process);
+        process = process->next_nba;
+    }
+    std::sort(nba_commit_order_.begin(), nba_commit_order_.end(),
+              [](auto const *a, auto const *b) { return a->id < b->id; });
+
+    uint64_t num_nbas = 0;
+    bool has_unknown_target = false;
+    for (auto const *p : nba_commit_order_) {
+        num_nbas += p->nbas.size();
+        has_unknown_target =
+            has_unknown_target || std::any_of(p->nbas.begin(), p->nbas.end(),
+                                              [](auto const &nba) { return !nba.target; });
+    }
+
+    if (num_nbas < parallel_nba_threshold || has_unknown_target || nba_shards_.size() == 1) {
+        for (auto const *p : nba_commit_order_) {
+            for (auto const &nba : p->nbas) {
+                nba.apply();
+            }
+        }
+    } else {
+        // each variable belongs to exactly one shard, and within a shard NBAs are kept in the
+        // process order
+        for (auto const *p : nba_commit_order_) {
+            for (auto const &nba : p->nbas) {
+                nba_shards_[get_nba_shard(nba.target, nba_shards_.size())].emplace_back(&nba);
+            }
+        }
+        marl::WaitGroup commit_control(nba_shards_.size());
+        for (auto &shard : nba_shards_) {
+            marl::schedule([&shard, commit_control]() {
+                for (auto const *nba : shard) {
+                    nba->apply();
+                }
+                shard.clear();
+                commit_control.done();
+            });
+        }
+        commit_control.wait();
+    }
+
+    for (auto *p : nba_commit_order_) {
+        p->nbas.clear();
+        p->nba_arena.reset();
     }
-    nbas_.clear();
-    return has_nba;
+    nba_commit_order_.clear();
+    return true;
 }
 
 void Scheduler::terminate_processes() {
@@ -313,7 +785,7 @@ void Scheduler::terminate_processes() {
     }
 
     if (finish_flag_) {
-        printout_finish(finish_.code, sim_time, finish_.loc);
+        printout_finish(top_->output(), finish_.code, sim_time, finish_.loc);
     }
 }
 
@@ -332,8 +804,11 @@ requires(std::is_base_of<Process, T>::value) void settle_processes(
 void Scheduler::active() {
     // need to wait for all processes settled
     stabilize_process();
-    top_->active();
-    stabilize_process();
+    do {
+        top_->active(this);
+        stabilize_process();
+        // FF processes may trigger more combinational logic
+    } while (run_ready_ff());
 
     handle_edge_triggering();
     stabilize_process();
@@ -346,20 +821,60 @@ void Scheduler::stabilize_process() {
     settle_processes(fork_processes_);
 }
 
+bool Scheduler::run_ready_ff() {
+    auto *process = ready_ff_.exchange(nullptr, std::memory_order_acquire);
+    if (!process) return false;
+
+    bool changed = false;
+    while (process) {
+        auto *next = process->next_ready;
+        // allow the process to be queued again by a new edge
+        process->queued = false;
+        // if it's not finished, it means it's waiting
+        if (process->should_trigger.load(std::memory_order_relaxed) && process->finished) {
+            changed = true;
+            if (process->stackless) {
+                // never suspends, so we can run it in the current thread
+                process->should_trigger.store(false, std::memory_order_relaxed);
+                process->func();
+            } else {
+                process->finished = false;
+                process->running = true;
+                running_ff_.emplace_back(process);
+                marl::schedule([process]() { process->func(); });
+            }
+        }
+        process = next;
+    }
+
+    for (auto *p : running_ff_) {
+        p->cond.wait();
+        p->running = false;
+    }
+    running_ff_.clear();
+    return changed;
+}
+
 void Scheduler::handle_edge_triggering() {
-    for (auto *process : process_edge_controls_) {
-        if (process->edge_control.var) {
-            auto const *var = process->edge_control.var;
+    // only variables with edges can wake up processes
+    auto *var = edged_vars_.exchange(nullptr, std::memory_order_acquire);
+    if (!var) return;
+
+    for (auto const *edged = var; edged; edged = edged->next_edged) {
+        for (auto *process :
+             signals_.fanout(edged->signal_id, SignalStore::FanoutKind::edge_control)) {
+            // the process may be waiting on a different variable or not waiting at all
+            if (process->edge_control.var != edged) continue;
             bool trigger = false;
             switch (process->edge_control.type) {
                 case Process::EdgeControlType::posedge:
-                    trigger = var->should_trigger_posedge;
+                    trigger = edged->should_trigger_posedge;
                     break;
                 case Process::EdgeControlType::negedge:
-                    trigger = var->should_trigger_negedge;
+                    trigger = edged->should_trigger_negedge;
                     break;
                 case Process::EdgeControlType::both:
-                    trigger = var->should_trigger_negedge || var->should_trigger_posedge;
+                    trigger = edged->should_trigger_negedge || edged->should_trigger_posedge;
                     break;
             }
             if (trigger) {
@@ -369,8 +884,10 @@ void Scheduler::handle_edge_triggering() {
         }
     }
     // this is necessary due to the out of ordering of execution
-    for (auto *tracked_var : tracked_vars_) {
-        tracked_var->reset();
+    while (var) {
+        auto *next = var->next_edged;
+        var->reset();
+        var = next;
     }
 }
 
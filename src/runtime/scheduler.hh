@@ -1,22 +1,69 @@
 #ifndef FSIM_SCHEDULER_HH
 #define FSIM_SCHEDULER_HH
 
+#include <array>
 #include <atomic>
+#include <iosfwd>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
 #include <queue>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 #include "marl/event.h"
 #include "marl/scheduler.h"
 
 namespace fsim::runtime {
 
+class CheckpointFile;
+class Rewind;
+class Dumper;
 class Module;
 class Scheduler;
 class TrackedVar;
 class VPIController;
 
+struct NBA {
+    // variable being written to. nullptr if unknown, which disables parallel commit
+    void *target = nullptr;
+    // plain variable assignment. value points into the process's NBA arena
+    void (*write)(void *target, const void *value) = nullptr;
+    const void *value = nullptr;
+    // everything else, e.g. selects
+    std::function<void()> func;
+
+    void apply() const {
+        if (write) {
+            write(target, value);
+        } else {
+            func();
+        }
+    }
+};
+
+template <typename T, typename V>
+void write_nba(void *target, const void *value) {
+    *reinterpret_cast<T *>(target) = *reinterpret_cast<const V *>(value);
+}
+
+// bump allocator for NBA values. the memory is reused after every NBA commit
+class NBAArena {
+public:
+    void *allocate(uint64_t size, uint64_t alignment);
+    void reset();
+
+private:
+    static constexpr uint64_t default_chunk_size = 4096;
+    std::vector<std::pair<std::unique_ptr<std::byte[]>, uint64_t>> chunks_;
+    uint64_t chunk_index_ = 0;
+    uint64_t offset_ = 0;
+};
+
 struct Process {
     uint64_t id = 0;
     bool finished = false;
@@ -29,10 +76,22 @@ struct Process {
     marl::Event delay = marl::Event(marl::Event::Mode::Auto);
     Scheduler *scheduler = nullptr;
 
-    void schedule_nba(const std::function<void()> &f) const;
-
-    // used by trigger-based processes
-    bool should_trigger = false;
+    void schedule_nba(const std::function<void()> &f);
+    void schedule_nba(void *target, const std::function<void()> &f);
+    template <typename T, typename V>
+    void schedule_nba(T &target, const V &value) {
+        if constexpr (std::is_trivially_copyable_v<V>) {
+            auto *ptr = nba_arena.allocate(sizeof(V), alignof(V));
+            new (ptr) V(value);
+            add_nba(NBA{&target, &write_nba<T, V>, ptr, {}});
+        } else {
+            schedule_nba(&target, [&target, value]() { target = value; });
+        }
+    }
+
+    // used by trigger-based processes. set by writers that may run on different workers, e.g.
+    // parallel combinational levels and NBA shards
+    std::atomic<bool> should_trigger = false;
 
     enum class EdgeControlType { posedge, negedge, both };
     struct EdgeControl {
@@ -41,6 +100,27 @@ struct Process {
     };
 
     EdgeControl edge_control;
+
+    // used by the timing wheel to chain processes scheduled into the same slot.
+    // a process can only wait for one time slot at a time
+    Process *next_event = nullptr;
+    uint64_t event_time = 0;
+
+    // set while the process is suspended at a delay at the top level of its body, which is where
+    // a process restored from a checkpoint restarts from. 0 if it is anywhere else
+    uint32_t resume_point = 0;
+    // the restarted process waits until event_time instead of its own delay
+    bool restored = false;
+
+    // NBAs scheduled by this process in the current time step. only the process itself
+    // writes to it, so no lock is needed
+    std::vector<NBA> nbas;
+    NBAArena nba_arena;
+    // used by the scheduler to chain processes that have pending NBAs
+    Process *next_nba = nullptr;
+
+private:
+    void add_nba(NBA &&nba);
 };
 
 struct InitialProcess : public Process {};
@@ -49,15 +129,91 @@ struct ForkProcess : public Process {};
 
 struct CombProcess : public Process {
     CombProcess();
+
+    // levelized process has no timing control and is evaluated directly in the caller's
+    // thread, in the order it is added to the module
+    bool levelized = false;
+    // processes in the same level are evaluated in parallel, one level after another.
+    // -1 means it is evaluated serially after all the levels
+    int level = -1;
 };
 
 struct FFProcess : public Process {
 public:
     FFProcess();
+
+    // stackless process has no timing control after its edge list. it is called directly by the
+    // scheduler without switching to a fiber
+    bool stackless = false;
+    // set when the process is in the scheduler's ready list
+    std::atomic<bool> queued = false;
+    FFProcess *next_ready = nullptr;
 };
 
 struct FinalProcess : public Process {};
 
+// fanouts of all tracked variables in the simulation. variables get dense ids when the first
+// fanout is added during elaboration. after elaboration the fanouts are compacted into CSR form so
+// that propagating a change only touches one contiguous range of processes
+// TODO: values are still members of the generated module classes. keep them in contiguous storage
+//  indexed by the signal id as well, which requires the generated expressions to read and write
+//  through the store instead of the logic_t/bit_t members
+class SignalStore {
+public:
+    // edge_control holds processes with an event control on the signal
+    enum class FanoutKind : uint8_t { comb = 0, posedge = 1, negedge = 2, edge_control = 3 };
+    static constexpr uint32_t num_fanout_kinds = 4;
+
+    // not thread-safe. only called during elaboration
+    void add_fanout(TrackedVar *var, FanoutKind kind, Process *process);
+    void finalize();
+
+    [[nodiscard]] std::span<Process *const> fanout(uint32_t id, FanoutKind kind) const {
+        // variables without any fanout or added after finalization
+        if (id >= offsets_.size() / num_fanout_kinds) return {};
+        auto index = id * num_fanout_kinds + static_cast<uint32_t>(kind);
+        return {fanouts_.data() + offsets_[index], fanouts_.data() + offsets_[index + 1]};
+    }
+
+    [[nodiscard]] uint32_t size() const { return num_signals_; }
+
+    // in dirty propagation mode, a changed variable only marks its signal as dirty. the comb
+    // fanouts of all dirty signals are triggered together before combinational processes are
+    // evaluated, so repeated writes to the same signal in one delta cycle are coalesced
+    void set_dirty_propagation(bool value) { dirty_propagation_ = value; }
+    [[nodiscard]] bool dirty_propagation() const { return dirty_propagation_; }
+
+    // thread-safe
+    void mark_dirty(uint32_t id) {
+        if (id / 64 >= dirty_.size()) return;
+        auto &word = dirty_[id / 64];
+        auto bit = 1ull << (id % 64);
+        if (word.load(std::memory_order_relaxed) & bit) return;
+        word.fetch_or(bit, std::memory_order_relaxed);
+        has_dirty_.store(true, std::memory_order_release);
+    }
+    void propagate_dirty();
+
+private:
+    struct Fanout {
+        uint32_t id;
+        FanoutKind kind;
+        Process *process;
+    };
+    std::vector<Fanout> pending_;
+
+    uint32_t num_signals_ = 0;
+    // fanouts of signal i and kind k is in [offsets_[i * n + k], offsets_[i * n + k + 1]), where n
+    // is num_fanout_kinds
+    std::vector<uint32_t> offsets_;
+    std::vector<Process *> fanouts_;
+
+    bool dirty_propagation_ = false;
+    // one bit per signal
+    std::vector<std::atomic<uint64_t>> dirty_;
+    std::atomic<bool> has_dirty_ = false;
+};
+
 class ScheduledTimeslot {
 public:
     // we statically allocate the event cond
@@ -69,6 +225,39 @@ public:
     bool operator<(const ScheduledTimeslot &other) const { return time > other.time; }
 };
 
+// hierarchical timing wheel. each level has 256 slots and covers 8 more bits of time than the
+// previous one. scheduling an event is lock-free unless the event is too far in the future, in
+// which case it is put into an overflow heap
+class TimingWheel {
+public:
+    // thread-safe
+    void schedule(uint64_t time, Process *process);
+    // advances the wheel to the earliest time slot and returns all processes scheduled at that
+    // time. only one thread is allowed to call it
+    std::optional<uint64_t> next(std::vector<Process *> &processes);
+
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+private:
+    static constexpr uint64_t level_bits = 8;
+    static constexpr uint64_t num_slots = 1ull << level_bits;
+    static constexpr uint64_t slot_mask = num_slots - 1;
+    static constexpr uint64_t num_levels = 4;
+    static constexpr uint64_t num_words = num_slots / 64;
+
+    std::array<std::array<std::atomic<Process *>, num_slots>, num_levels> slots_ = {};
+    std::array<std::array<std::atomic<uint64_t>, num_words>, num_levels> occupied_ = {};
+    std::atomic<uint64_t> current_time_ = 0;
+    std::atomic<uint64_t> size_ = 0;
+
+    std::priority_queue<ScheduledTimeslot> overflow_;
+    std::mutex overflow_lock_;
+
+    void insert(uint64_t time, Process *process);
+    [[nodiscard]] std::optional<uint64_t> find_slot(uint64_t level, uint64_t start) const;
+    Process *take_slot(uint64_t level, uint64_t index);
+};
+
 class ScheduledJoin {
 public:
     enum class JoinType { None, Any, All };
@@ -87,6 +276,11 @@ struct FinishInfo {
 class Scheduler {
 public:
     Scheduler();
+    // shares the worker threads with other schedulers in the same process
+    explicit Scheduler(marl::Scheduler *workers);
+    // takes the command line arguments. processes run on the calling thread only if the simulation
+    // forks itself with +fsim_fork_at=<time>, since a forked process only keeps the calling thread
+    Scheduler(int argc, char *argv[]);
     void run(Module *top);
 
     uint64_t sim_time = 0;
@@ -103,24 +297,47 @@ public:
     void schedule_join_check(const ScheduledJoin &join);
     static void schedule_fork(ForkProcess *process);
     void schedule_finish(int code, std::string_view loc = {});
-    void schedule_nba(const std::function<void()> &func);
-    void add_tracked_var(TrackedVar *var) { tracked_vars_.emplace(var); }
-    void add_process_edge_control(Process *process);
+    void add_nba_process(Process *process);
+    void schedule_ff(FFProcess *process);
+    void add_tracked_var(TrackedVar *var);
+    [[nodiscard]] SignalStore &signals() { return signals_; }
+    void add_edged_var(TrackedVar *var);
+    void add_process_edge_control(Process *process, TrackedVar *var);
 
     [[nodiscard]] bool finished() const { return terminate_; }
+    [[nodiscard]] Module *top() const { return top_; }
+
+    // waveform dumper, which is created on the first use
+    Dumper *dumper();
+
+    // $save. the checkpoint is written at the end of the current time step, which fails if any
+    // process is suspended somewhere other than a top-level delay. thread-safe
+    void save_checkpoint(std::string_view filename);
+    // has to be called before run(). the design starts from the checkpoint instead of time 0.
+    // also set by +fsim_restart=<filename>. throws std::runtime_error if the checkpoint doesn't
+    // match the design
+    void restore_checkpoint(const std::string &filename);
+
+    // index of the continuation when the simulation is forked by +fsim_fork_at=<time>. the
+    // process that forks stops simulating once every continuation exits. see rewind.hh
+    [[nodiscard]] std::optional<uint64_t> continuation() const { return continuation_; }
 
     // vpi stuff
     void set_vpi(VPIController *vpi) { vpi_ = vpi; }
 
+    void set_dirty_propagation(bool value) { signals_.set_dirty_propagation(value); }
+
+    // command line arguments, which holds plusargs
+    void set_args(int argc, char *argv[]);
+    void set_args(std::vector<std::string> args) { args_ = std::move(args); }
+    [[nodiscard]] const std::vector<std::string> &args() const { return args_; }
+
     ~Scheduler();
 
 private:
-    // if performance becomes a concern, use this concurrent queue instead
-    // https://github.com/cameron314/concurrentqueue
-    // had to use raw pointers here since mutex is not copyable
-    // we will statically allocate time slot inside each module/class
-    std::priority_queue<ScheduledTimeslot> event_queue_;
-    std::mutex event_queue_lock_;
+    // processes waiting for a future time slot
+    TimingWheel event_queue_;
+    std::vector<Process *> next_events_;
     std::vector<ScheduledJoin> join_processes_;
     std::mutex join_processes_lock_;
 
@@ -129,21 +346,33 @@ private:
     std::vector<std::unique_ptr<CombProcess>> comb_processes_;
     std::vector<std::unique_ptr<FFProcess>> ff_processes_;
     std::vector<std::unique_ptr<ForkProcess>> fork_processes_;
-    marl::Scheduler marl_scheduler_;
+    std::unique_ptr<marl::Scheduler> own_marl_scheduler_;
+    marl::Scheduler *marl_scheduler_ = nullptr;
 
     // NBA
-    std::vector<std::function<void()>> nbas_;
-    std::mutex nba_lock_;
+    // below this number NBAs are committed serially since it is not worth waking up workers
+    static constexpr uint64_t parallel_nba_threshold = 256;
+    // processes with pending NBAs, chained as a lock-free stack
+    std::atomic<Process *> nba_processes_ = nullptr;
+    std::vector<Process *> nba_commit_order_;
+    // NBAs partitioned by target variables during parallel commit
+    std::vector<std::vector<const NBA *>> nba_shards_;
 
     // finish info
     std::atomic<bool> finish_flag_ = false;
     bool terminate_ = false;
     FinishInfo finish_ = {};
 
-    // used for track event controls that requires a stabilized synchronization
-    // no mutex lock since it's computed during initialization time, which is serial
-    std::unordered_set<TrackedVar *> tracked_vars_;
-    std::vector<Process *> process_edge_controls_;
+    // FF processes triggered by edges, chained as a lock-free stack
+    std::atomic<FFProcess *> ready_ff_ = nullptr;
+    std::vector<FFProcess *> running_ff_;
+
+    // tracked variables that have edges in the current pass, chained as a lock-free stack
+    std::atomic<TrackedVar *> edged_vars_ = nullptr;
+    SignalStore signals_;
+    // initial processes are started once elaboration is done, since they register event controls
+    bool elaborated_ = false;
+    std::vector<InitialProcess *> pending_init_;
 
     std::atomic<uint64_t> id_count_ = 0;
 
@@ -154,10 +383,35 @@ private:
 
     void active();
     void stabilize_process();
+    bool run_ready_ff();
     void handle_edge_triggering();
 
+    void bind_workers();
+
     Module *top_ = nullptr;
     VPIController *vpi_ = nullptr;
+    std::unique_ptr<Dumper> dumper_;
+    std::once_flag dumper_flag_;
+
+    // checkpoint
+    std::mutex checkpoint_lock_;
+    std::vector<std::string> checkpoint_files_;
+    std::atomic<bool> checkpoint_requested_ = false;
+    std::unique_ptr<CheckpointFile> restore_file_;
+
+    void write_checkpoints();
+    [[nodiscard]] std::string checkpoint_error() const;
+    void restore_processes();
+
+    // fast rewind
+    std::unique_ptr<Rewind> rewind_;
+    std::optional<uint64_t> continuation_;
+    std::unique_ptr<std::ofstream> continuation_output_;
+    bool branched_ = false;
+
+    [[nodiscard]] bool branch();
+
+    std::vector<std::string> args_;
 };
 }  // namespace fsim::runtime
 
@@ -1,7 +1,9 @@
 #include "system_task.hh"
 
+#include <algorithm>
 #include <fstream>
 
+#include "dump.hh"
 #include "module.hh"
 
 namespace fsim::runtime {
@@ -17,6 +19,10 @@ void print_assert_error(std::string_view name, std::string_view loc) {
     std::cout << "Assertion failed: " << name << std::endl;
 }
 
+std::ostream &output_stream(const Module *module) {
+    return module ? module->output() : std::cout;
+}
+
 std::string preprocess_display_fmt(const Module *module, std::string_view format) {
     // based on LRM 21.2
     std::string result;
@@ -80,13 +86,21 @@ std::pair<std::string_view, uint64_t> preprocess_display_fmt(std::string_view fo
 void display(const Module *module, std::string_view format) {
     cout_lock lock;
     auto str = preprocess_display_fmt(module, format);
-    std::cout << str << std::endl;
+    output_stream(module) << str << std::endl;
 }
 
 void write(const Module *module, std::string_view format) {
     cout_lock lock;
     auto str = preprocess_display_fmt(module, format);
-    std::cout << str;
+    output_stream(module) << str;
+}
+
+bool test_plusargs(const Scheduler *scheduler, std::string_view prefix) {
+    // LRM 21.6
+    auto const &args = scheduler->args();
+    return std::any_of(args.begin(), args.end(), [prefix](std::string_view arg) {
+        return arg.starts_with('+') && arg.substr(1).starts_with(prefix);
+    });
 }
 
 struct OpenFile {
@@ -177,4 +191,26 @@ void fwrite(const Module *module, int fd, std::string_view format) {
     fwrite_(fd, str, false);
 }
 
-}  // namespace fsim::runtime
\ No newline at end of file
+void dumpfile(Scheduler *scheduler, std::string_view filename) {
+    scheduler->dumper()->set_filename(filename);
+}
+
+void dumpvars_(Scheduler *scheduler, uint64_t levels, Module *scope, std::string_view scope_name) {
+    if (!scope) {
+        scope = scheduler->top();
+        auto name = scope->hierarchy_name();
+        scheduler->dumper()->add_scope(scope, name, levels);
+    } else {
+        scheduler->dumper()->add_scope(scope, scope_name, levels);
+    }
+}
+
+void dumpon(Scheduler *scheduler) { scheduler->dumper()->dump_on(); }
+
+void dumpoff(Scheduler *scheduler) { scheduler->dumper()->dump_off(); }
+
+void save(Scheduler *scheduler, std::string_view filename) {
+    scheduler->save_checkpoint(filename);
+}
+
+}  // namespace fsim::runtime
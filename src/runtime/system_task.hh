@@ -15,6 +15,9 @@ class Scheduler;
 
 void print_assert_error(std::string_view name, std::string_view loc);
 
+// module can be nullptr, which uses stdout
+std::ostream &output_stream(const Module *module);
+
 struct cout_lock {
     cout_lock();
     ~cout_lock();
@@ -77,7 +80,7 @@ void display(const Module *module, std::string_view format, Args... args) {
         ss << format.substr(pos);
     }
     cout_lock lock;
-    std::cout << ss.str() << std::endl;
+    output_stream(module) << ss.str() << std::endl;
 }
 
 template <typename... Args>
@@ -85,7 +88,7 @@ void write(const Module *module, std::string_view format, Args... args) {
     std::stringstream ss;
     sformat_(module, format, ss, args...);
     cout_lock lock;
-    std::cout << ss.str();
+    output_stream(module) << ss.str();
 }
 
 void display(const Module *module, std::string_view format);
@@ -108,6 +111,8 @@ inline void finish(Scheduler *scheduler, T code, std::string_view loc) {
 
 [[maybe_unused]] inline uint64_t time(Scheduler *scheduler) { return scheduler->sim_time; }
 
+bool test_plusargs(const Scheduler *scheduler, std::string_view prefix);
+
 int32_t fopen(std::string_view filename, std::string_view mode);
 template <typename T>
 int32_t fopen(std::string_view filename, T mode) requires(!std::is_same<const char *, T>::value) {
@@ -117,6 +122,42 @@ int32_t fopen(std::string_view filename, T mode) requires(!std::is_same<const ch
 
 void fclose(int32_t fd);
 
+// waveform dumping. see LRM 21.7
+void dumpfile(Scheduler *scheduler, std::string_view filename);
+template <typename T>
+void dumpfile(Scheduler *scheduler, T filename) requires(!std::is_same<const char *, T>::value) {
+    auto filename_str = filename.str("%s");
+    dumpfile(scheduler, filename_str);
+}
+
+// nullptr scope is the top instance
+void dumpvars_(Scheduler *scheduler, uint64_t levels, Module *scope, std::string_view scope_name);
+[[maybe_unused]] inline void dumpvars(Scheduler *scheduler) {
+    dumpvars_(scheduler, 0, nullptr, {});
+}
+template <typename T>
+void dumpvars(Scheduler *scheduler, T levels, Module *scope = nullptr,
+              std::string_view scope_name = {}) {
+    uint64_t num_levels;
+    if constexpr (std::is_arithmetic_v<T>) {
+        num_levels = levels;
+    } else {
+        num_levels = levels.to_uint64();
+    }
+    dumpvars_(scheduler, num_levels, scope, scope_name);
+}
+
+void dumpon(Scheduler *scheduler);
+void dumpoff(Scheduler *scheduler);
+
+// saves a checkpoint at the end of the current time step. restored with +fsim_restart=<filename>
+void save(Scheduler *scheduler, std::string_view filename);
+template <typename T>
+void save(Scheduler *scheduler, T filename) requires(!std::is_same<const char *, T>::value) {
+    auto filename_str = filename.str("%s");
+    save(scheduler, filename_str);
+}
+
 void fwrite_(int32_t fd, std::string_view str, bool new_line);
 template <typename... Args>
 void fwrite(const Module *module, int32_t fd, std::string_view format, Args... args) {
@@ -7,6 +7,7 @@ namespace fsim::runtime {
 void TrackedVar::reset() {
     should_trigger_negedge = false;
     should_trigger_posedge = false;
+    edged = false;
 }
 
 bool trigger_posedge(const logic::logic<0> &old, const logic::logic<0> &new_) {
@@ -24,22 +25,53 @@ bool trigger_negedge(const logic::logic<0> &old, const logic::logic<0> &new_) {
 void TrackedVar::update_edge_trigger(const logic::logic<0> &old, const logic::logic<0> &new_) {
     should_trigger_posedge = track_edge && trigger_posedge(old, new_);
     should_trigger_negedge = track_edge && trigger_negedge(old, new_);
+    if (edge_control && (should_trigger_posedge || should_trigger_negedge) &&
+        !edged.exchange(true)) {
+        scheduler->add_edged_var(this);
+    }
+}
+
+void add_fanout(TrackedVar *var, SignalStore::FanoutKind kind, Process *process) {
+    var->scheduler = process->scheduler;
+    var->scheduler->signals().add_fanout(var, kind, process);
+}
+
+void TrackedVar::add_comb_process(CombProcess *process) {
+    add_fanout(this, SignalStore::FanoutKind::comb, process);
+}
+
+void TrackedVar::add_posedge_process(FFProcess *process) {
+    add_fanout(this, SignalStore::FanoutKind::posedge, process);
+}
+
+void TrackedVar::add_negedge_process(FFProcess *process) {
+    add_fanout(this, SignalStore::FanoutKind::negedge, process);
 }
 
 void TrackedVar::trigger_process() {
-    for (auto *process : comb_processes) {
-        process->should_trigger = true;
+    if (signal_id == no_signal_id) return;
+    auto &signals = scheduler->signals();
+
+    if (signals.dirty_propagation()) {
+        // comb processes are triggered once per delta cycle
+        signals.mark_dirty(signal_id);
+    } else {
+        for (auto *process : signals.fanout(signal_id, SignalStore::FanoutKind::comb)) {
+            process->should_trigger.store(true, std::memory_order_relaxed);
+        }
     }
 
     if (should_trigger_posedge) {
-        for (auto *process : ff_posedge_processes) {
-            process->should_trigger = true;
+        for (auto *process : signals.fanout(signal_id, SignalStore::FanoutKind::posedge)) {
+            process->should_trigger.store(true, std::memory_order_relaxed);
+            scheduler->schedule_ff(static_cast<FFProcess *>(process));
         }
     }
 
     if (should_trigger_negedge) {
-        for (auto *process : ff_negedge_processes) {
-            process->should_trigger = true;
+        for (auto *process : signals.fanout(signal_id, SignalStore::FanoutKind::negedge)) {
+            process->should_trigger.store(true, std::memory_order_relaxed);
+            scheduler->schedule_ff(static_cast<FFProcess *>(process));
         }
     }
 }
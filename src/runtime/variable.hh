@@ -1,14 +1,19 @@
 #ifndef FSIM_VARIABLE_HH
 #define FSIM_VARIABLE_HH
 
+#include <atomic>
+#include <limits>
 #include <mutex>
 
+#include "dump.hh"
 #include "logic/logic.hh"
+#include "native.hh"
 
 namespace fsim::runtime {
 struct CombProcess;
 struct FFProcess;
 struct Process;
+class Scheduler;
 
 bool trigger_posedge(const logic::logic<0> &old, const logic::logic<0> &new_);
 bool trigger_negedge(const logic::logic<0> &old, const logic::logic<0> &new_);
@@ -18,10 +23,26 @@ public:
     bool track_edge = false;
     bool should_trigger_posedge = false;
     bool should_trigger_negedge = false;
+    // set when edge events on this variable are tracked by the scheduler
+    bool edge_control = false;
+    // set when the variable is in the scheduler's edged list
+    std::atomic<bool> edged = false;
 
-    std::vector<CombProcess *> comb_processes;
-    std::vector<FFProcess *> ff_posedge_processes;
-    std::vector<FFProcess *> ff_negedge_processes;
+    // index into the scheduler's signal store, where the fanout processes are kept
+    static constexpr uint32_t no_signal_id = std::numeric_limits<uint32_t>::max();
+    uint32_t signal_id = no_signal_id;
+
+    Scheduler *scheduler = nullptr;
+    TrackedVar *next_edged = nullptr;
+
+    // set when the variable is dumped into a waveform
+    Dumper *dumper = nullptr;
+    uint32_t dump_id = 0;
+
+    // only allowed during elaboration
+    void add_comb_process(CombProcess *process);
+    void add_posedge_process(FFProcess *process);
+    void add_negedge_process(FFProcess *process);
 
     // no copy constructor
     TrackedVar(const TrackedVar &) = delete;
@@ -39,6 +60,7 @@ protected:
 template <int msb = 0, int lsb = 0, bool signed_ = false>
 class logic_t : public logic::logic<msb, lsb, signed_>, public TrackedVar {
 public:
+    using value_type = logic::logic<msb, lsb, signed_>;
     // t for tracking
     static auto constexpr size = logic::util::abs_diff(msb, lsb) + 1;
     // we intentionally hide the underling assign operator function
@@ -86,6 +108,9 @@ public:
             }
             logic::logic<msb, lsb, signed_>::operator=(v);
             trigger_process();
+            if (dumper) [[unlikely]] {
+                dumper->capture(dump_id, static_cast<const value_type &>(*this));
+            }
         }
     }
 };
@@ -93,6 +118,7 @@ public:
 template <int msb = 0, int lsb = 0, bool signed_ = false>
 class bit_t : public logic::bit<msb, lsb, signed_>, public TrackedVar {
 public:
+    using value_type = logic::bit<msb, lsb, signed_>;
     // t for tracking
     static auto constexpr size = logic::util::abs_diff(msb, lsb) + 1;
     // we intentionally hide the underling assign operator function
@@ -124,15 +150,37 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed_>
     void update_value(const logic::bit<op_msb, op_lsb, op_signed_> &v) {
-        if (!this->match(v)) {
-            // dealing with edge triggering events
-            if constexpr (size == 1) {
-                // only allowed for size 1 signals
-                auto const new_v = v[logic::util::min(op_msb, op_lsb)];
-                update_edge_trigger(*this, new_v);
+        value_type new_value;
+        new_value = v;
+        if (!changed(new_value)) return;
+        // dealing with edge triggering events
+        if constexpr (size == 1) {
+            // only allowed for size 1 signals
+            auto const new_v = v[logic::util::min(op_msb, op_lsb)];
+            update_edge_trigger(*this, new_v);
+        }
+        logic::bit<msb, lsb, signed_>::operator=(new_value);
+        trigger_process();
+        if (dumper) [[unlikely]] {
+            dumper->capture(dump_id, static_cast<const value_type &>(*this));
+        }
+    }
+
+private:
+    // 2-state values don't have x/z bits, so the words of the old and new values are compared
+    // directly instead of going through the logic library
+    [[nodiscard]] bool changed(const value_type &new_value) const {
+        auto const &old_value = static_cast<const value_type &>(*this);
+        if constexpr (size <= 64) {
+            return (native::value(old_value, size) ^ native::value(new_value, size)) != 0;
+        } else {
+            auto old_words = native::wide_value<size>(old_value);
+            auto new_words = native::wide_value<size>(new_value);
+            uint64_t diff = 0;
+            for (auto i = 0u; i < old_words.words.size(); i++) {
+                diff |= old_words.words[i] ^ new_words.words[i];
             }
-            logic::bit<msb, lsb, signed_>::operator=(v);
-            trigger_process();
+            return diff != 0;
         }
     }
 };
@@ -0,0 +1,411 @@
+#include "wave.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace fsim::runtime {
+
+constexpr std::string_view header_magic = "FSIMWAVE";
+constexpr std::string_view footer_magic = "FSIMWIDX";
+constexpr uint32_t wave_version = 1;
+
+void put_u64(std::string &buffer, uint64_t value) {
+    for (auto i = 0u; i < 8; i++) {
+        buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+void put_varint(std::string &buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+void put_string(std::string &buffer, std::string_view str) {
+    put_varint(buffer, str.size());
+    buffer.append(str);
+}
+
+// reads from a buffer that has been loaded from the file
+class ByteReader {
+public:
+    explicit ByteReader(std::string_view data) : data_(data) {}
+
+    uint8_t u8() {
+        check(1);
+        return static_cast<uint8_t>(data_[pos_++]);
+    }
+
+    uint64_t u64() {
+        uint64_t value = 0;
+        for (auto i = 0u; i < 8; i++) {
+            value |= static_cast<uint64_t>(u8()) << (i * 8);
+        }
+        return value;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (uint64_t shift = 0; shift < 64; shift += 7) {
+            auto byte = u8();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Invalid varint in waveform");
+    }
+
+    std::string_view bytes(uint64_t size) {
+        check(size);
+        auto result = data_.substr(pos_, size);
+        pos_ += size;
+        return result;
+    }
+
+    [[nodiscard]] uint64_t pos() const { return pos_; }
+
+private:
+    std::string_view data_;
+    uint64_t pos_ = 0;
+
+    void check(uint64_t size) const {
+        if (pos_ + size > data_.size()) throw std::runtime_error("Truncated waveform");
+    }
+};
+
+// pads or truncates the value to the width, following the VCD extension rule
+std::string normalize_value(std::string_view value, uint64_t width) {
+    if (value.size() >= width) return std::string(value.substr(value.size() - width));
+    auto fill = value.empty() ? 'x' : value[0];
+    if (fill != 'x' && fill != 'z') fill = '0';
+    return std::string(width - value.size(), fill) + std::string(value);
+}
+
+bool is_four_state(std::string_view value) {
+    return std::any_of(value.begin(), value.end(), [](auto c) { return c != '0' && c != '1'; });
+}
+
+uint64_t packed_size(uint64_t width, bool four_state) {
+    return (width * (four_state ? 2 : 1) + 7) / 8;
+}
+
+void pack_value(std::string &buffer, std::string_view value, bool four_state) {
+    auto width = value.size();
+    auto bits = four_state ? 2u : 1u;
+    auto start = buffer.size();
+    buffer.resize(start + packed_size(width, four_state), 0);
+    for (uint64_t i = 0; i < width; i++) {
+        // bit 0 is the last character
+        auto c = value[width - i - 1];
+        uint8_t code = c == '0' ? 0 : c == '1' ? 1 : (c == 'z' || c == 'Z') ? 3 : 2;
+        auto pos = i * bits;
+        buffer[start + pos / 8] = static_cast<char>(buffer[start + pos / 8] | (code << (pos % 8)));
+    }
+}
+
+std::string unpack_value(std::string_view data, uint64_t width, bool four_state) {
+    constexpr char chars[] = {'0', '1', 'x', 'z'};
+    auto bits = four_state ? 2u : 1u;
+    std::string result(width, '0');
+    for (uint64_t i = 0; i < width; i++) {
+        auto pos = i * bits;
+        auto code = (static_cast<uint8_t>(data[pos / 8]) >> (pos % 8)) & (four_state ? 3 : 1);
+        result[width - i - 1] = chars[code];
+    }
+    return result;
+}
+
+CompactWaveWriter::CompactWaveWriter(const std::string &filename, uint64_t block_size)
+    : stream_(filename, std::ios::out | std::ios::trunc | std::ios::binary),
+      block_size_(block_size) {}
+
+void CompactWaveWriter::write_header(const std::vector<DumpVar> &vars, uint64_t time,
+                                     const std::vector<std::string> &values) {
+    std::string signals;
+    put_varint(signals, vars.size());
+    for (auto i = 0u; i < vars.size(); i++) {
+        auto const &var = vars[i];
+        put_string(signals, var.scope);
+        put_string(signals, var.name);
+        put_varint(signals, var.width);
+        widths_.emplace_back(var.width);
+        frame_.emplace_back(normalize_value(values[i], var.width));
+    }
+    std::string buffer(header_magic);
+    for (auto i = 0u; i < 4; i++) {
+        buffer.push_back(static_cast<char>((wave_version >> (i * 8)) & 0xFF));
+    }
+    put_u64(buffer, signals.size());
+    buffer.append(signals);
+    stream_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    values_ = frame_;
+    changes_.resize(vars.size());
+    block_start_ = time;
+    block_end_ = time;
+}
+
+void CompactWaveWriter::write_change(uint64_t time, uint32_t id, std::string_view value) {
+    // the first block starts with the initial values
+    if (num_changes_ == 0 && !index_.empty()) block_start_ = time;
+    auto normalized = normalize_value(value, widths_[id]);
+    values_[id] = normalized;
+    changes_[id].emplace_back(time, std::move(normalized));
+    num_changes_++;
+}
+
+void CompactWaveWriter::end_time_step(uint64_t time) {
+    block_end_ = time;
+    // blocks always hold whole time steps
+    if (num_changes_ >= block_size_) flush_block();
+}
+
+void CompactWaveWriter::write_dump_off(uint64_t time) {
+    for (auto i = 0u; i < widths_.size(); i++) {
+        write_change(time, i, "x");
+    }
+}
+
+void CompactWaveWriter::write_dump_on(uint64_t time, const std::vector<std::string> &values) {
+    for (auto i = 0u; i < values.size(); i++) {
+        write_change(time, i, values[i]);
+    }
+}
+
+void CompactWaveWriter::close() {
+    if (!stream_.is_open()) return;
+    // the first block holds the initial values even without any change
+    if (num_changes_ > 0 || index_.empty()) flush_block();
+
+    std::string buffer;
+    auto index_offset = static_cast<uint64_t>(stream_.tellp());
+    put_varint(buffer, index_.size());
+    for (auto const &block : index_) {
+        put_u64(buffer, block.start);
+        put_u64(buffer, block.end);
+        put_u64(buffer, block.offset);
+    }
+    put_u64(buffer, index_offset);
+    buffer.append(footer_magic);
+    stream_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    stream_.close();
+}
+
+void CompactWaveWriter::flush_block() {
+    std::string frame, table, data;
+    for (auto const &value : frame_) {
+        auto four_state = is_four_state(value);
+        frame.push_back(static_cast<char>(four_state));
+        pack_value(frame, value, four_state);
+    }
+
+    for (auto id = 0u; id < changes_.size(); id++) {
+        auto const &changes = changes_[id];
+        if (changes.empty()) continue;
+        put_varint(table, id);
+        put_varint(table, data.size());
+        put_varint(table, changes.size());
+
+        auto four_state = std::any_of(changes.begin(), changes.end(),
+                                      [](auto const &c) { return is_four_state(c.second); });
+        data.push_back(static_cast<char>(four_state));
+        auto time = block_start_;
+        for (auto const &[t, value] : changes) {
+            put_varint(data, t - time);
+            time = t;
+            pack_value(data, value, four_state);
+        }
+    }
+
+    std::string buffer;
+    put_u64(buffer, block_start_);
+    put_u64(buffer, block_end_);
+    put_u64(buffer, frame.size());
+    put_u64(buffer, table.size());
+    put_u64(buffer, data.size());
+    buffer.append(frame);
+    buffer.append(table);
+    buffer.append(data);
+
+    index_.emplace_back(
+        BlockIndex{block_start_, block_end_, static_cast<uint64_t>(stream_.tellp())});
+    stream_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    frame_ = values_;
+    for (auto &changes : changes_) {
+        changes.clear();
+    }
+    num_changes_ = 0;
+}
+
+std::string read_file_range(std::ifstream &stream, uint64_t offset, uint64_t size) {
+    std::string buffer(size, '\0');
+    stream.clear();
+    stream.seekg(static_cast<std::streamoff>(offset));
+    stream.read(buffer.data(), static_cast<std::streamsize>(size));
+    if (static_cast<uint64_t>(stream.gcount()) != size) {
+        throw std::runtime_error("Truncated waveform");
+    }
+    return buffer;
+}
+
+WaveReader::WaveReader(const std::string &filename)
+    : stream_(filename, std::ios::in | std::ios::binary) {
+    if (!stream_) {
+        throw std::runtime_error(fmt::format("Unable to open {0}", filename));
+    }
+    stream_.seekg(0, std::ios::end);
+    auto file_size = static_cast<uint64_t>(stream_.tellg());
+    auto footer_size = 8 + footer_magic.size();
+    if (file_size < header_magic.size() + footer_size) {
+        throw std::runtime_error(fmt::format("{0} is not a valid waveform", filename));
+    }
+
+    auto footer = read_file_range(stream_, file_size - footer_size, footer_size);
+    ByteReader footer_reader(footer);
+    auto index_offset = footer_reader.u64();
+    if (footer_reader.bytes(footer_magic.size()) != footer_magic || index_offset > file_size) {
+        throw std::runtime_error(fmt::format("{0} is not a valid waveform", filename));
+    }
+
+    auto magic_size = header_magic.size() + 4 + 8;
+    auto magic = read_file_range(stream_, 0, magic_size);
+    ByteReader magic_reader(magic);
+    if (magic_reader.bytes(header_magic.size()) != header_magic) {
+        throw std::runtime_error(fmt::format("{0} is not a valid waveform", filename));
+    }
+    magic_reader.bytes(4);
+    auto header = read_file_range(stream_, magic_size, magic_reader.u64());
+    ByteReader header_reader(header);
+    auto num_signals = header_reader.varint();
+    for (uint64_t i = 0; i < num_signals; i++) {
+        Signal signal;
+        signal.scope = header_reader.bytes(header_reader.varint());
+        signal.name = header_reader.bytes(header_reader.varint());
+        signal.width = header_reader.varint();
+        signals_.emplace_back(std::move(signal));
+    }
+
+    auto index = read_file_range(stream_, index_offset, file_size - footer_size - index_offset);
+    ByteReader index_reader(index);
+    auto num_blocks = index_reader.varint();
+    for (uint64_t i = 0; i < num_blocks; i++) {
+        Block block{};
+        block.start = index_reader.u64();
+        block.end = index_reader.u64();
+        block.offset = index_reader.u64();
+        blocks_.emplace_back(block);
+    }
+}
+
+std::optional<uint32_t> WaveReader::find(std::string_view name) const {
+    for (auto i = 0u; i < signals_.size(); i++) {
+        auto const &signal = signals_[i];
+        auto const &scope = signal.scope;
+        if (name.size() == scope.size() + 1 + signal.name.size() && name.starts_with(scope) &&
+            name[scope.size()] == '.' && name.ends_with(signal.name)) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+uint64_t WaveReader::end_time() const { return blocks_.empty() ? 0 : blocks_.back().end; }
+
+std::vector<std::pair<uint64_t, std::string>> WaveReader::read(uint32_t id, uint64_t start,
+                                                                uint64_t end) {
+    std::vector<std::pair<uint64_t, std::string>> result;
+    if (id >= signals_.size() || blocks_.empty()) return result;
+    // the last block that starts no later than the window
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), start,
+                               [](uint64_t time, auto const &block) { return time < block.start; });
+    if (it != blocks_.begin()) it--;
+
+    auto first = true;
+    std::string value;
+    for (; it != blocks_.end() && (first || it->start <= end); it++) {
+        auto [frame, changes] = read_block(*it, id);
+        if (first) {
+            value = std::move(frame);
+            first = false;
+        }
+        for (auto &[time, v] : changes) {
+            if (time <= start) {
+                value = std::move(v);
+                continue;
+            }
+            if (time > end) break;
+            if (result.empty()) result.emplace_back(start, value);
+            // $dumpoff can change a value twice in the same time step
+            if (result.back().first == time) {
+                result.back().second = std::move(v);
+            } else {
+                result.emplace_back(time, std::move(v));
+            }
+        }
+    }
+    if (result.empty()) result.emplace_back(start, value);
+    return result;
+}
+
+std::string WaveReader::value_at(uint32_t id, uint64_t time) {
+    auto values = read(id, time, time);
+    return values.empty() ? std::string() : values.front().second;
+}
+
+std::pair<std::string, std::vector<std::pair<uint64_t, std::string>>> WaveReader::read_block(
+    const Block &block, uint32_t id) {
+    auto sizes = read_file_range(stream_, block.offset, 5 * 8);
+    ByteReader sizes_reader(sizes);
+    sizes_reader.bytes(16);
+    auto frame_size = sizes_reader.u64();
+    auto table_size = sizes_reader.u64();
+    auto data_size = sizes_reader.u64();
+    auto frame_offset = block.offset + sizes.size();
+    auto data_offset = frame_offset + frame_size + table_size;
+
+    // values are packed, so the frame has to be walked to find the signal
+    auto const &signal = signals_[id];
+    auto frame = read_file_range(stream_, frame_offset, frame_size + table_size);
+    ByteReader frame_reader(frame);
+    std::string value;
+    for (uint32_t i = 0; i <= id; i++) {
+        auto four_state = frame_reader.u8() != 0;
+        auto data = frame_reader.bytes(packed_size(signals_[i].width, four_state));
+        if (i == id) value = unpack_value(data, signal.width, four_state);
+    }
+
+    ByteReader table_reader(std::string_view(frame).substr(frame_size));
+    std::optional<std::pair<uint64_t, uint64_t>> entry;
+    while (table_reader.pos() < table_size) {
+        auto signal_id = table_reader.varint();
+        auto offset = table_reader.varint();
+        auto count = table_reader.varint();
+        if (signal_id == id) {
+            entry = std::make_pair(offset, count);
+            break;
+        }
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> changes;
+    if (entry) {
+        auto [offset, count] = *entry;
+        auto max_size = count * (10 + packed_size(signal.width, true)) + 1;
+        auto data = read_file_range(stream_, data_offset + offset,
+                                    std::min(max_size, data_size - offset));
+        ByteReader data_reader(data);
+        auto four_state = data_reader.u8() != 0;
+        auto time = block.start;
+        for (uint64_t i = 0; i < count; i++) {
+            time += data_reader.varint();
+            auto packed = data_reader.bytes(packed_size(signal.width, four_state));
+            changes.emplace_back(time, unpack_value(packed, signal.width, four_state));
+        }
+    }
+    return {value, changes};
+}
+
+}  // namespace fsim::runtime
@@ -0,0 +1,108 @@
+#ifndef FSIM_WAVE_HH
+#define FSIM_WAVE_HH
+
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "dump.hh"
+
+// compact waveform format (.fwv). value changes are grouped into blocks of whole time steps. every
+// block starts with a frame holding the value of each signal at the block start, followed by a
+// table with the offset of each signal's changes. a block index at the end of the file maps time to
+// blocks, so readers can seek to a time window and decode a single signal without touching the
+// rest of the file. values are bit-packed, 1 bit per bit for 2-state values and 2 bits otherwise,
+// and time is delta encoded as varints.
+//
+// layout. fixed size integers are little endian and varints are unsigned LEB128
+//   header: "FSIMWAVE", u32 version, u64 size of the signal table, then the signal table:
+//           varint #signals, per signal: varint length + scope, varint length + name, varint width
+//   block:  u64 start time, u64 end time, u64 frame size, u64 table size, u64 data size, then
+//   frame:  per signal: u8 4-state flag, packed value
+//   table:  per signal with changes: varint id, varint data offset, varint #changes
+//   data:   per signal with changes: u8 4-state flag, then per change: varint time delta from the
+//           previous change or the block start, packed value
+//   index:  varint #blocks, then per block: u64 start time, u64 end time, u64 file offset
+//   footer: u64 index offset, "FSIMWIDX"
+namespace fsim::runtime {
+
+class CompactWaveWriter : public WaveformWriter {
+public:
+    // a block is written once it has this many changes
+    static constexpr uint64_t default_block_size = 1u << 16;
+
+    explicit CompactWaveWriter(const std::string &filename,
+                               uint64_t block_size = default_block_size);
+
+    void write_header(const std::vector<DumpVar> &vars, uint64_t time,
+                      const std::vector<std::string> &values) override;
+    void write_change(uint64_t time, uint32_t id, std::string_view value) override;
+    void end_time_step(uint64_t time) override;
+    void write_dump_off(uint64_t time) override;
+    void write_dump_on(uint64_t time, const std::vector<std::string> &values) override;
+    void close() override;
+
+private:
+    struct BlockIndex {
+        uint64_t start;
+        uint64_t end;
+        uint64_t offset;
+    };
+
+    std::ofstream stream_;
+    uint64_t block_size_;
+    std::vector<uint64_t> widths_;
+    // values at the start of the current block
+    std::vector<std::string> frame_;
+    std::vector<std::string> values_;
+    std::vector<std::vector<std::pair<uint64_t, std::string>>> changes_;
+    uint64_t num_changes_ = 0;
+    uint64_t block_start_ = 0;
+    uint64_t block_end_ = 0;
+    std::vector<BlockIndex> index_;
+
+    void flush_block();
+};
+
+class WaveReader {
+public:
+    struct Signal {
+        std::string scope;
+        std::string name;
+        uint64_t width;
+    };
+
+    // throws std::runtime_error if the file is not a valid waveform
+    explicit WaveReader(const std::string &filename);
+
+    [[nodiscard]] const std::vector<Signal> &signals() const { return signals_; }
+    // hierarchical name, e.g. top.inst.a
+    [[nodiscard]] std::optional<uint32_t> find(std::string_view name) const;
+    [[nodiscard]] uint64_t end_time() const;
+
+    // the value at start followed by every change up to end
+    std::vector<std::pair<uint64_t, std::string>> read(uint32_t id, uint64_t start, uint64_t end);
+    std::string value_at(uint32_t id, uint64_t time);
+
+private:
+    struct Block {
+        uint64_t start;
+        uint64_t end;
+        uint64_t offset;
+    };
+
+    std::ifstream stream_;
+    std::vector<Signal> signals_;
+    std::vector<Block> blocks_;
+
+    // the signal value at the block start and its changes in the block
+    std::pair<std::string, std::vector<std::pair<uint64_t, std::string>>> read_block(
+        const Block &block, uint32_t id);
+};
+
+}  // namespace fsim::runtime
+
+#endif  // FSIM_WAVE_HH
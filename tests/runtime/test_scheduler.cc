@@ -1,3 +1,8 @@
+#include <filesystem>
+#include <fstream>
+
+#include "../../src/runtime/batch.hh"
+#include "../../src/runtime/checkpoint.hh"
 #include "../../src/runtime/macro.hh"
 #include "../../src/runtime/module.hh"
 #include "../../src/runtime/scheduler.hh"
@@ -181,7 +186,7 @@ public:
             END_PROCESS(always);
         };
         comb_processes_.emplace_back(always);
-        a.comb_processes.emplace_back(always);
+        a.add_comb_process(always);
     }
 };
 
@@ -257,8 +262,8 @@ public:
             END_PROCESS(always);
         };
         comb_processes_.emplace_back(always);
-        a.comb_processes.emplace_back(always);
-        b.comb_processes.emplace_back(always);
+        a.add_comb_process(always);
+        b.add_comb_process(always);
     }
 };
 
@@ -304,7 +309,7 @@ public:
 
         ff_process_.emplace_back(process);
         clk.track_edge = true;
-        clk.ff_posedge_processes.emplace_back(process);
+        clk.add_posedge_process(process);
     }
 
     void comb(Scheduler *scheduler) override {
@@ -314,7 +319,7 @@ public:
             END_PROCESS(always);
         };
         comb_processes_.emplace_back(always);
-        a.comb_processes.emplace_back(always);
+        a.add_comb_process(always);
     }
 
     void init(Scheduler *scheduler) override {
@@ -380,7 +385,7 @@ public:
 
         ff_process_.emplace_back(process);
         clk.track_edge = true;
-        clk.ff_posedge_processes.emplace_back(process);
+        clk.add_posedge_process(process);
     }
 
     void comb(Scheduler *scheduler) override {
@@ -390,7 +395,7 @@ public:
             END_PROCESS(always);
         };
         comb_processes_.emplace_back(always);
-        a.comb_processes.emplace_back(always);
+        a.add_comb_process(always);
     }
 
     void init(Scheduler *scheduler) override {
@@ -421,6 +426,213 @@ TEST(runtime, ff_nba) {  // NOLINT
     }
 }
 
+class FFReadyList : public Module {
+public:
+    FFReadyList() : Module("ff_ready_list") {}
+    /*
+     * module ff_ready_list;
+     * logic clk_a, clk_b;
+     * logic[3:0] a, b, c;
+     * always_ff @(posedge clk_a) a = a + 1;
+     * always_ff @(negedge clk_a) b = b + 1;
+     * always_ff @(posedge clk_b) c = c + 1;
+     * endmodule
+     */
+    logic_t<0> clk_a, clk_b;
+    logic_t<3, 0> a, b, c;
+
+    void ff(Scheduler *scheduler) override {
+        auto *pa = scheduler->create_ff_process();
+        pa->func = [this, pa]() {
+            a = a + 1_logic;
+            END_PROCESS(pa);
+        };
+        clk_a.add_posedge_process(pa);
+
+        auto *pb = scheduler->create_ff_process();
+        pb->func = [this, pb]() {
+            b = b + 1_logic;
+            END_PROCESS(pb);
+        };
+        clk_a.add_negedge_process(pb);
+
+        auto *pc = scheduler->create_ff_process();
+        pc->func = [this, pc]() {
+            c = c + 1_logic;
+            END_PROCESS(pc);
+        };
+        clk_b.add_posedge_process(pc);
+
+        for (auto *p : {pa, pb, pc}) {
+            ff_process_.emplace_back(p);
+        }
+        clk_a.track_edge = true;
+        clk_b.track_edge = true;
+    }
+
+    void init(Scheduler *scheduler) override {
+        auto init_ptr = scheduler->create_init_process();
+        init_ptr->func = [init_ptr, scheduler, this]() {
+            a = 0_logic;
+            b = 0_logic;
+            c = 0_logic;
+            clk_a = 0_logic;
+            clk_b = 0_logic;
+            SCHEDULE_DELAY(init_ptr, 1, scheduler, n);
+            clk_a = 1_logic;
+            SCHEDULE_DELAY(init_ptr, 1, scheduler, n);
+            clk_a = 0_logic;
+            SCHEDULE_DELAY(init_ptr, 1, scheduler, n);
+            clk_a = 1_logic;
+            SCHEDULE_DELAY(init_ptr, 1, scheduler, n);
+            display(this, "a=%0d b=%0d c=%0d", a, b, c);
+
+            END_PROCESS(init_ptr);
+        };
+        Scheduler::schedule_init(init_ptr);
+        init_processes_.emplace_back(init_ptr);
+    }
+};
+
+TEST(runtime, ff_ready_list) {  // NOLINT
+    Scheduler scheduler;
+    FFReadyList m;
+    testing::internal::CaptureStdout();
+    scheduler.run(&m);
+    std::string output = testing::internal::GetCapturedStdout();
+    // only processes on the edges are triggered. x -> 0 is a negedge
+    EXPECT_NE(output.find("a=2 b=2 c=0\n"), std::string::npos);
+}
+
+class FFParallelNBA : public Module {
+public:
+    FFParallelNBA() : Module("ff_parallel_nba") {}
+    /*
+     * module ff_parallel_nba;
+     * logic clk;
+     * logic[15:0] a[300];
+     * always_ff @(posedge clk)
+     *     for (int i = 0; i < 300; i++) a[i] <= i;
+     * always_ff @(posedge clk)
+     *     a[0] <= 1000;
+     * endmodule
+     */
+    logic_t<0> clk;
+    std::array<logic_t<15, 0>, 300> a;
+
+    void ff(Scheduler *scheduler) override {
+        auto *loop = scheduler->create_ff_process();
+        loop->func = [this, loop]() {
+            for (auto i = 0u; i < a.size(); i++) {
+                loop->schedule_nba(&a[i], [this, i]() { a[i] = logic::logic<15, 0>(i); });
+            }
+            END_PROCESS(loop);
+        };
+        auto *single = scheduler->create_ff_process();
+        single->func = [this, single]() {
+            SCHEDULE_NBA(a[0], (logic::logic<15, 0>(1000)), single);
+            END_PROCESS(single);
+        };
+
+        for (auto *p : {loop, single}) {
+            ff_process_.emplace_back(p);
+            clk.add_posedge_process(p);
+        }
+        clk.track_edge = true;
+    }
+
+    void init(Scheduler *scheduler) override {
+        auto init_ptr = scheduler->create_init_process();
+        init_ptr->func = [init_ptr, scheduler, this]() {
+            clk = 0_logic;
+            SCHEDULE_DELAY(init_ptr, 2, scheduler, n);
+            clk = 1_logic;
+            SCHEDULE_DELAY(init_ptr, 2, scheduler, n);
+            display(this, "a[0]=%0d a[299]=%0d", a[0], a[299]);
+
+            END_PROCESS(init_ptr);
+        };
+        Scheduler::schedule_init(init_ptr);
+        init_processes_.emplace_back(init_ptr);
+    }
+};
+
+TEST(runtime, ff_parallel_nba) {  // NOLINT
+    for (auto i = 0; i < 10; i++) {
+        Scheduler scheduler;
+        FFParallelNBA m;
+        testing::internal::CaptureStdout();
+        scheduler.run(&m);
+        std::string output = testing::internal::GetCapturedStdout();
+        // the process created later wins
+        EXPECT_NE(output.find("a[0]=1000 a[299]=299\n"), std::string::npos);
+    }
+}
+
+class FFStackless : public Module {
+public:
+    FFStackless() : Module("ff_stackless") {}
+    /*
+     * module ff_stackless;
+     * logic clk;
+     * logic[3:0] a, b;
+     * always_ff @(posedge clk) a <= a + 1;
+     * always_ff @(posedge clk) begin
+     *     #1 b = a;
+     * end
+     * endmodule
+     */
+    logic_t<0> clk;
+    logic_t<3, 0> a, b;
+
+    void ff(Scheduler *scheduler) override {
+        auto *pa = scheduler->create_ff_process();
+        pa->stackless = true;
+        pa->func = [this, pa]() { SCHEDULE_NBA(a, a + 1_logic, pa); };
+
+        auto *pb = scheduler->create_ff_process();
+        pb->func = [this, pb, scheduler]() {
+            SCHEDULE_DELAY(pb, 1, scheduler, n);
+            b = a;
+            END_PROCESS(pb);
+        };
+
+        for (auto *p : {pa, pb}) {
+            ff_process_.emplace_back(p);
+            clk.add_posedge_process(p);
+        }
+        clk.track_edge = true;
+    }
+
+    void init(Scheduler *scheduler) override {
+        auto init_ptr = scheduler->create_init_process();
+        init_ptr->func = [init_ptr, scheduler, this]() {
+            a = 0_logic;
+            clk = 0_logic;
+            for (auto i = 0; i < 3; i++) {
+                SCHEDULE_DELAY(init_ptr, 2, scheduler, n);
+                clk = 1_logic;
+                SCHEDULE_DELAY(init_ptr, 2, scheduler, n);
+                clk = 0_logic;
+            }
+            display(this, "a=%0d b=%0d", a, b);
+
+            END_PROCESS(init_ptr);
+        };
+        Scheduler::schedule_init(init_ptr);
+        init_processes_.emplace_back(init_ptr);
+    }
+};
+
+TEST(runtime, ff_stackless) {  // NOLINT
+    Scheduler scheduler;
+    FFStackless m;
+    testing::internal::CaptureStdout();
+    scheduler.run(&m);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("a=3 b=3\n"), std::string::npos);
+}
+
 class ChildInstanceTest : public Module {
 public:
     ChildInstanceTest() : Module("child") {}
@@ -443,7 +655,7 @@ public:
 
         ff_process_.emplace_back(process);
         clk.track_edge = true;
-        clk.ff_posedge_processes.emplace_back(process);
+        clk.add_posedge_process(process);
     }
 };
 
@@ -483,7 +695,7 @@ public:
             };
 
             comb_processes_.emplace_back(always);
-            out.comb_processes.emplace_back(always);
+            out.add_comb_process(always);
         }
 
         // a comb process for child instance input
@@ -495,8 +707,8 @@ public:
                 END_PROCESS(always);
             };
             comb_processes_.emplace_back(always);
-            in.comb_processes.emplace_back(always);
-            clk.comb_processes.emplace_back(always);
+            in.add_comb_process(always);
+            clk.add_comb_process(always);
         }
 
         // a comb process for child instance output
@@ -507,7 +719,7 @@ public:
                 END_PROCESS(always);
             };
             comb_processes_.emplace_back(always);
-            this->inst->out.comb_processes.emplace_back(always);
+            this->inst->out.add_comb_process(always);
         }
 
         Module::comb(scheduler);
@@ -577,7 +789,7 @@ public:
                 END_PROCESS(always);
             };
             comb_processes_.emplace_back(always);
-            clk.comb_processes.emplace_back(always);
+            clk.add_comb_process(always);
         }
     }
 
@@ -750,8 +962,7 @@ public:
             clk.track_edge = true;
             Scheduler::schedule_init(init_ptr);
             init_processes_.emplace_back(init_ptr);
-            scheduler->add_tracked_var(&clk);
-            scheduler->add_process_edge_control(init_ptr);
+            scheduler->add_process_edge_control(init_ptr, &clk);
         }
     }
 };
@@ -883,4 +1094,318 @@ TEST(runtime, fork_join_none) {  // NOLINT
                               "4: a = 1"),
                   std::string::npos);
     }
-}
\ No newline at end of file
+}
+
+TEST(runtime, timing_wheel) {  // NOLINT
+    TimingWheel wheel;
+    std::array<InitialProcess, 7> processes;
+    std::vector<Process *> events;
+
+    wheel.schedule(1, &processes[0]);
+    wheel.schedule(1, &processes[1]);
+    wheel.schedule(5, &processes[2]);
+    wheel.schedule(300, &processes[3]);
+    wheel.schedule(70000, &processes[4]);
+    // beyond the wheel
+    wheel.schedule((1ull << 40) + 3, &processes[5]);
+    EXPECT_FALSE(wheel.empty());
+
+    auto time = wheel.next(events);
+    EXPECT_EQ(*time, 1);
+    EXPECT_EQ(events.size(), 2);
+    events.clear();
+    time = wheel.next(events);
+    EXPECT_EQ(*time, 5);
+    EXPECT_EQ(events.size(), 1);
+    EXPECT_EQ(events[0], &processes[2]);
+    events.clear();
+    // zero delay goes into the current time slot
+    wheel.schedule(5, &processes[6]);
+    time = wheel.next(events);
+    EXPECT_EQ(*time, 5);
+    EXPECT_EQ(events[0], &processes[6]);
+    events.clear();
+    time = wheel.next(events);
+    EXPECT_EQ(*time, 300);
+    EXPECT_EQ(events[0], &processes[3]);
+    events.clear();
+    time = wheel.next(events);
+    EXPECT_EQ(*time, 70000);
+    EXPECT_EQ(events[0], &processes[4]);
+    events.clear();
+    time = wheel.next(events);
+    EXPECT_EQ(*time, (1ull << 40) + 3);
+    EXPECT_EQ(events[0], &processes[5]);
+    events.clear();
+
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_FALSE(wheel.next(events));
+}
+
+TEST(runtime, nba_arena) {  // NOLINT
+    NBAArena arena;
+    auto *a = arena.allocate(sizeof(uint64_t), alignof(uint64_t));
+    auto *b = arena.allocate(1, 1);
+    auto *c = arena.allocate(sizeof(uint64_t), alignof(uint64_t));
+    EXPECT_NE(a, b);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % alignof(uint64_t), 0);
+    // larger than a chunk
+    auto *d = arena.allocate(10000, 8);
+    EXPECT_NE(d, nullptr);
+
+    // memory is reused after reset
+    arena.reset();
+    EXPECT_EQ(arena.allocate(sizeof(uint64_t), alignof(uint64_t)), a);
+}
+
+TEST(runtime, signal_store) {  // NOLINT
+    SignalStore store;
+    logic_t<0> a, b, c;
+    std::array<CombProcess, 3> comb;
+    std::array<FFProcess, 2> ff;
+    store.add_fanout(&a, SignalStore::FanoutKind::comb, &comb[0]);
+    store.add_fanout(&b, SignalStore::FanoutKind::posedge, &ff[0]);
+    store.add_fanout(&a, SignalStore::FanoutKind::negedge, &ff[1]);
+    store.add_fanout(&a, SignalStore::FanoutKind::comb, &comb[1]);
+    store.add_fanout(&b, SignalStore::FanoutKind::comb, &comb[2]);
+    store.finalize();
+
+    // ids are assigned in the order of the first fanout
+    EXPECT_EQ(store.size(), 2);
+    EXPECT_EQ(a.signal_id, 0);
+    EXPECT_EQ(b.signal_id, 1);
+    EXPECT_EQ(c.signal_id, TrackedVar::no_signal_id);
+
+    auto a_comb = store.fanout(a.signal_id, SignalStore::FanoutKind::comb);
+    EXPECT_EQ(a_comb.size(), 2);
+    EXPECT_EQ(a_comb[0], &comb[0]);
+    EXPECT_EQ(a_comb[1], &comb[1]);
+    EXPECT_TRUE(store.fanout(a.signal_id, SignalStore::FanoutKind::posedge).empty());
+    EXPECT_EQ(store.fanout(a.signal_id, SignalStore::FanoutKind::negedge)[0], &ff[1]);
+    EXPECT_EQ(store.fanout(b.signal_id, SignalStore::FanoutKind::posedge)[0], &ff[0]);
+    EXPECT_EQ(store.fanout(b.signal_id, SignalStore::FanoutKind::comb)[0], &comb[2]);
+    EXPECT_TRUE(store.fanout(c.signal_id, SignalStore::FanoutKind::comb).empty());
+}
+
+TEST(runtime, signal_store_dirty) {  // NOLINT
+    Scheduler scheduler;
+    scheduler.set_dirty_propagation(true);
+    logic_t<3, 0> a, b;
+    auto *comb_a = scheduler.create_comb_process();
+    auto *comb_b = scheduler.create_comb_process();
+    a.add_comb_process(comb_a);
+    b.add_comb_process(comb_b);
+    scheduler.signals().finalize();
+
+    // writes only mark the signal
+    a = 1_logic;
+    a = 2_logic;
+    EXPECT_FALSE(comb_a->should_trigger);
+    EXPECT_FALSE(comb_b->should_trigger);
+
+    scheduler.signals().propagate_dirty();
+    EXPECT_TRUE(comb_a->should_trigger);
+    EXPECT_FALSE(comb_b->should_trigger);
+
+    // dirty bits are cleared after propagation
+    comb_a->should_trigger = false;
+    scheduler.signals().propagate_dirty();
+    EXPECT_FALSE(comb_a->should_trigger);
+}
+
+TEST(runtime, signal_store_dirty_two_state) {  // NOLINT
+    Scheduler scheduler;
+    scheduler.set_dirty_propagation(true);
+    bit_t<3, 0> a;
+    bit_t<127, 0> b;
+    auto *comb_a = scheduler.create_comb_process();
+    auto *comb_b = scheduler.create_comb_process();
+    a.add_comb_process(comb_a);
+    b.add_comb_process(comb_b);
+    scheduler.signals().finalize();
+
+    // same value after truncation
+    a = logic::bit<7, 0>(0x10);
+    b = logic::bit<127, 0>(0);
+    scheduler.signals().propagate_dirty();
+    EXPECT_FALSE(comb_a->should_trigger);
+    EXPECT_FALSE(comb_b->should_trigger);
+
+    a = logic::bit<7, 0>(0x12);
+    b = logic::bit<127, 0>(1);
+    scheduler.signals().propagate_dirty();
+    EXPECT_TRUE(comb_a->should_trigger);
+    EXPECT_TRUE(comb_b->should_trigger);
+}
+
+class BatchModule : public Module {
+public:
+    BatchModule() : Module("batch_test") {}
+    void init(Scheduler *scheduler) override {
+        auto init_ptr = scheduler->create_init_process();
+        init_ptr->func = [this, init_ptr, scheduler]() {
+            display(this, "SEED=2 %0d", test_plusargs(scheduler, "SEED=2"));
+            END_PROCESS(init_ptr);
+        };
+        Scheduler::schedule_init(init_ptr);
+        init_processes_.emplace_back(init_ptr);
+    }
+};
+
+TEST(runtime, batch) {  // NOLINT
+    auto dir = std::filesystem::temp_directory_path() / "fsim_batch_test";
+    std::filesystem::create_directories(dir);
+    auto args_filename = dir / "args.txt";
+    {
+        std::ofstream stream(args_filename);
+        stream << "+SEED=1" << std::endl << "+SEED=2" << std::endl;
+    }
+    std::string prog = "fsim.out", num = "+fsim_batch=3";
+    auto args = "+fsim_batch_args=" + args_filename.string();
+    auto log = "+fsim_batch_log=" + (dir / "test").string();
+    std::array<char *, 4> argv = {prog.data(), num.data(), args.data(), log.data()};
+    Batch batch(static_cast<int>(argv.size()), argv.data());
+    EXPECT_TRUE(batch.enabled());
+    EXPECT_EQ(batch.num_instances(), 3);
+    batch.run([]() { return std::make_unique<BatchModule>(); });
+
+    // the last instance does not have any plusargs
+    std::array<std::string_view, 3> expected = {"SEED=2 0\n", "SEED=2 1\n", "SEED=2 0\n"};
+    for (auto i = 0u; i < expected.size(); i++) {
+        std::ifstream stream(batch.log_filename(i));
+        std::stringstream ss;
+        ss << stream.rdbuf();
+        EXPECT_EQ(ss.str(), expected[i]);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+class CheckpointModule : public Module {
+public:
+    explicit CheckpointModule(std::string filename)
+        : Module("checkpoint_test"), filename(std::move(filename)) {}
+    std::string filename;
+    logic::logic<3, 0> a;
+    uint64_t steps = 0;
+    bool started = false;
+
+    void init(Scheduler *scheduler) override {
+        {
+            auto init_ptr = scheduler->create_init_process();
+            init_ptr->func = [init_ptr, this]() {
+                started = true;
+                END_PROCESS(init_ptr);
+            };
+            Scheduler::schedule_init(init_ptr);
+            init_processes_.emplace_back(init_ptr);
+        }
+        {
+            auto init_ptr = scheduler->create_init_process();
+            init_ptr->func = [init_ptr, scheduler, this]() {
+                switch (init_ptr->resume_point) {
+                    case 1:
+                        goto fsim_resume_1;
+                    case 2:
+                        goto fsim_resume_2;
+                    default:
+                        break;
+                }
+                steps++;
+                a = 1_logic;
+            fsim_resume_1:
+                SCHEDULE_RESUMABLE_DELAY(init_ptr, 10, scheduler, n1, 1);
+                steps++;
+                a = 2_logic;
+                save(scheduler, filename);
+            fsim_resume_2:
+                SCHEDULE_RESUMABLE_DELAY(init_ptr, 5, scheduler, n2, 2);
+                steps++;
+                END_PROCESS(init_ptr);
+            };
+            Scheduler::schedule_init(init_ptr);
+            init_processes_.emplace_back(init_ptr);
+        }
+    }
+
+    void checkpoint_vars(Checkpoint *checkpoint) override {
+        checkpoint->add_var(a, "a");
+        checkpoint->add_var(steps, "steps");
+    }
+};
+
+TEST(runtime, checkpoint) {  // NOLINT
+    auto filename = (std::filesystem::temp_directory_path() / "fsim_checkpoint_test").string();
+    {
+        Scheduler scheduler;
+        CheckpointModule m(filename);
+        scheduler.run(&m);
+        EXPECT_EQ(scheduler.sim_time, 15);
+        EXPECT_EQ(m.steps, 3);
+        EXPECT_TRUE(m.started);
+    }
+    {
+        Scheduler scheduler;
+        std::string prog = "fsim.out", restart = "+fsim_restart=" + filename;
+        std::array<char *, 2> argv = {prog.data(), restart.data()};
+        scheduler.set_args(static_cast<int>(argv.size()), argv.data());
+        CheckpointModule m(filename);
+        scheduler.run(&m);
+        // resumes from the second delay with the values at time 10
+        EXPECT_EQ(scheduler.sim_time, 15);
+        EXPECT_EQ(m.steps, 3);
+        EXPECT_EQ(m.a.to_uint64(), 2);
+        EXPECT_FALSE(m.started);
+    }
+    std::filesystem::remove(filename);
+}
+
+class RewindModule : public Module {
+public:
+    RewindModule() : Module("rewind_test") {}
+    uint64_t steps = 0;
+
+    void init(Scheduler *scheduler) override {
+        auto init_ptr = scheduler->create_init_process();
+        init_ptr->func = [init_ptr, scheduler, this]() {
+            steps++;
+            SCHEDULE_DELAY(init_ptr, 10, scheduler, n);
+            steps++;
+            display(this, "%0d %0d", steps, test_plusargs(scheduler, "B"));
+            END_PROCESS(init_ptr);
+        };
+        Scheduler::schedule_init(init_ptr);
+        init_processes_.emplace_back(init_ptr);
+    }
+};
+
+#ifndef _WIN32
+TEST(runtime, rewind) {  // NOLINT
+    auto dir = std::filesystem::temp_directory_path() / "fsim_rewind_test";
+    std::filesystem::create_directories(dir);
+    auto args_filename = dir / "args.txt";
+    {
+        std::ofstream stream(args_filename);
+        stream << "+A" << std::endl << "+B" << std::endl;
+    }
+    std::string prog = "fsim.out", at = "+fsim_fork_at=5";
+    auto args = "+fsim_fork_args=" + args_filename.string();
+    auto log = "+fsim_fork_log=" + (dir / "test").string();
+    std::array<char *, 4> argv = {prog.data(), at.data(), args.data(), log.data()};
+    Scheduler scheduler(static_cast<int>(argv.size()), argv.data());
+    RewindModule m;
+    scheduler.run(&m);
+    // continuations must not run the rest of the tests
+    if (scheduler.continuation()) std::_Exit(m.steps == 2 ? 0 : 1);
+
+    // the process that forks stops at the branch point
+    EXPECT_EQ(scheduler.sim_time, 0);
+    std::array<std::string_view, 2> expected = {"2 0\n", "2 1\n"};
+    for (auto i = 0u; i < expected.size(); i++) {
+        std::ifstream stream(dir / ("test." + std::to_string(i) + ".log"));
+        std::stringstream ss;
+        ss << stream.rdbuf();
+        EXPECT_EQ(ss.str(), expected[i]);
+    }
+    std::filesystem::remove_all(dir);
+}
+#endif
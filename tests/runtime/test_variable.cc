@@ -1,8 +1,13 @@
+#include <fstream>
+
+#include "../../src/runtime/dump.hh"
+#include "../../src/runtime/lanes.hh"
 #include "../../src/runtime/macro.hh"
 #include "../../src/runtime/module.hh"
 #include "../../src/runtime/scheduler.hh"
 #include "../../src/runtime/system_task.hh"
 #include "../../src/runtime/variable.hh"
+#include "../../src/runtime/wave.hh"
 #include "gtest/gtest.h"
 
 using namespace fsim::runtime;
@@ -51,7 +56,7 @@ public:
             END_PROCESS(always);
         };
         comb_processes_.emplace_back(always);
-        a.comb_processes.emplace_back(always);
+        a.add_comb_process(always);
     }
 };
 
@@ -64,4 +69,148 @@ TEST(two_state, tracking) {  // NOLINT
         std::string output = testing::internal::GetCapturedStdout();
         EXPECT_EQ(output, "b is 4\n");
     }
-}
\ No newline at end of file
+}
+
+TEST(lanes, ops) {  // NOLINT
+    using namespace fsim::runtime::lanes;
+    // every lane holds a different value
+    Lanes<8> a, b;
+    Lanes<3> amount;
+    for (uint64_t lane = 0; lane < num_lanes; lane++) {
+        a.set(lane, lane * 3);
+        b.set(lane, 255 - lane);
+        amount.set(lane, lane % 8);
+    }
+    auto sum = add(a, b);
+    auto diff = sub(a, b);
+    auto product = mul(a, b);
+    auto less = slt(a, b);
+    auto shifted = ashr(a, amount);
+    auto bit = select<0>(a, amount);
+    auto wide = concat(slice<4, 4>(a), b);
+    for (uint64_t lane = 0; lane < num_lanes; lane++) {
+        auto x = lane * 3, y = 255 - lane, s = lane % 8;
+        EXPECT_EQ(sum.get(lane), (x + y) & 0xFF);
+        EXPECT_EQ(diff.get(lane), (x - y) & 0xFF);
+        EXPECT_EQ(product.get(lane), (x * y) & 0xFF);
+        EXPECT_EQ(less.get(lane), static_cast<int8_t>(x) < static_cast<int8_t>(y));
+        EXPECT_EQ(shifted.get(lane), static_cast<uint8_t>(static_cast<int8_t>(x) >> s));
+        EXPECT_EQ(bit.get(lane), (x >> s) & 1);
+        EXPECT_EQ(wide.get(lane), (((x >> 4) & 0xF) << 8) | y);
+    }
+
+    // the index can't reach every bit of a wider value, e.g. logic [15:0] c; c[idx] with a 3-bit
+    // idx. bits beyond the index range must not alias to the lower ones
+    Lanes<16> c;
+    for (uint64_t lane = 0; lane < num_lanes; lane++) {
+        c.set(lane, 0xFF00 | (lane & 0xFF));
+    }
+    auto low = select<0>(c, amount);
+    // logic [17:2], where idx 0 and 1 are out of range
+    auto shifted_low = select<2>(c, amount);
+    // logic [11:-4], where the lowest 4 bits can't be reached by the index
+    auto negative_low = select<-4>(c, amount);
+    for (uint64_t lane = 0; lane < num_lanes; lane++) {
+        auto x = 0xFF00 | (lane & 0xFF), s = lane % 8;
+        EXPECT_EQ(low.get(lane), (x >> s) & 1);
+        EXPECT_EQ(shifted_low.get(lane), s >= 2 ? (x >> (s - 2)) & 1 : 0);
+        EXPECT_EQ(negative_low.get(lane), (x >> (s + 4)) & 1);
+    }
+}
+
+TEST(lanes, predicated_assign) {  // NOLINT
+    using namespace fsim::runtime::lanes;
+    auto a = Lanes<4>::constant(5);
+    auto changed = assign(a, 0xF0, Lanes<4>::constant(10));
+    EXPECT_TRUE(changed);
+    changed = assign<2>(a, 0xF0, Lanes<2>::constant(3));
+    EXPECT_TRUE(changed);
+    changed = assign(a, 0, Lanes<4>{});
+    EXPECT_FALSE(changed);
+    for (uint64_t lane = 0; lane < num_lanes; lane++) {
+        EXPECT_EQ(a.get(lane), (lane >= 4 && lane < 8) ? 14u : 5u);
+    }
+}
+
+class DumpModule : public Module {
+public:
+    DumpModule() : Module("dump") {}
+    bit_t<0> a;
+    logic_t<3, 0> b;
+
+    void dump_vars(Dumper *dumper, uint64_t) override {
+        dumper->add_var(a, "a");
+        dumper->add_var(b, "b");
+    }
+};
+
+TEST(runtime, dump_vars) {  // NOLINT
+    uint64_t time = 0;
+    DumpModule m;
+    {
+        Dumper dumper(&time);
+        dumper.set_filename("test_dump_vars.vcd");
+        dumper.add_scope(&m, "top.dump", 0);
+        dumper.end_time_step(time);
+        time = 5;
+        m.a = 1_bit;
+        m.b = 2_logic;
+        dumper.end_time_step(time);
+        time = 10;
+        // the same value at the end of the time step is not a change
+        m.a = 0_bit;
+        m.a = 1_bit;
+        dumper.dump_off();
+        dumper.end_time_step(time);
+        dumper.close(time);
+    }
+    std::ifstream stream("test_dump_vars.vcd");
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    auto content = ss.str();
+    EXPECT_NE(content.find("$scope module top $end\n$scope module dump $end"), std::string::npos);
+    EXPECT_NE(content.find("$var wire 1 ! a $end"), std::string::npos);
+    EXPECT_NE(content.find("$var wire 4 \" b $end"), std::string::npos);
+    EXPECT_NE(content.find("#5\n1!\n"), std::string::npos);
+    EXPECT_NE(content.find("#10\n$dumpoff\nx!\n"), std::string::npos);
+}
+
+TEST(runtime, compact_wave) {  // NOLINT
+    {
+        // small blocks so that reads go across block boundaries
+        CompactWaveWriter writer("test_compact_wave.fwv", 4);
+        writer.write_header({{"top", "a", 1}, {"top.dump", "b", 4}}, 0, {"0", "x"});
+        writer.end_time_step(0);
+        for (uint64_t time = 1; time <= 100; time++) {
+            writer.write_change(time, 0, time % 2 ? "1" : "0");
+            if (time % 10 == 0) writer.write_change(time, 1, time == 50 ? "z" : "101");
+            writer.end_time_step(time);
+        }
+        writer.write_dump_off(100);
+        writer.end_time_step(100);
+        writer.close();
+    }
+    WaveReader reader("test_compact_wave.fwv");
+    EXPECT_EQ(reader.signals().size(), 2);
+    EXPECT_EQ(reader.end_time(), 100);
+    auto a = reader.find("top.a");
+    auto b = reader.find("top.dump.b");
+    EXPECT_TRUE(a);
+    EXPECT_TRUE(b);
+    EXPECT_FALSE(reader.find("top.b"));
+
+    EXPECT_EQ(reader.value_at(*b, 5), "xxxx");
+    EXPECT_EQ(reader.value_at(*b, 10), "0101");
+    EXPECT_EQ(reader.value_at(*b, 55), "zzzz");
+    EXPECT_EQ(reader.value_at(*a, 33), "1");
+    EXPECT_EQ(reader.value_at(*a, 100), "x");
+
+    auto values = reader.read(*b, 45, 60);
+    EXPECT_EQ(values.size(), 3);
+    EXPECT_EQ(values[0].first, 45);
+    EXPECT_EQ(values[0].second, "0101");
+    EXPECT_EQ(values[1].first, 50);
+    EXPECT_EQ(values[1].second, "zzzz");
+    EXPECT_EQ(values[2].first, 60);
+    EXPECT_EQ(values[2].second, "0101");
+}
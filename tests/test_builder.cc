@@ -1,3 +1,7 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
 #include "../src/builder/builder.hh"
 #include "gtest/gtest.h"
 #include "slang/compilation/Compilation.h"
@@ -28,3 +32,193 @@ endmodule
     std::string output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find("HELLO WORLD"), std::string::npos);
 }
+
+std::string read_file(const std::filesystem::path &filename) {
+    std::ifstream stream(filename);
+    std::stringstream content;
+    content << stream.rdbuf();
+    return content.str();
+}
+
+void build_design(const std::string &src, const std::string &working_dir) {
+    auto tree = SyntaxTree::fromText(src);
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.working_dir = working_dir;
+    Builder builder(options);
+    builder.build(&compilation);
+}
+
+TEST(builder, object_cache) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child;
+initial begin
+    $display("HELLO CACHE");
+end
+endmodule
+
+module top;
+child inst();
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    auto cache_dir = std::filesystem::temp_directory_path() / "fsim_test_object_cache";
+    std::filesystem::remove_all(cache_dir);
+
+    for (auto const *working_dir : {"fsim_cache_dir_1", "fsim_cache_dir_2"}) {
+        BuildOptions options;
+        options.working_dir = working_dir;
+        options.cache_dir = cache_dir.string();
+        options.run_after_build = true;
+        Builder builder(options);
+        testing::internal::CaptureStdout();
+        builder.build(&compilation);
+        std::string output = testing::internal::GetCapturedStdout();
+        EXPECT_NE(output.find("HELLO CACHE"), std::string::npos);
+    }
+
+    // nothing is compiled in the second working directory
+    auto content = read_file(std::filesystem::path("fsim_cache_dir_2") / "build.ninja");
+    EXPECT_EQ(content.find(": cc "), std::string::npos);
+    EXPECT_NE(content.find(cache_dir.string()), std::string::npos);
+
+    std::filesystem::remove_all(cache_dir);
+}
+
+TEST(builder, incremental) {  // NOLINT
+    auto constexpr child = R"(
+module child;
+initial begin
+    $display("HELLO CHILD");
+end
+endmodule
+)";
+    auto constexpr top = R"(
+module top;
+child inst();
+endmodule
+)";
+    auto constexpr working_dir = "fsim_incremental_dir";
+    std::filesystem::remove_all(working_dir);
+    auto child_filename = std::filesystem::path(working_dir) / "child.cc";
+
+    build_design(std::string(child) + top, working_dir);
+    {
+        std::ofstream stream(child_filename, std::ios::app);
+        stream << "// unchanged" << std::endl;
+    }
+    // only the top module is generated again
+    auto constexpr new_top = R"(
+module top;
+logic a;
+child inst();
+endmodule
+)";
+    build_design(std::string(child) + new_top, working_dir);
+    EXPECT_NE(read_file(child_filename).find("// unchanged"), std::string::npos);
+
+    auto constexpr new_child = R"(
+module child;
+initial begin
+    $display("HELLO NEW CHILD");
+end
+endmodule
+)";
+    build_design(std::string(new_child) + new_top, working_dir);
+    EXPECT_EQ(read_file(child_filename).find("// unchanged"), std::string::npos);
+    EXPECT_NE(read_file(child_filename).find("HELLO NEW CHILD"), std::string::npos);
+}
+
+TEST(builder, precompiled_header) {  // NOLINT
+    auto constexpr working_dir = "fsim_pch_dir";
+    build_design(R"(
+module m;
+initial begin
+    $display("HELLO PCH");
+end
+endmodule
+)",
+                 working_dir);
+    std::filesystem::path dir = working_dir;
+    EXPECT_TRUE(std::filesystem::exists(dir / "fsim_prelude.hh.gch"));
+    EXPECT_NE(read_file(dir / "build.ninja").find("-include fsim_prelude.hh"), std::string::npos);
+}
+
+TEST(builder, translation_units) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child1;
+initial begin
+    $display("HELLO CHILD1");
+end
+endmodule
+
+module child2;
+initial begin
+    $display("HELLO CHILD2");
+end
+endmodule
+
+module top;
+logic [3:0] a, b;
+child1 inst1();
+child2 inst2();
+initial begin
+    a = 1;
+    $display("HELLO A %0d", a);
+end
+initial begin
+    b = 2;
+    $display("HELLO B %0d", b);
+end
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.working_dir = "fsim_tu_dir";
+    options.run_after_build = true;
+    // each initial block of top costs 2, while the children cost 1
+    options.tu_complexity = 2;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    for (auto const *str : {"HELLO CHILD1", "HELLO CHILD2", "HELLO A 1", "HELLO B 2"}) {
+        EXPECT_NE(output.find(str), std::string::npos);
+    }
+
+    std::filesystem::path dir = options.working_dir;
+    EXPECT_TRUE(std::filesystem::exists(dir / "top.1.cc"));
+    EXPECT_TRUE(std::filesystem::exists(dir / "top.2.cc"));
+    EXPECT_FALSE(std::filesystem::exists(dir / "top.3.cc"));
+    auto ninja = read_file(dir / "build.ninja");
+    EXPECT_NE(ninja.find("module.jumbo1.cc"), std::string::npos);
+    EXPECT_EQ(ninja.find("child1.cc"), std::string::npos);
+}
+
+TEST(builder, generated_code) {  // NOLINT
+    auto constexpr src = R"(
+module m;
+initial begin
+    $display("HELLO STAMP");
+end
+endmodule
+)";
+    auto constexpr working_dir = "fsim_stamp_dir";
+    std::filesystem::remove_all(working_dir);
+    build_design(src, working_dir);
+    auto filename = std::filesystem::path(working_dir) / "m.cc";
+    auto content = read_file(filename);
+    EXPECT_EQ(content.rfind("// fsim ", 0), 0);
+    // indented without clang-format
+    EXPECT_NE(content.find("\n    "), std::string::npos);
+
+    // build.ninja is generated in every build, but left as is when the content is the same
+    auto ninja_filename = std::filesystem::path(working_dir) / "build.ninja";
+    EXPECT_EQ(read_file(ninja_filename).rfind("# fsim ", 0), 0);
+    auto time = std::filesystem::last_write_time(ninja_filename);
+    build_design(src, working_dir);
+    EXPECT_EQ(std::filesystem::last_write_time(ninja_filename), time);
+}
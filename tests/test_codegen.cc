@@ -1,4 +1,8 @@
+#include <filesystem>
+#include <fstream>
+
 #include "../src/builder/builder.hh"
+#include "../src/builder/util.hh"
 #include "gtest/gtest.h"
 #include "slang/compilation/Compilation.h"
 #include "slang/syntax/SyntaxTree.h"
@@ -195,6 +199,192 @@ endmodule
     EXPECT_NE(output.find("a=3 c=4"), std::string::npos);
 }
 
+TEST(code, always_assign_levelized) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module m;
+logic [3:0] a, b, c, d;
+always_comb begin
+    a = b + 1;
+end
+assign c = a + 2;
+assign d = c + b;
+
+initial begin
+    b = 1;
+    #1;
+    $display("a=%0d c=%0d d=%0d", a, c, d);
+    #1;
+    b = 2;
+    #1;
+    $display("a=%0d c=%0d d=%0d", a, c, d);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.levelize_comb = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("a=2 c=4 d=5"), std::string::npos);
+    EXPECT_NE(output.find("a=3 c=5 d=7"), std::string::npos);
+}
+
+TEST(code, always_assign_parallel) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child (
+    input logic[3:0] in,
+    output logic[3:0] out);
+always_comb out = in + 1;
+endmodule
+module m;
+logic [3:0] a, b, c, d, e, f;
+always_comb b = a + 1;
+always_comb c = a + 2;
+always_comb d = b + c;
+
+child inst1 (.in(a), .out(e));
+child inst2 (.in(b), .out(f));
+
+initial begin
+    a = 1;
+    #1;
+    $display("d=%0d e=%0d f=%0d", d, e, f);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.levelize_comb = true;
+    options.parallel_comb = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("d=5 e=2 f=3"), std::string::npos);
+}
+
+TEST(code, always_assign_parallel_select) {  // NOLINT
+    // both processes write to a, so they can't be evaluated in parallel
+    auto tree = SyntaxTree::fromText(R"(
+module m;
+logic [3:0] a;
+logic [1:0] x, y;
+assign a[1:0] = x;
+assign a[3:2] = y;
+
+initial begin
+    x = 2'b01;
+    y = 2'b10;
+    #1;
+    $display("a=%b", a);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.levelize_comb = true;
+    options.parallel_comb = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("a=1001"), std::string::npos);
+}
+
+TEST(code, always_assign_dirty_propagation) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child (
+    input logic[3:0] in,
+    output logic[3:0] out);
+always_comb out = in + 1;
+endmodule
+module m;
+logic [3:0] a, b, c, d;
+always_comb b = a + 1;
+assign c = b + a;
+
+child inst (.in(c), .out(d));
+
+initial begin
+    a = 1;
+    a = 2;
+    #1;
+    $display("b=%0d c=%0d d=%0d", b, c, d);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.dirty_propagation = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("b=3 c=5 d=6"), std::string::npos);
+}
+
+TEST(code, always_assign_dirty_propagation_parallel) {  // NOLINT
+    // each child has two levels, which only see each other through the dirty bits
+    auto tree = SyntaxTree::fromText(R"(
+module child (
+    input logic[3:0] in,
+    output logic[3:0] out);
+logic [3:0] tmp;
+always_comb tmp = in + 1;
+always_comb out = tmp + 1;
+endmodule
+module m;
+logic [3:0] a, b, c, d;
+always_comb b = a + 1;
+
+child inst1 (.in(a), .out(c));
+child inst2 (.in(b), .out(d));
+
+initial begin
+    a = 1;
+    #1;
+    $display("c=%0d d=%0d", c, d);
+    a = 4;
+    #1;
+    $display("c=%0d d=%0d", c, d);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.levelize_comb = true;
+    options.parallel_comb = true;
+    options.dirty_propagation = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("c=3 d=4"), std::string::npos);
+    EXPECT_NE(output.find("c=6 d=7"), std::string::npos);
+}
+
 TEST(code, always_ff_single_trigger) {  // NOLINT
     auto tree = SyntaxTree::fromText(R"(
 module m;
@@ -277,6 +467,140 @@ endmodule
     EXPECT_NE(output.find("a=2 b=1\na=3 b=3"), std::string::npos);
 }
 
+TEST(code, always_ff_nba_select) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module m;
+logic [3:0] a, b;
+logic clk;
+
+always_ff @(posedge clk) begin
+    b[1:0] <= a[1:0];
+    b[3] <= 1'b1;
+    b[2] <= 1'b0;
+end
+
+initial begin
+    clk = 0;
+    a = 4'b0110;
+    #1;
+    clk = 1;
+    #1;
+    $display("b=%0d", b);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("b=10\n"), std::string::npos);
+}
+
+TEST(code, always_ff_nba_dynamic_select) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module m;
+logic [7:0] mem[300];
+logic [8:0] idx;
+logic clk;
+
+always_ff @(posedge clk) begin
+    for (int i = 0; i < 300; i++) mem[i] <= i;
+    idx <= idx + 1;
+end
+
+always_ff @(posedge clk) begin
+    mem[0] <= 8'd42;
+end
+
+initial begin
+    clk = 0;
+    idx = 0;
+    #1;
+    clk = 1;
+    #1;
+    $display("mem[0]=%0d mem[299]=%0d idx=%0d", mem[0], mem[299], idx);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("mem[0]=42 mem[299]=43 idx=1"), std::string::npos);
+
+    // the select index is evaluated when the NBA is committed, so it has no known target
+    std::ifstream stream("fsim_dir/m.cc");
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    auto content = ss.str();
+    EXPECT_NE(content.find("), nullptr, ("), std::string::npos);
+}
+
+TEST(code, always_ff_batch) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module m;
+logic [3:0] a, b, c, d;
+logic clk, rst_n;
+
+always_ff @(posedge clk, negedge rst_n) begin
+    if (!rst_n) b <= 0;
+    else b <= a;
+end
+
+always_ff @(negedge rst_n, posedge clk) begin
+    if (!rst_n) c <= 0;
+    else c <= b;
+end
+
+always_ff @(posedge clk) begin
+    d <= c;
+end
+
+initial begin
+    clk = 0;
+    rst_n = 1;
+    a = 1;
+    #1;
+    rst_n = 0;
+    #1;
+    rst_n = 1;
+    #1;
+    clk = 1;
+    #1;
+    clk = 0;
+    #1;
+    clk = 1;
+    #1;
+    $display("b=%0d c=%0d d=%0d", b, c, d);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.batch_ff = true;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("b=1 c=1 d=0\n"), std::string::npos);
+}
+
 TEST(code, loop) {  // NOLINT
     auto tree = SyntaxTree::fromText(R"(
 module m;
@@ -343,6 +667,58 @@ endmodule
     EXPECT_NE(output.find("b=3\n"), std::string::npos);
 }
 
+TEST(code, child_instance_inline) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child (
+    input logic clk,
+    input logic[5:0] in,
+    output logic[5:0] out);
+logic[5:0] tmp;
+
+always_comb tmp = in + 1;
+always_ff @(posedge clk)
+    out <= tmp;
+endmodule
+module m;
+logic clk;
+logic[5:0] in, out, a, b;
+
+child inst (.*);
+
+assign in = a + 1;
+assign b = out + 1;
+initial begin
+    clk = 0;
+    a = 1;
+    #1;
+    clk = 1;
+    #1;
+    $display("b=%0d", b);
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.inline_threshold = 10;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("b=4\n"), std::string::npos);
+
+    // the child variables are members of the parent, which doesn't hold a child object
+    std::ifstream stream("fsim_dir/m.hh");
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    auto content = ss.str();
+    EXPECT_NE(content.find(" inst_tmp;"), std::string::npos);
+    EXPECT_EQ(content.find("std::shared_ptr<fsim::child>"), std::string::npos);
+}
+
 TEST(code, repeat) {  // NOLINT
     auto tree = SyntaxTree::fromText(R"(
 module m;
@@ -787,6 +1163,106 @@ endmodule
     EXPECT_NE(output.find("c = 255"), std::string::npos);
 }
 
+TEST(code, expr_two_state) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module top;
+
+logic [7:0] a, b, c, d;
+logic signed [7:0] e;
+logic f, g;
+initial begin
+   a = 8'd200;
+   b = 8'd100;
+   c = a + b;
+   d = {a[3:0], b[3:0]} ^ 8'h0F;
+   e = -8'sd3;
+   f = e < 8'sd1;
+   g = ^a;
+   $display("c=%0d d=%0d e=%0d f=%0d g=%0d", c, d, e, f, g);
+end
+
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.use_4state = false;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("c=44 d=139 e=-3 f=1 g=1"), std::string::npos);
+}
+
+TEST(code, expr_two_state_wide) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module top;
+
+logic [255:0] a, b, c, d, e;
+logic f, g, h;
+initial begin
+   a = {192'h0, 64'hFFFFFFFFFFFFFFFF};
+   b = 256'h1;
+   c = a + b;
+   d = ~(c ^ a);
+   e = c << 100;
+   f = c == (a + 1);
+   g = &d;
+   h = |(e >> 164);
+   $display("c=%0h d=%0h f=%0d g=%0d h=%0d", c, d[71:64], f, g, h);
+end
+
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.use_4state = false;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("c=10000000000000000 d=fe f=1 g=0 h=1"), std::string::npos);
+}
+
+TEST(code, expr_two_state_wide_literal) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module top;
+
+logic [255:0] a, c;
+logic f;
+initial begin
+   a = {192'h0, 64'hFFFFFFFFFFFFFFFF};
+   c = a + 256'h1_0000000000000000;
+   f = c == 256'h1_FFFFFFFFFFFFFFFF;
+   $display("c=%0h f=%0d", c, f);
+end
+
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    options.use_4state = false;
+    Builder builder(options);
+    testing::internal::CaptureStdout();
+    builder.build(&compilation);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("c=1ffffffffffffffff f=1"), std::string::npos);
+}
+
 TEST(code, case_) {  // NOLINT
     auto tree = SyntaxTree::fromText(R"(
 module top;
@@ -828,3 +1304,191 @@ endmodule
     std::string output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find("b = 1\nb = 2\nb = 3"), std::string::npos);
 }
+
+// lines of the output that start with prefix
+std::vector<std::string> get_lines(const std::string &output, std::string_view prefix) {
+    std::vector<std::string> result;
+    std::stringstream stream(output);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.starts_with(prefix)) result.emplace_back(line);
+    }
+    return result;
+}
+
+TEST(code, lanes) {  // NOLINT
+    auto constexpr counter = R"(
+module counter(input logic clk, input logic rst_n, input logic [3:0] step,
+               output logic [3:0] count, output logic wrap);
+always_ff @(posedge clk, negedge rst_n) begin
+    if (!rst_n) count <= 0;
+    else count <= count + step;
+end
+assign wrap = count < step;
+endmodule
+)";
+
+    auto tree = SyntaxTree::fromText(counter);
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.lanes = true;
+    Builder builder(options);
+    builder.build(&compilation);
+    std::ifstream stream("fsim_dir/counter_lanes.hh");
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    auto content = ss.str();
+    EXPECT_NE(content.find("class counter"), std::string::npos);
+    EXPECT_NE(content.find("bool comb()"), std::string::npos);
+    // the asynchronous reset triggers the same block
+    EXPECT_NE(content.find("void posedge_clk("), std::string::npos);
+    EXPECT_NE(content.find("void negedge_rst_n("), std::string::npos);
+
+    // lane i counts with step i % 16 for 5 cycles, which has to match the scalar simulation
+    {
+        std::ofstream driver("fsim_dir/lanes_driver.cc", std::ios::trunc);
+        driver << R"(#include <iostream>
+
+#include "counter_lanes.hh"
+
+int main() {
+    using namespace fsim::runtime::lanes;
+    fsim::lanes::counter dut;
+    for (uint64_t lane = 0; lane < num_lanes; lane++) {
+        dut.step.set(lane, lane % 16);
+    }
+    dut.rst_n = Lanes<1>::constant(0);
+    dut.negedge_rst_n();
+    dut.rst_n = Lanes<1>::constant(1);
+    dut.comb();
+    uint64_t counts[5][num_lanes], wraps[5][num_lanes];
+    for (auto cycle = 0; cycle < 5; cycle++) {
+        dut.posedge_clk();
+        for (uint64_t lane = 0; lane < num_lanes; lane++) {
+            counts[cycle][lane] = dut.count.get(lane);
+            wraps[cycle][lane] = dut.wrap.get(lane);
+        }
+    }
+    for (uint64_t lane = 0; lane < num_lanes; lane++) {
+        for (auto cycle = 0; cycle < 5; cycle++) {
+            std::cout << "step=" << lane % 16 << " count=" << counts[cycle][lane]
+                      << " wrap=" << wraps[cycle][lane] << std::endl;
+        }
+    }
+}
+)";
+    }
+    auto dir = std::filesystem::absolute("fsim_dir");
+    auto driver_path = (dir / "lanes_driver").string();
+    auto status = platform::run(
+        {"c++", "-std=c++20", "-Iinclude", "lanes_driver.cc", "-o", driver_path}, dir.string());
+    ASSERT_EQ(status, 0);
+    std::string lanes_output;
+    status = platform::run({driver_path}, dir.string(), lanes_output);
+    ASSERT_EQ(status, 0);
+
+    auto scalar_tree = SyntaxTree::fromText(std::string(counter) + R"(
+module top;
+logic clk, rst_n, wrap;
+logic [3:0] step, count;
+counter dut(.*);
+initial begin
+    for (int s = 0; s < 16; s++) begin
+        step = s;
+        clk = 0;
+        rst_n = 0;
+        #1 rst_n = 1;
+        for (int i = 0; i < 5; i++) begin
+            #1 clk = 1;
+            #1 clk = 0;
+            $display("step=%0d count=%0d wrap=%0d", step, count, wrap);
+        end
+    end
+end
+endmodule
+)");
+    Compilation scalar_compilation;
+    scalar_compilation.addSyntaxTree(scalar_tree);
+    BuildOptions scalar_options;
+    scalar_options.working_dir = "fsim_lanes_scalar_dir";
+    scalar_options.optimization_level = optimization_level;
+    scalar_options.run_after_build = true;
+    scalar_options.use_4state = false;
+    Builder scalar_builder(scalar_options);
+    testing::internal::CaptureStdout();
+    scalar_builder.build(&scalar_compilation);
+    std::string scalar_output = testing::internal::GetCapturedStdout();
+
+    auto scalar_lines = get_lines(scalar_output, "step=");
+    EXPECT_EQ(scalar_lines.size(), 16 * 5);
+    // the 64 lanes repeat the 16 steps
+    std::vector<std::string> expected;
+    for (auto i = 0; i < 4; i++) {
+        expected.insert(expected.end(), scalar_lines.begin(), scalar_lines.end());
+    }
+    EXPECT_EQ(get_lines(lanes_output, "step="), expected);
+}
+
+TEST(code, dumpvars) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child(input logic clk, output logic [3:0] count);
+always_ff @(posedge clk) count <= count + 1;
+endmodule
+
+module top;
+logic clk;
+logic [3:0] count;
+child inst(.clk(clk), .count(count));
+
+initial begin
+    $dumpfile("dumpvars.vcd");
+    $dumpvars;
+    clk = 0;
+    for (int i = 0; i < 4; i++) begin
+        #5 clk = ~clk;
+    end
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    Builder builder(options);
+    builder.build(&compilation);
+    std::ifstream stream("fsim_dir/dumpvars.vcd");
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    auto content = ss.str();
+    EXPECT_NE(content.find("$scope module top $end"), std::string::npos);
+    EXPECT_NE(content.find("$scope module inst $end"), std::string::npos);
+    EXPECT_NE(content.find("$enddefinitions $end"), std::string::npos);
+    EXPECT_NE(content.find("#5\n"), std::string::npos);
+    EXPECT_NE(content.find("#20\n"), std::string::npos);
+}
+
+TEST(code, save) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module top;
+logic [3:0] a;
+initial begin
+    a = 1;
+    #10 a = 2;
+    $save("save.ckpt");
+    #5 a = 3;
+end
+endmodule
+)");
+
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    BuildOptions options;
+    options.optimization_level = optimization_level;
+    options.run_after_build = true;
+    Builder builder(options);
+    builder.build(&compilation);
+    EXPECT_TRUE(std::filesystem::exists("fsim_dir/save.ckpt"));
+}
@@ -71,6 +71,33 @@ endmodule
     EXPECT_EQ(m.ff_processes[2]->edges.size(), 2);
     EXPECT_EQ(m.ff_processes[2]->edges[1].first, slang::EdgeKind::NegEdge);
     EXPECT_EQ(m.ff_processes[2]->edges[0].second->name, "a");
+    // no timing control inside
+    EXPECT_NE(m.ff_processes[0]->body, nullptr);
+}
+
+TEST(ir, always_ff_timing_control) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module m;
+logic a, b, c;
+always_ff @(posedge c) begin
+    a <= b;
+end
+always @(posedge c) begin
+    #1 a = b;
+end
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    ModuleDefinitionVisitor vis;
+    compilation.getRoot().visit(vis);
+    auto *def = vis.modules.at("m");
+    Module m(def);
+    m.analyze();
+
+    EXPECT_EQ(m.ff_processes.size(), 2);
+    EXPECT_NE(m.ff_processes[0]->body, nullptr);
+    EXPECT_EQ(m.ff_processes[1]->body, nullptr);
 }
 
 TEST(ir, child_inst) {  // NOLINT
@@ -96,6 +123,88 @@ endmodule
     EXPECT_EQ(child->outputs.size(), 1);
 }
 
+TEST(ir, child_inst_shared_def) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child (input logic a, output logic b);
+assign b = a;
+endmodule
+module m;
+logic a, b, c;
+child inst1 (.a(a), .b(b));
+child inst2 (.a(b), .b(c));
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    ModuleDefinitionVisitor vis;
+    compilation.getRoot().visit(vis);
+    auto *def = vis.modules.at("m");
+    Module m(def);
+    m.analyze();
+
+    // each instance keeps its own port connections
+    auto const &inst1 = m.child_instances.at("inst1");
+    auto const &inst2 = m.child_instances.at("inst2");
+    EXPECT_NE(inst1.get(), inst2.get());
+    EXPECT_EQ(inst1->inputs[0].second->syntax->toString(), "a");
+    EXPECT_EQ(inst2->inputs[0].second->syntax->toString(), "b");
+    // but they share one definition
+    EXPECT_EQ(m.get_defs().size(), 2);
+}
+
+TEST(ir, child_inst_inlinable) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child (input logic a, b, output logic c);
+assign c = a & b;
+endmodule
+module m;
+logic a, b, c;
+child inst (.*);
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    ModuleDefinitionVisitor vis;
+    compilation.getRoot().visit(vis);
+    auto *def = vis.modules.at("m");
+    Module m(def);
+    m.analyze();
+
+    auto const &child = m.child_instances.at("inst");
+    EXPECT_EQ(child->complexity(), 1);
+    EXPECT_TRUE(child->inlinable(1));
+    EXPECT_FALSE(child->inlinable(0));
+    // only leaf modules can be inlined
+    EXPECT_FALSE(m.inlinable(100));
+}
+
+TEST(ir, port_aliases) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module child (input logic[3:0] a, b, c, output logic[3:0] d);
+assign d = a & b & c;
+endmodule
+module m;
+logic[3:0] a, d;
+logic[1:0] b;
+child inst (.a(a), .b(b), .c(a + 1), .d(d));
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    ModuleDefinitionVisitor vis;
+    compilation.getRoot().visit(vis);
+    auto *def = vis.modules.at("m");
+    Module m(def);
+    m.analyze();
+
+    auto const &child = m.child_instances.at("inst");
+    auto aliases = child->get_port_aliases();
+    // b has a different width and c is connected to an expression
+    EXPECT_EQ(aliases.size(), 2);
+    EXPECT_EQ(aliases.at(child->port_vars.at("a"))->name, "a");
+    EXPECT_EQ(aliases.at(child->port_vars.at("d"))->name, "d");
+}
+
 TEST(ir, edge_control) {  // NOLINT
     auto tree = SyntaxTree::fromText(R"(
 module top;
@@ -117,3 +226,76 @@ endmodule
     auto const &init = m.init_processes[0];
     EXPECT_EQ(init->edge_event_controls.size(), 2);
 }
+
+TEST(ir, comb_levelized) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module top;
+logic a, b, c, d;
+assign b = a;
+always_comb c = b;
+always begin
+    #1 d = ~d;
+end
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    ModuleDefinitionVisitor vis;
+    compilation.getRoot().visit(vis);
+    auto *def = vis.modules.at("top");
+    Module m(def);
+    m.analyze();
+
+    EXPECT_EQ(m.comb_processes.size(), 3);
+    EXPECT_TRUE(m.comb_processes[0]->levelized);
+    EXPECT_TRUE(m.comb_processes[1]->levelized);
+    // general purpose always block has timing control
+    EXPECT_EQ(m.comb_processes[2]->kind, CombProcess::CombKind::GeneralPurpose);
+    EXPECT_FALSE(m.comb_processes[2]->levelized);
+}
+
+TEST(ir, comb_level) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module top;
+logic a, b, c, d;
+always_comb b = a;
+always_comb c = ~a;
+always_comb d = b & c;
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    ModuleDefinitionVisitor vis;
+    compilation.getRoot().visit(vis);
+    auto *def = vis.modules.at("top");
+    Module m(def);
+    m.analyze();
+
+    EXPECT_EQ(m.comb_processes.size(), 3);
+    // b and c only depend on a
+    EXPECT_EQ(m.comb_processes[0]->level, 0);
+    EXPECT_EQ(m.comb_processes[1]->level, 0);
+    EXPECT_EQ(m.comb_processes[2]->level, 1);
+}
+
+TEST(ir, comb_level_shared_write) {  // NOLINT
+    auto tree = SyntaxTree::fromText(R"(
+module top;
+logic [1:0] a;
+logic x, y;
+assign a[0] = x;
+assign a[1] = y;
+endmodule
+)");
+    Compilation compilation;
+    compilation.addSyntaxTree(tree);
+    ModuleDefinitionVisitor vis;
+    compilation.getRoot().visit(vis);
+    auto *def = vis.modules.at("top");
+    Module m(def);
+    m.analyze();
+
+    EXPECT_EQ(m.comb_processes.size(), 2);
+    // both write to a
+    EXPECT_NE(m.comb_processes[0]->level, m.comb_processes[1]->level);
+}
@@ -368,9 +368,37 @@ int driverMain(int argc, TArgs argv, bool suppressColorsStdout, bool suppressCol
     optional<uint32_t> optimizationLevel;
     optional<bool> runAfterCompilation;
     optional<bool> twoState;
+    optional<bool> levelizeComb;
+    optional<bool> parallelComb;
+    optional<bool> batchFF;
+    optional<uint64_t> inlineThreshold;
+    optional<bool> dirtyPropagation;
+    optional<bool> lanes;
+    optional<std::string> cacheDir;
+    optional<uint64_t> tuComplexity;
     cmdLine.add("-O", optimizationLevel, "Optimization level");
     cmdLine.add("-R,--run", runAfterCompilation, "Run after compilation");
     cmdLine.add("--two-state", twoState, "Turn on two-state simulation");
+    cmdLine.add("--levelize-comb", levelizeComb,
+                "Evaluate combinational logic without timing control in topological order");
+    cmdLine.add("--parallel-comb", parallelComb,
+                "Evaluate independent combinational logic and instances in parallel");
+    cmdLine.add("--batch-ff", batchFF,
+                "Merge always_ff blocks that share the same edges into a single process");
+    cmdLine.add("--inline-threshold", inlineThreshold,
+                "Inline child instances whose complexity is no more than the threshold",
+                "<threshold>");
+    cmdLine.add("--dirty-propagation", dirtyPropagation,
+                "Trigger combinational logic once per delta cycle from changed signals");
+    cmdLine.add("--lanes", lanes,
+                "Generate a class that simulates 64 copies of a 2-state design in bit lanes");
+    cmdLine.add("--cache-dir", cacheDir,
+                "Share compiled objects through the cache directory. Defaults to $FSIM_CACHE_DIR",
+                "<dir>");
+    cmdLine.add("--tu-complexity", tuComplexity,
+                "Split large modules and group small ones into translation units of about the "
+                "complexity",
+                "<complexity>");
 
     // File list
     optional<bool> singleUnit;
@@ -508,6 +536,7 @@ int driverMain(int argc, TArgs argv, bool suppressColorsStdout, bool suppressCol
 
     try {
         Compilation compilation(options);
+        fsim::add_system_tasks(compilation);
         anyErrors = !loadAllSources(compilation, sourceManager, buffers, options,
                                     singleUnit == true, false, libraryFiles, libDirs, libExts);
 
@@ -542,6 +571,30 @@ int driverMain(int argc, TArgs argv, bool suppressColorsStdout, bool suppressCol
             if (twoState) {
                 b_opt.use_4state = false;
             }
+            if (levelizeComb) {
+                b_opt.levelize_comb = true;
+            }
+            if (parallelComb) {
+                b_opt.parallel_comb = true;
+            }
+            if (batchFF) {
+                b_opt.batch_ff = true;
+            }
+            if (inlineThreshold) {
+                b_opt.inline_threshold = *inlineThreshold;
+            }
+            if (dirtyPropagation) {
+                b_opt.dirty_propagation = true;
+            }
+            if (lanes) {
+                b_opt.lanes = true;
+            }
+            if (cacheDir) {
+                b_opt.cache_dir = *cacheDir;
+            }
+            if (tuComplexity) {
+                b_opt.tu_complexity = *tuComplexity;
+            }
             b_opt.binary_name = outputName ? *outputName : fsim::default_output_name;
             b_opt.sv_libs = svLibs;
             b_opt.vpi_libs = vpiLibs;